@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+
+# Small-object allocation: abyss_db.al-style Entry structs, allocated in
+# batches of 1000 and freed in a scrambled order, so the allocator sees
+# churn rather than a clean LIFO pattern. Run by the VM and as a --native
+# binary. Pass a git revision to compare against (any revision before the
+# slab allocator measures glibc malloc):
+#   ./bench_alloc.sh           current tree
+#   ./bench_alloc.sh HEAD~1    current tree vs HEAD~1
+# N sets the number of batches (default 2000, i.e. 2M objects).
+
+set -e
+n=${N:-2000}
+
+make abyssc abyss_vm > /dev/null
+
+gen=$(mktemp --suffix=.al)
+cat > "$gen" <<AL
+struct Entry {
+    int key;
+    int value;
+    int state;
+}
+
+void main() {
+    Entry[] batch = new(Entry, 1000);
+    int round = 0;
+    int sum = 0;
+    while (round < $n) {
+        int i = 0;
+        while (i < 1000) {
+            Entry e = new(Entry);
+            e.key = round + i;
+            e.value = e.value + i;
+            batch[i] = e;
+            i = i + 1;
+        }
+        i = 0;
+        while (i < 1000) {
+            Entry e = batch[(i * 617) % 1000];
+            sum = sum + e.value;
+            free(e);
+            i = i + 1;
+        }
+        round = round + 1;
+    }
+    print(sum);
+}
+AL
+
+measure() {
+    "$2" "$gen" bench_alloc.aby > /dev/null
+    "$2" --native "$gen" bench_alloc_native > /dev/null 2>&1
+    for e in vm native; do
+        run="$3 bench_alloc.aby"
+        [ $e = native ] && run=./bench_alloc_native
+        t=$( { TIMEFORMAT='%R'; time $run > /dev/null; } 2>&1 )
+        r=$($run)
+        awk -v l="$1" -v e=$e -v t="$t" -v r="$r" -v n=$n \
+            'BEGIN { printf "  %-10s %-7s %6.2f s %7.1f M objects/s  result %s\n", l, e, t, n * 1000 / t / 1e6, r }'
+    done
+}
+
+echo
+echo "========================================"
+echo "   SMALL OBJECTS: $n x 1000 Entry"
+echo "========================================"
+
+if [ -n "$1" ]; then
+    base=$(mktemp -d)
+    git archive "$1" | tar -x -C "$base"
+    make -C "$base" abyssc abyss_vm > /dev/null
+    measure "$1" "$base/abyssc" "$base/abyss_vm"
+    rm -rf "$base"
+fi
+measure current ./abyssc ./abyss_vm
+
+rm -f "$gen" bench_alloc.aby bench_alloc_native
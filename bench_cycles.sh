@@ -0,0 +1,45 @@
+#!/usr/bin/env bash
+
+# Cycles per dispatched instruction in the stack VM. CPU time (user + sys,
+# so steal on shared machines does not count) comes from abyss_vm, the
+# instruction count from abyss_vm_count and the clock rate from /proc/cpuinfo. Pass a git revision to compare against the VM built from it
+# (it must read the same bytecode version):
+#   ./bench_cycles.sh           current tree
+#   ./bench_cycles.sh HEAD~1    current tree vs HEAD~1
+#   make bench-cycles BASE=HEAD~1
+
+set -e
+prog=${PROG:-compute.al}
+cflags=$(sed -n 's/^CFLAGS = //p' Makefile)
+mhz=$(awk -F: '/cpu MHz/ { print $2; exit }' /proc/cpuinfo)
+
+make abyssc abyss_vm abyss_vm_count > /dev/null
+./abyssc "$prog" bench_cycles.aby > /dev/null
+
+measure() {
+    t=$( { TIMEFORMAT='%U %S'; time "$2" bench_cycles.aby > /dev/null; } 2>&1 )
+    count=$("$3" bench_cycles.aby 2>&1 >/dev/null | awk '/\[dispatch\]/ {print $2}')
+    awk -v l="$1" -v t="$t" -v c="$count" -v m="$mhz" 'BEGIN {
+        split(t, u, " ")
+        t = u[1] + u[2]
+        printf "  %-10s %7.2f s %15.0f instr %7.2f ns/instr %7.2f cycles/instr\n",
+               l, t, c, t * 1e9 / c, t * m * 1e6 / c
+    }'
+}
+
+echo
+echo "========================================"
+echo "   CYCLES PER INSTRUCTION: $prog"
+echo "========================================"
+
+if [ -n "$1" ]; then
+    base=$(mktemp -d)
+    git archive "$1" vm.c include | tar -x -C "$base"
+    gcc $cflags -o "$base/abyss_vm" "$base/vm.c" -lm
+    gcc $cflags -DABYSS_COUNT_DISPATCH -o "$base/abyss_vm_count" "$base/vm.c" -lm
+    measure "$1" "$base/abyss_vm" "$base/abyss_vm_count"
+    rm -rf "$base"
+fi
+measure current ./abyss_vm ./abyss_vm_count
+
+rm -f bench_cycles.aby
@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+
+# Superinstruction report: instructions dispatched by abyss_vm with and
+# without the peephole fusion pass (abyssc --no-fuse).
+
+make abyssc abyss_vm_count > /dev/null
+
+echo
+echo "========================================"
+echo "   DISPATCH COUNT: FUSED vs UNFUSED"
+echo "========================================"
+
+for prog in compute.al prime_race.al; do
+    name=$(basename "$prog" .al)
+    ./abyssc --no-fuse "$prog" "${name}_plain.aby" > /dev/null
+    ./abyssc "$prog" "${name}_fused.aby" > /dev/null
+
+    plain=$(./abyss_vm_count "${name}_plain.aby" 2>&1 >/dev/null | awk '/\[dispatch\]/ {print $2}')
+    fused=$(./abyss_vm_count "${name}_fused.aby" 2>&1 >/dev/null | awk '/\[dispatch\]/ {print $2}')
+
+    echo
+    echo "--- $prog ---"
+    printf "  unfused : %15d dispatches\n" "$plain"
+    printf "  fused   : %15d dispatches\n" "$fused"
+    awk -v p="$plain" -v f="$fused" 'BEGIN { printf "  saved   : %14.1f%%\n", 100 * (p - f) / p }'
+
+    rm -f "${name}_plain.aby" "${name}_fused.aby"
+done
@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+
+# Interpreter vs template JIT vs native AOT: CPU time (user + sys) of the
+# same program under abyss_vm, abyss_vm --jit and abyssc --native.
+#   ./bench_jit.sh                 default workloads
+#   ./bench_jit.sh prog.al ...     your own
+
+make abyssc abyss_vm > /dev/null
+
+progs=("$@")
+[ ${#progs[@]} -eq 0 ] && progs=(compute.al prime_race.al benchmark.al physics.al)
+
+cpu() {
+    { TIMEFORMAT='%U %S'; time "$@" > /dev/null 2>&1; } 2>&1 |
+        awk '{ printf "%.2fs", $1 + $2 }'
+}
+
+echo
+echo "========================================"
+echo "   INTERPRETER vs JIT vs NATIVE"
+echo "========================================"
+printf "\n  %-18s %10s %10s %10s\n" program vm "vm --jit" native
+
+for prog in "${progs[@]}"; do
+    name=$(basename "$prog" .al)
+    ./abyssc "$prog" "${name}_jit.aby" > /dev/null || continue
+    vm=$(cpu ./abyss_vm "${name}_jit.aby")
+    jit=$(cpu ./abyss_vm --jit "${name}_jit.aby")
+    native=n/a
+    if ./abyssc --native "$prog" "${name}_jit_native" > /dev/null 2>&1; then
+        native=$(cpu "./${name}_jit_native")
+    fi
+    printf "  %-18s %10s %10s %10s\n" "$prog" "$vm" "$jit" "$native"
+    rm -f "${name}_jit.aby" "${name}_jit_native"
+done
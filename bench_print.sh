@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+
+# Output throughput: a loop printing N lines each of ints, floats, strings
+# and format strings, run by the VM and as a --native binary with stdout
+# going to a file. Pass a git revision to compare against (any revision
+# before the output buffer shows the old printf path):
+#   ./bench_print.sh           current tree
+#   ./bench_print.sh HEAD~1    current tree vs HEAD~1
+# N sets the lines per kind (default 2000000).
+
+set -e
+n=${N:-2000000}
+
+make abyssc abyss_vm > /dev/null
+
+gen=$(mktemp --suffix=.al)
+out=$(mktemp)
+cat > "$gen" <<AL
+void main() {
+    int i = 0;
+    while (i < $n) {
+        print(i * 7919 - 123456789);
+        i = i + 1;
+    }
+    i = 0;
+    float x = -1000.0;
+    while (i < $n) {
+        print(x);
+        x = x + 0.0137;
+        i = i + 1;
+    }
+    i = 0;
+    while (i < $n) {
+        print("the quick brown fox jumps over the lazy dog");
+        i = i + 1;
+    }
+    i = 0;
+    while (i < $n) {
+        print("row %int: %float", i, x);
+        i = i + 1;
+    }
+}
+AL
+
+measure() {
+    "$2" "$gen" bench_print.aby > /dev/null
+    "$2" --native "$gen" bench_print_native > /dev/null 2>&1
+    for e in vm native; do
+        run="$3 bench_print.aby"
+        [ $e = native ] && run=./bench_print_native
+        t=$( { TIMEFORMAT='%R'; time $run > "$out"; } 2>&1 )
+        b=$(stat -c %s "$out")
+        sum=$(md5sum < "$out" | cut -c1-12)
+        awk -v l="$1" -v e=$e -v t="$t" -v b="$b" -v m="$sum" \
+            'BEGIN { printf "  %-10s %-7s %6.2f s %7.1f MB/s  md5 %s\n", l, e, t, b / t / 1e6, m }'
+    done
+}
+
+echo
+echo "========================================"
+echo "   OUTPUT THROUGHPUT: 4 x $n lines"
+echo "========================================"
+
+if [ -n "$1" ]; then
+    base=$(mktemp -d)
+    git archive "$1" | tar -x -C "$base"
+    make -C "$base" abyssc abyss_vm > /dev/null
+    measure "$1" "$base/abyssc" "$base/abyss_vm"
+    rm -rf "$base"
+fi
+measure current ./abyssc ./abyss_vm
+
+rm -f "$gen" "$out" bench_print.aby bench_print_native
@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+
+# Stack VM vs register VM: wall time and instructions dispatched for the same
+# programs compiled to both bytecode formats (abyssc --register).
+
+make abyssc abyss_vm abyss_vm_count > /dev/null
+
+echo
+echo "========================================"
+echo "   STACK VM vs REGISTER VM"
+echo "========================================"
+
+for prog in compute.al physics.al showcase_real.al; do
+    name=$(basename "$prog" .al)
+    ./abyssc "$prog" "${name}_stack.aby" > /dev/null
+    ./abyssc --register "$prog" "${name}_reg.aby" > /dev/null
+
+    echo
+    echo "--- $prog ---"
+    for fmt in stack reg; do
+        start=$(date +%s.%N)
+        ./abyss_vm "${name}_${fmt}.aby" > /dev/null
+        end=$(date +%s.%N)
+        count=$(./abyss_vm_count "${name}_${fmt}.aby" 2>&1 >/dev/null | awk '/\[dispatch\]/ {print $2}')
+        awk -v f="$fmt" -v s="$start" -v e="$end" -v c="$count" \
+            'BEGIN { printf "  %-6s: %8.2f s  %15.0f dispatches\n", f, e - s, c }'
+    done
+
+    rm -f "${name}_stack.aby" "${name}_reg.aby"
+done
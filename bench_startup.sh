@@ -0,0 +1,50 @@
+#!/usr/bin/env bash
+
+# VM startup time on a large generated program: many functions, string
+# literals and structs, and a main() that returns at once, so the run is all
+# loading. Each revision's VM runs bytecode from its own abyssc. Pass a git
+# revision to compare against:
+#   ./bench_startup.sh           current tree
+#   ./bench_startup.sh HEAD~1    current tree vs HEAD~1
+# FUNCS, STRUCTS and RUNS size the program and the number of timed runs.
+
+set -e
+funcs=${FUNCS:-20000}
+nstructs=${STRUCTS:-2000}
+runs=${RUNS:-20}
+
+make abyssc abyss_vm > /dev/null
+
+gen=$(mktemp --suffix=.al)
+awk -v f="$funcs" -v s="$nstructs" 'BEGIN {
+    for (i = 0; i < s; i++)
+        printf "struct S%d {\n    int a;\n    float b;\n}\n", i
+    for (i = 0; i < f; i++)
+        printf "int f%d(int x) {\n    print(\"function %d reporting a long enough message\");\n    return x + %d;\n}\n", i, i, i
+    print "void main() {\n}"
+}' > "$gen"
+
+measure() {
+    "$2" "$gen" bench_startup.aby > /dev/null
+    size=$(stat -c %s bench_startup.aby)
+    t=$( { TIMEFORMAT='%R'; time for ((r = 0; r < runs; r++)); do
+             "$3" bench_startup.aby > /dev/null; done; } 2>&1 )
+    awk -v l="$1" -v t="$t" -v r="$runs" -v b="$size" \
+        'BEGIN { printf "  %-10s %10d bytes %9.2f ms/run\n", l, b, t * 1000 / r }'
+}
+
+echo
+echo "========================================"
+echo "   VM STARTUP: $funcs functions, $nstructs structs"
+echo "========================================"
+
+if [ -n "$1" ]; then
+    base=$(mktemp -d)
+    git archive "$1" | tar -x -C "$base"
+    make -C "$base" abyssc abyss_vm > /dev/null
+    measure "$1" "$base/abyssc" "$base/abyss_vm"
+    rm -rf "$base"
+fi
+measure current ./abyssc ./abyss_vm
+
+rm -f "$gen" bench_startup.aby
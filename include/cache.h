@@ -0,0 +1,32 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+
+// Content-addressed cache of --native binaries. The key hashes the generated
+// C source, which is a pure function of the final bytecode, the string and
+// struct tables, the line table and the profiler flag, together with the gcc
+// command line and what it resolves to on this host (compiler version, the
+// CPU behind -march=native), so an unchanged program maps to the same entry
+// and a shared cache never serves a binary built for another machine.
+//
+// Entries live in $ABYSS_CACHE_DIR, else $XDG_CACHE_HOME/abyss, else
+// $HOME/.cache/abyss. $ABYSS_CACHE_MAX_MB bounds the total size (default
+// 256); the least recently used entries go first.
+
+#define CACHE_KEY_LEN 33 // 128-bit hash as hex, plus NUL
+
+// Fills key from the generated sources texts[0..n) (lens[i] bytes each),
+// cc_cmd and the output of the shell command probe. Returns 0 if the probe
+// fails.
+int cache_key(char **texts, size_t *lens, int n, const char *cc_cmd,
+              const char *probe, char *key);
+
+// Copies the entry for key to out_file. Returns 1 on a hit.
+int cache_fetch(const char *key, const char *out_file);
+
+// Adds binary under key, then evicts down to the size limit. Failures are
+// silent: the cache is only an accelerator.
+void cache_store(const char *key, const char *binary);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CODEGEN_H
 #define CODEGEN_H
 
+#include "common.h"
 #include <stddef.h>
 #include <stdint.h>
 
@@ -16,8 +17,34 @@ void emit64(uint64_t v);
 void emit_patch(size_t addr, uint32_t v);
 int add_str(const char *s);
 
+// --- Precompiled print formats ---
+// Splits a constant format string into BcFmtSeg entries (see common.h) for a
+// print with argc arguments and returns the index of the first one. Parsing
+// matches the runtime OP_PRINT_FMT loop exactly, so output is unchanged.
+extern BcFmtSeg *fmt_segs;
+extern int fmt_seg_count;
+uint32_t add_format(const char *fmt, int argc);
+
+// --- Source line table ---
+// emit() tags the code it writes with lexer_last_pos(): one entry per run
+// of code from the same line. Passes that move code remap the addresses
+// with codegen_remap_lines(); map holds the new address of every old
+// instruction start, and NO_CODE_ADDR elsewhere, up to map[old_size].
+typedef struct {
+  uint32_t addr;
+  int line;
+  int file; // lexer file id
+} SrcLine;
+extern SrcLine *src_lines;
+extern int src_line_count;
+#define NO_CODE_ADDR 0xFFFFFFFFu
+void codegen_remap_lines(const uint32_t *map, size_t old_size);
+
 size_t codegen_size(void);
 uint8_t *codegen_buffer(void);
+// Takes ownership of `buf` (capacity `cap`) as the new code buffer. Used by
+// whole-program passes that rebuild the bytecode.
+void codegen_replace(uint8_t *buf, size_t size, size_t cap);
 
 // --- Forward-reference patch table ---
 // Used by the two-pass compiler. When an OP_CALL is emitted, the target
@@ -29,4 +56,28 @@ void add_call_patch(size_t patch_addr, int fid);
 void resolve_call_patches(void);
 void emit_call_to(int fid, uint8_t argc);
 
+// --- Function references used as values ---
+// `op.run = plus;` pushes a function's entry address with OP_CONST_INT. The
+// operand goes through the call patch table like any forward call, and its
+// location is also kept in func_refs: unlike an OP_CALL operand, nothing in
+// the opcode says it is a code address, so passes that move code (the
+// peephole optimizer) need this list to relocate it.
+extern size_t *func_refs;
+extern int func_ref_count;
+void emit_func_ref(int fid);
+
+// --- Interface (dynamic) calls ---
+// Emits OP_CALL_DYN_BOT with the number of values the call leaves behind.
+// The callee is not known statically, so the VM's verifier and the register
+// backend read the stack depth after the call from this operand.
+void emit_dyn_call(uint8_t argc, int ret_count);
+
+// --- Register backend ---
+// Translates the finished stack program (call patches resolved, entry call
+// appended, NOT superinstruction-fused) into register bytecode (RegWord[],
+// see common.h) and swaps it in as the code buffer. Every stack slot the
+// program can touch becomes a register, so values pushed only to be consumed
+// by the next instruction turn into operands. Returns the instruction count.
+size_t codegen_register_program(void);
+
 #endif
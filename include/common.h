@@ -5,9 +5,102 @@
 #include <stdlib.h>
 
 #define MAGIC "ABYSSBC"
-#define VERSION 13
+#define VERSION 23
 #define INIT_CAP 128
 
+// Header flags (the byte after VERSION, v14+).
+#define BC_FLAG_REGISTER 0x01 // code section holds RegWord[], not stack ops
+
+// --- File layout (v23) ---
+// A fixed header holding the table of contents, then sections at
+// BC_ALIGN-aligned file offsets so abyss_vm can mmap the file read-only and
+// use every section in place:
+//   string index   uint32_t[str_count], file offset of each string
+//   struct table   BcStruct[struct_count]
+//   function table BcFunc[func_count], for the load-time verifier and the
+//                  profiler
+//   format table   BcFmtSeg[fmt_count], precompiled print formats
+//   line table     BcLine[line_count], code address -> source line; only
+//                  for tools, nothing needs it to run the program
+//   string data    string literals, each preceded by its STR_HDR length
+//                  header, then struct, function and source file names;
+//                  all NUL-terminated
+//   code           stack ops or RegWord[], then BC_PAD zero bytes
+// magic and version keep their v14 positions, so older files are still
+// reported as a version mismatch.
+#define BC_ALIGN 16
+#define BC_PAD 16
+
+// Runtime strings (v19) are char * to NUL-terminated bytes with their length
+// as a uint32_t in the STR_HDR bytes in front of the first char. Literals get
+// it from the string data section, heap strings from malloc(STR_HDR + n + 1).
+#define STR_HDR 4
+
+typedef struct {
+  char magic[7];
+  uint8_t version;
+  uint8_t flags;
+  uint8_t reserved[3];
+  uint32_t str_count;
+  uint32_t str_index; // file offset of the string index
+  uint32_t struct_count;
+  uint32_t struct_table; // file offset of the struct table
+  uint32_t func_count;
+  uint32_t func_table; // file offset of the function table
+  uint32_t fmt_count;
+  uint32_t fmt_table; // file offset of the format table
+  uint32_t line_count;
+  uint32_t line_table; // file offset of the line table (v23)
+  uint32_t code;      // file offset of the code section
+  uint32_t code_size;
+  uint32_t file_size; // including the trailing BC_PAD bytes
+} BcHeader;
+
+typedef struct {
+  uint32_t name; // file offset of the NUL-terminated name
+  uint32_t size; // in 8-byte slots
+} BcStruct;
+
+// Every defined function: its entry address in the code section, the
+// arguments it expects, the values its RETs leave behind and its name
+// (v22), which abyss_vm --prof reports samples under.
+typedef struct {
+  uint32_t addr;
+  uint8_t argc;
+  uint8_t rets;
+  uint16_t reserved;
+  uint32_t name; // file offset of the NUL-terminated name
+} BcFunc;
+
+// The code from addr up to the next entry's addr was compiled from `line`
+// of `file`. Entries are sorted by addr. Addresses are code offsets, or
+// RegWord indices in register bytecode, like every other code address.
+typedef struct {
+  uint32_t addr;
+  uint32_t line;
+  uint32_t file; // file offset of the NUL-terminated source path
+} BcLine;
+
+// A constant print format is split at compile time into segments: literal
+// text (`len` bytes of string `lit`), then the next argument formatted as
+// `kind`. A format runs from its first segment to the one marked FMT_END,
+// whose literal is the text after the last placeholder.
+enum { FMT_END, FMT_INT, FMT_FLOAT, FMT_STR, FMT_CHAR, FMT_SKIP, FMT_KINDS };
+
+typedef struct {
+  uint32_t lit;
+  uint32_t len;
+  uint8_t kind;
+  uint8_t reserved[3];
+} BcFmtSeg;
+
+// A `+` chain that builds a str compiles to one OP_STR_CAT_N over all of its
+// parts, each tagged with how it is turned into text. Chains longer than
+// CAT_MAX continue in another OP_STR_CAT_N whose first part is the result.
+// OP_STRBUF_APPEND tags its value the same way.
+enum { CAT_STR, CAT_INT, CAT_FLOAT, CAT_CHAR };
+#define CAT_MAX 16
+
 typedef enum {
   TYPE_VOID,
   TYPE_INT,
@@ -15,7 +108,8 @@ typedef enum {
   TYPE_CHAR,
   TYPE_STR,
   TYPE_STRUCT,
-  TYPE_ARRAY
+  TYPE_ARRAY,
+  TYPE_STRBUF
 } DataType;
 
 enum {
@@ -94,7 +188,251 @@ enum {
   OP_F2I,          // float -> int (truncation)
   OP_INT_TO_STR,   // int -> heap-allocated str (tracked by Abyss Eye)
   OP_FLOAT_TO_STR, // float -> heap-allocated str
-  OP_SWAP          // swap top two stack slots (for mixed-type arithmetic)
+  OP_SWAP,         // swap top two stack slots (for mixed-type arithmetic)
+  // --- Precompiled formats (v17) ---
+  OP_PRINT_FMT_SEG, // format table index:4, argc:1 (format string not pushed)
+  // --- arena { } blocks (v18) ---
+  OP_ARENA_BEGIN, // new() now bumps out of the block's region
+  OP_ARENA_END,   // release everything new() made since the matching BEGIN
+  // --- Length-prefixed strings (v19) ---
+  OP_FREE_STR, // free() on a str: the block starts STR_HDR before the pointer
+  // --- Concatenation chains (v20) ---
+  OP_STR_CAT_N, // parts:1, kinds:4 (CAT_* per part, 2 bits each, first lowest)
+  // --- String builders (v21) ---
+  OP_STRBUF_NEW,    // push an empty strbuf
+  OP_STRBUF_APPEND, // kind:1 (CAT_*); pops the value, then the strbuf
+  OP_STRBUF_RESET,  // pops a strbuf; its length goes to 0, capacity stays
+  OP_STRBUF_STR,    // strbuf -> str owning its chars; the strbuf starts empty
+  OP_STRBUF_FREE,   // free() on a strbuf
+  // --- Superinstructions (v14) ---
+  // Never emitted by the parser. The peephole pass (src/peephole.c) fuses
+  // hot opcode sequences into these after the whole program is emitted.
+  // Compare-and-branch: <cmp>; JZ t
+  OP_LT_JZ,
+  OP_LE_JZ,
+  OP_GT_JZ,
+  OP_GE_JZ,
+  OP_EQ_JZ,
+  OP_NE_JZ,
+  // GET_LOCAL a; CONST_INT k; <cmp>; JZ t
+  OP_LOCAL_CONST_LT_JZ,
+  OP_LOCAL_CONST_LE_JZ,
+  OP_LOCAL_CONST_GT_JZ,
+  OP_LOCAL_CONST_GE_JZ,
+  OP_LOCAL_CONST_EQ_JZ,
+  OP_LOCAL_CONST_NE_JZ,
+  // GET_LOCAL a; GET_LOCAL b; <cmp>; JZ t
+  OP_LOCAL_LOCAL_LT_JZ,
+  OP_LOCAL_LOCAL_LE_JZ,
+  OP_LOCAL_LOCAL_GT_JZ,
+  OP_LOCAL_LOCAL_GE_JZ,
+  OP_LOCAL_LOCAL_EQ_JZ,
+  OP_LOCAL_LOCAL_NE_JZ,
+  OP_INC_LOCAL,       // GET_LOCAL a; CONST_INT k; ADD|SUB; SET_LOCAL a
+  OP_GET_LOCAL_FIELD, // GET_LOCAL a; GET_FIELD f
+  OP_GET_LOCAL2,      // GET_LOCAL a; GET_LOCAL b
+  OP_COUNT
+};
+
+// Number of operand bytes that follow each opcode. Every pass that walks
+// bytecode linearly (peephole optimizer, native transpiler) uses this so the
+// encoding is described in exactly one place.
+static inline int op_operand_size(uint8_t op) {
+  switch (op) {
+  case OP_CONST_INT:
+  case OP_CONST_STR:
+  case OP_JMP:
+  case OP_JZ:
+  case OP_TRY:
+  case OP_NATIVE:
+  case OP_TAG_ALLOC:
+  case OP_LT_JZ:
+  case OP_LE_JZ:
+  case OP_GT_JZ:
+  case OP_GE_JZ:
+  case OP_EQ_JZ:
+  case OP_NE_JZ:
+    return 4;
+  case OP_CONST_FLOAT:
+  case OP_ALLOC_STRUCT:
+  case OP_ALLOC_ARRAY:
+  case OP_ALLOC_STACK:
+    return 8;
+  case OP_CALL:
+  case OP_INC_LOCAL:
+  case OP_PRINT_FMT_SEG:
+  case OP_STR_CAT_N:
+    return 5;
+  case OP_GET_GLOBAL:
+  case OP_SET_GLOBAL:
+  case OP_GET_LOCAL:
+  case OP_SET_LOCAL:
+  case OP_RET:
+  case OP_GET_FIELD:
+  case OP_SET_FIELD:
+  case OP_PRINT_FMT:
+  case OP_STRBUF_APPEND:
+    return 1;
+  case OP_CALL_DYN_BOT: // argc, return count
+  case OP_GET_LOCAL_FIELD:
+  case OP_GET_LOCAL2:
+    return 2;
+  case OP_LOCAL_CONST_LT_JZ:
+  case OP_LOCAL_CONST_LE_JZ:
+  case OP_LOCAL_CONST_GT_JZ:
+  case OP_LOCAL_CONST_GE_JZ:
+  case OP_LOCAL_CONST_EQ_JZ:
+  case OP_LOCAL_CONST_NE_JZ:
+    return 9; // local:1, const:4, target:4
+  case OP_LOCAL_LOCAL_LT_JZ:
+  case OP_LOCAL_LOCAL_LE_JZ:
+  case OP_LOCAL_LOCAL_GT_JZ:
+  case OP_LOCAL_LOCAL_GE_JZ:
+  case OP_LOCAL_LOCAL_EQ_JZ:
+  case OP_LOCAL_LOCAL_NE_JZ:
+    return 6; // local:1, local:1, target:4
+  default:
+    return 0;
+  }
+}
+
+// --- Register bytecode (v14, BC_FLAG_REGISTER) ---
+// Produced by codegen_register_program() from the finished stack program.
+// Registers are frame slots: rN is stack[fp + N], the slot the stack program
+// uses for the value at depth N, so locals keep their indices and calls pass
+// arguments in place. Every instruction is one 8-byte RegWord; instructions
+// marked [ext] are followed by one extension word.
+typedef struct {
+  uint8_t op;
+  uint8_t n; // argument / return count
+  uint16_t a;
+  union {
+    struct {
+      uint16_t b;
+      uint16_t c;
+    };
+    int32_t imm;  // immediate, string index, native id
+    uint32_t tgt; // code target (RegWord index)
+  };
+} RegInsn;
+
+typedef union {
+  RegInsn i;
+  int64_t k;       // 64-bit constant
+  uint32_t u32[2]; // two 32-bit operands
+} RegWord;
+
+enum {
+  R_HALT = 0,
+  R_LOADI, // a = imm
+  R_LOADK, // a = ext.k  [ext]
+  R_LOADS, // a = strs[imm]
+  R_MOV,   // a = b
+  R_GETG,  // a = globals[b]
+  R_SETG,  // globals[b] = a
+  // a = b <op> c  (int)
+  R_ADD,
+  R_SUB,
+  R_MUL,
+  R_DIV,
+  R_MOD,
+  R_AND,
+  R_OR,
+  R_BIT_AND,
+  R_BIT_OR,
+  R_BIT_XOR,
+  R_SHL,
+  R_SHR,
+  R_LT,
+  R_LE,
+  R_GT,
+  R_GE,
+  R_EQ,
+  R_NE,
+  R_ADDI, // a = b + (int16_t)c
+  // a = b <op> c  (float)
+  R_ADD_F,
+  R_SUB_F,
+  R_MUL_F,
+  R_DIV_F,
+  R_LT_F,
+  R_LE_F,
+  R_GT_F,
+  R_GE_F,
+  R_EQ_F,
+  R_NE_F,
+  // a = <op> b
+  R_NEG,
+  R_NEG_F,
+  R_NOT,
+  R_BIT_NOT,
+  R_I2F,
+  R_F2I,
+  R_INT_TO_STR,
+  R_FLOAT_TO_STR,
+  R_STR_CAT, // a = b ++ c
+  R_STR_CAT_N, // a = n parts in a.. joined, CAT_* kinds in imm
+  R_STRBUF_NEW,    // a = new strbuf
+  R_STRBUF_APPEND, // append b to strbuf a as CAT_* kind n
+  R_STRBUF_RESET,  // reset strbuf a
+  R_STRBUF_STR,    // a = str taken from strbuf b
+  // control flow
+  R_JMP, // goto tgt
+  R_JZ,  // if (!a) goto tgt
+  // if (!(a <cmp> b)) goto ext.u32[0]  [ext]
+  R_JZ_LT,
+  R_JZ_LE,
+  R_JZ_GT,
+  R_JZ_GE,
+  R_JZ_EQ,
+  R_JZ_NE,
+  // if (!(a <cmp> imm)) goto ext.u32[0]  [ext]
+  R_JZ_LTI,
+  R_JZ_LEI,
+  R_JZ_GTI,
+  R_JZ_GEI,
+  R_JZ_EQI,
+  R_JZ_NEI,
+  R_CALL,     // new frame at a, n args, goto tgt
+  R_CALL_DYN, // target in a, n args in a+1.., new frame at a
+  R_RET,      // return n values from a..a+n-1
+  R_TRY,      // catch at tgt, error value lands in a
+  R_END_TRY,
+  R_THROW, // throw a
+  // output
+  R_PRINT,
+  R_PRINT_F,
+  R_PRINT_STR,
+  R_PRINT_CHAR,
+  R_PRINT_FMT,     // format in a, n args in a+1..
+  R_PRINT_FMT_SEG, // format table index imm, n args in a..
+  // memory
+  R_ALLOC_STRUCT, // a = new struct ext.u32[0], comment ext.u32[1]  [ext]
+  R_ALLOC_STACK,  // same, stack lifetime  [ext]
+  R_ALLOC_ARRAY,  // a = b elements of ext.u32[0] bytes, comment ext.u32[1]
+                  // [ext]
+  R_FREE,         // free a
+  R_FREE_STR,     // free str a
+  R_STRBUF_FREE,  // free strbuf a
+  R_ARENA_BEGIN,  // open an arena { } block
+  R_ARENA_END,    // close the innermost one
+  R_GET_FIELD,    // a = ((int64_t *)b)[c]
+  R_SET_FIELD,    // ((int64_t *)a)[c] = b
+  R_GET_INDEX,    // a = ((int64_t *)b)[c]  (c is a register)
+  R_SET_INDEX,    // ((int64_t *)a)[b] = c
+  R_INC_INDEX,    // ((int64_t *)a)[b]++
+  R_DEC_INDEX,    // ((int64_t *)a)[b]--
+  R_SWAP,         // a <-> b
+  R_TAG_ALLOC,    // tag the allocation in a with strs[imm]
+  R_NATIVE,       // native imm, result (if any) in a
+  R_ABYSS_EYE,
+  R_COUNT
 };
 
+// Extension words after a register instruction: 1 for those marked [ext].
+static inline int r_ext_words(uint8_t op) {
+  return op == R_LOADK || (op >= R_JZ_LT && op <= R_JZ_NEI) ||
+         (op >= R_ALLOC_STRUCT && op <= R_ALLOC_ARRAY);
+}
+
 #endif
@@ -80,7 +80,9 @@ typedef enum {
   TK_BIT_XOR,
   TK_SHL,
   TK_SHR,
-  TK_BIT_NOT
+  TK_BIT_NOT,
+  TK_ARENA,
+  TK_STRBUF_TYPE
 } TkKind;
 
 typedef struct {
@@ -90,11 +92,12 @@ typedef struct {
   double fval;
   int line;
   int col;
+  int file; // source file, see lexer_file_name()
 } Token;
 
 extern Token cur;
 
-void lexer_init(char *source);
+void lexer_init(char *source, const char *filename);
 void lexer_include(char *filename);
 void lexer_reset_to_start(void);
 void lexer_reset_imports(void);
@@ -105,4 +108,13 @@ const char *tk_str(TkKind k);
 void print_error_context();
 TkKind peek_kind();
 
+// Source files get small ids in the order they are first read, so the same
+// file has the same id in both passes.
+const char *lexer_file_name(int file);
+int lexer_file_count(void);
+// File and line of the last token consumed, i.e. the one before cur. Code
+// emitted for a construct usually follows its last token, so codegen tags
+// emitted code with this position.
+void lexer_last_pos(int *file, int *line);
+
 #endif
@@ -1,6 +1,22 @@
 #ifndef NATIVE_H
 #define NATIVE_H
 
-void generate_native_code(const char *out_filename, int enable_profiler);
+#include <stddef.h>
+
+// A generated source file: where it was written and its text.
+typedef struct {
+  char *path;
+  char *text;
+  size_t len;
+} NativeFile;
+
+// Writes the program as C to <stem>.c. A program large enough to be worth
+// building in parallel is split, by its size alone, into function units
+// <stem>_1.c ... <stem>_N.c, sharing the declarations in <stem>.h; <stem>.c
+// then keeps the runtime and main(). Sets *files to the files written, the
+// .c files in unit order followed by the header when split, and returns the
+// number of .c files.
+int generate_native_code(const char *stem, int enable_profiler,
+                         NativeFile **files);
 
 #endif
@@ -0,0 +1,14 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <stddef.h>
+
+// Superinstruction fusion. Runs once over the finished program (after
+// parse_program() has resolved every call patch and main.c has appended the
+// entry call) and rewrites hot opcode sequences into the fused opcodes
+// declared at the end of the opcode enum in common.h. Jump, call, try and
+// function-reference operands and funcs[].addr are remapped to the new
+// layout. Returns the number of sequences fused.
+size_t peephole_optimize(void);
+
+#endif
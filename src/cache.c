@@ -0,0 +1,204 @@
+#include "../include/cache.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_MAX_MB 256
+
+// FNV-1a, 128-bit variant.
+typedef unsigned __int128 u128;
+
+static u128 fnv_init(void) {
+  return ((u128)0x6c62272e07bb0142ULL << 64) | 0x62b821756295c58dULL;
+}
+
+static u128 fnv_mix(u128 h, const void *data, size_t n) {
+  const u128 prime = ((u128)1 << 88) | 0x13b;
+  const unsigned char *p = data;
+  for (size_t i = 0; i < n; i++) {
+    h ^= p[i];
+    h *= prime;
+  }
+  return h;
+}
+
+// Cache directory, created on first use. Empty if none can be made.
+static const char *cache_dir(void) {
+  static char dir[1024];
+  static int ready = 0;
+  if (ready)
+    return dir;
+  ready = 1;
+
+  const char *env = getenv("ABYSS_CACHE_DIR");
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  if (env && *env)
+    snprintf(dir, sizeof(dir), "%s", env);
+  else if (xdg && *xdg)
+    snprintf(dir, sizeof(dir), "%s/abyss", xdg);
+  else if (home && *home)
+    snprintf(dir, sizeof(dir), "%s/.cache/abyss", home);
+  else
+    return dir;
+
+  // mkdir -p
+  for (char *p = dir + 1; *p; p++) {
+    if (*p != '/')
+      continue;
+    *p = 0;
+    mkdir(dir, 0755);
+    *p = '/';
+  }
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    dir[0] = 0;
+  return dir;
+}
+
+static int copy_file(const char *from, const char *to, mode_t mode) {
+  FILE *in = fopen(from, "rb");
+  if (!in)
+    return 0;
+  int fd = open(to, O_WRONLY | O_CREAT | O_TRUNC, mode);
+  FILE *out = fd < 0 ? NULL : fdopen(fd, "wb");
+  if (!out) {
+    if (fd >= 0)
+      close(fd);
+    fclose(in);
+    return 0;
+  }
+  char buf[65536];
+  size_t n;
+  int ok = 1;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    if (fwrite(buf, 1, n, out) != n) {
+      ok = 0;
+      break;
+    }
+  if (ferror(in))
+    ok = 0;
+  fclose(in);
+  if (fclose(out) != 0)
+    ok = 0;
+  // An existing out_file keeps its old mode through O_TRUNC.
+  chmod(to, mode);
+  return ok;
+}
+
+int cache_key(char **texts, size_t *lens, int n, const char *cc_cmd,
+              const char *probe, char *key) {
+  u128 h = fnv_init();
+  for (int i = 0; i < n; i++) {
+    h = fnv_mix(h, texts[i], lens[i]);
+    // The NUL keeps the boundaries between the parts unambiguous.
+    h = fnv_mix(h, "", 1);
+  }
+  h = fnv_mix(h, cc_cmd, strlen(cc_cmd));
+  h = fnv_mix(h, "", 1);
+
+  FILE *p = popen(probe, "r");
+  if (!p)
+    return 0;
+  char buf[65536];
+  size_t got;
+  while ((got = fread(buf, 1, sizeof(buf), p)) > 0)
+    h = fnv_mix(h, buf, got);
+  if (pclose(p) != 0)
+    return 0;
+
+  snprintf(key, CACHE_KEY_LEN, "%016llx%016llx",
+           (unsigned long long)(h >> 64), (unsigned long long)h);
+  return 1;
+}
+
+int cache_fetch(const char *key, const char *out_file) {
+  const char *dir = cache_dir();
+  if (!*dir)
+    return 0;
+  char path[1200];
+  snprintf(path, sizeof(path), "%s/%s", dir, key);
+  if (!copy_file(path, out_file, 0755))
+    return 0;
+  // Mark the entry as recently used for eviction.
+  utimensat(AT_FDCWD, path, NULL, 0);
+  return 1;
+}
+
+typedef struct {
+  char name[CACHE_KEY_LEN];
+  off_t size;
+  time_t used;
+} Entry;
+
+static int by_age(const void *a, const void *b) {
+  time_t x = ((const Entry *)a)->used, y = ((const Entry *)b)->used;
+  return (x > y) - (x < y);
+}
+
+static void evict(const char *dir) {
+  long max_mb = DEFAULT_MAX_MB;
+  const char *env = getenv("ABYSS_CACHE_MAX_MB");
+  if (env && *env)
+    max_mb = strtol(env, NULL, 10);
+  off_t limit = (off_t)max_mb << 20;
+
+  DIR *d = opendir(dir);
+  if (!d)
+    return;
+  Entry *entries = NULL;
+  int count = 0, cap = 0;
+  off_t total = 0;
+  struct dirent *de;
+  char path[1200];
+  while ((de = readdir(d))) {
+    // Only names cache_key() produces; leaves temp files and strays alone.
+    if (strlen(de->d_name) != CACHE_KEY_LEN - 1 ||
+        strspn(de->d_name, "0123456789abcdef") != CACHE_KEY_LEN - 1)
+      continue;
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+      continue;
+    if (count == cap) {
+      cap = cap ? cap * 2 : 64;
+      entries = realloc(entries, cap * sizeof(Entry));
+    }
+    memcpy(entries[count].name, de->d_name, CACHE_KEY_LEN);
+    entries[count].size = st.st_size;
+    entries[count].used = st.st_mtime;
+    total += st.st_size;
+    count++;
+  }
+  closedir(d);
+
+  qsort(entries, count, sizeof(Entry), by_age);
+  for (int i = 0; i < count && total > limit; i++) {
+    snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+    if (unlink(path) == 0)
+      total -= entries[i].size;
+  }
+  free(entries);
+}
+
+void cache_store(const char *key, const char *binary) {
+  const char *dir = cache_dir();
+  if (!*dir)
+    return;
+  // Write under a private name and rename, so a concurrent abyssc never
+  // fetches a half-written entry.
+  char tmp[1200], path[1200];
+  snprintf(tmp, sizeof(tmp), "%s/%s.%ld.tmp", dir, key, (long)getpid());
+  snprintf(path, sizeof(path), "%s/%s", dir, key);
+  if (!copy_file(binary, tmp, 0755) || rename(tmp, path) != 0) {
+    unlink(tmp);
+    return;
+  }
+  evict(dir);
+}
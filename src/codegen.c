@@ -1,7 +1,9 @@
 #include "../include/codegen.h"
 #include "../include/common.h"
+#include "../include/lexer.h"
 #include "../include/symbols.h"
 #include "../include/utils.h"
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -22,6 +24,18 @@ static CallPatch *call_patches = NULL;
 static int call_patch_count = 0;
 static int call_patch_cap = 0;
 
+size_t *func_refs = NULL;
+int func_ref_count = 0;
+static int func_ref_cap = 0;
+
+BcFmtSeg *fmt_segs = NULL;
+int fmt_seg_count = 0;
+static int fmt_seg_cap = 0;
+
+SrcLine *src_lines = NULL;
+int src_line_count = 0;
+static int src_line_cap = 0;
+
 void codegen_init() {
   code_cap = 1024;
   code = malloc(code_cap);
@@ -30,6 +44,29 @@ void codegen_init() {
   call_patch_cap = 0;
   call_patch_count = 0;
   call_patches = NULL;
+  func_ref_cap = 0;
+  func_ref_count = 0;
+  func_refs = NULL;
+}
+
+// Starts a line table entry at code_sz if the source position moved.
+static void note_line(void) {
+  int file, line;
+  lexer_last_pos(&file, &line);
+  SrcLine *last = src_line_count ? &src_lines[src_line_count - 1] : NULL;
+  if (last && last->line == line && last->file == file)
+    return;
+  if (last && last->addr == code_sz) {
+    *last = (SrcLine){(uint32_t)code_sz, line, file};
+    return;
+  }
+  if (src_line_count >= src_line_cap) {
+    src_line_cap = src_line_cap ? src_line_cap * 2 : INIT_CAP;
+    src_lines = realloc(src_lines, src_line_cap * sizeof(SrcLine));
+    if (!src_lines)
+      fail("Out of memory (line table)");
+  }
+  src_lines[src_line_count++] = (SrcLine){(uint32_t)code_sz, line, file};
 }
 
 void emit(uint8_t b) {
@@ -39,9 +76,29 @@ void emit(uint8_t b) {
     if (!code)
       fail("Out of memory (code)");
   }
+  note_line();
   code[code_sz++] = b;
 }
 
+void codegen_remap_lines(const uint32_t *map, size_t old_size) {
+  int n = 0;
+  for (int i = 0; i < src_line_count; i++) {
+    // An entry inside a fused sequence moves to where the next surviving
+    // instruction starts.
+    size_t a = src_lines[i].addr;
+    while (a < old_size && map[a] == NO_CODE_ADDR)
+      a++;
+    SrcLine e = src_lines[i];
+    e.addr = map[a];
+    if (n && src_lines[n - 1].addr == e.addr)
+      n--;
+    if (n && src_lines[n - 1].line == e.line && src_lines[n - 1].file == e.file)
+      continue;
+    src_lines[n++] = e;
+  }
+  src_line_count = n;
+}
+
 void emit32(uint32_t v) {
   emit(v & 0xFF);
   emit((v >> 8) & 0xFF);
@@ -71,9 +128,71 @@ int add_str(const char *s) {
   return str_count++;
 }
 
+static void add_fmt_seg(char *lit, uint32_t len, uint8_t kind) {
+  if (fmt_seg_count >= fmt_seg_cap) {
+    fmt_seg_cap = fmt_seg_cap ? fmt_seg_cap * 2 : INIT_CAP;
+    fmt_segs = realloc(fmt_segs, fmt_seg_cap * sizeof(BcFmtSeg));
+    if (!fmt_segs)
+      fail("Out of memory (format table)");
+  }
+  lit[len] = 0;
+  fmt_segs[fmt_seg_count++] =
+      (BcFmtSeg){.lit = len ? (uint32_t)add_str(lit) : 0,
+                 .len = len,
+                 .kind = kind};
+}
+
+uint32_t add_format(const char *fmt, int argc) {
+  uint32_t first = (uint32_t)fmt_seg_count;
+  char *lit = malloc(strlen(fmt) + 1);
+  if (!lit)
+    fail("Out of memory (format table)");
+  uint32_t len = 0;
+  int current_arg = 0;
+  for (int i = 0; fmt[i]; i++) {
+    if (fmt[i] == '%') {
+      i++;
+      if (fmt[i] == '{')
+        i++;
+      char type_buf[32];
+      int ti = 0;
+      while (fmt[i] && isalpha(fmt[i]) && ti < 31)
+        type_buf[ti++] = fmt[i++];
+      type_buf[ti] = 0;
+      if (fmt[i] != '}') // leave i on the placeholder's last character
+        i--;
+      if (current_arg < argc) {
+        uint8_t kind = FMT_SKIP; // unknown type: the argument is dropped
+        if (!strcmp(type_buf, "int") || !strcmp(type_buf, "integer"))
+          kind = FMT_INT;
+        else if (!strcmp(type_buf, "float"))
+          kind = FMT_FLOAT;
+        else if (!strcmp(type_buf, "str") || !strcmp(type_buf, "string"))
+          kind = FMT_STR;
+        else if (!strcmp(type_buf, "char"))
+          kind = FMT_CHAR;
+        add_fmt_seg(lit, len, kind);
+        len = 0;
+        current_arg++;
+      }
+    } else
+      lit[len++] = fmt[i];
+  }
+  add_fmt_seg(lit, len, FMT_END);
+  free(lit);
+  return first;
+}
+
 size_t codegen_size(void) { return code_sz; }
 uint8_t *codegen_buffer(void) { return code; }
 
+void codegen_replace(uint8_t *buf, size_t size, size_t cap) {
+  free(code);
+  code = buf;
+  code_sz = size;
+  code_cap = cap;
+}
+
 void add_call_patch(size_t patch_addr, int fid) {
   if (call_patch_count >= call_patch_cap) {
     call_patch_cap = call_patch_cap ? call_patch_cap * 2 : 64;
@@ -103,3 +222,887 @@ void emit_call_to(int fid, uint8_t argc) {
   add_call_patch(patch_addr, fid);
   emit(argc);
 }
+
+void emit_func_ref(int fid) {
+  emit(OP_CONST_INT);
+  size_t patch_addr = code_sz;
+  emit32(0); // placeholder address, resolved later
+  add_call_patch(patch_addr, fid);
+  if (func_ref_count >= func_ref_cap) {
+    func_ref_cap = func_ref_cap ? func_ref_cap * 2 : 16;
+    func_refs = realloc(func_refs, func_ref_cap * sizeof(size_t));
+    if (!func_refs)
+      fail("Out of memory (function references)");
+  }
+  func_refs[func_ref_count++] = patch_addr;
+}
+
+void emit_dyn_call(uint8_t argc, int ret_count) {
+  emit(OP_CALL_DYN_BOT);
+  emit(argc);
+  emit((uint8_t)ret_count);
+}
+
+// ===================================================================
+// Register backend
+// ===================================================================
+// Works on the finished stack program in two passes:
+//   1. Depth analysis: walk every reachable path from the program entry and
+//      each function entry and record the stack depth (relative to fp) in
+//      front of every instruction. Paths that meet must agree.
+//   2. Translation: replay the program with a descriptor per live slot. A
+//      slot is either REG (its value is in the frame), COPY (it equals
+//      another register and nothing was emitted yet) or CONST (a pending
+//      int32). Loads of locals and constants therefore cost nothing; they are
+//      folded into the operands of the instruction that consumes them.
+//      Pending slots are written out ("flushed") wherever control can leave
+//      or enter the straight-line code, so at every jump target, call and
+//      throw the frame holds exactly what the stack VM would hold.
+
+#define REG_NO_DEPTH (-1)
+#define REG_MAX_SLOTS 65535
+
+enum { SLOT_REG, SLOT_COPY, SLOT_CONST };
+typedef struct {
+  uint8_t kind;
+  int32_t v; // COPY: source register, CONST: value
+} RegSlot;
+
+enum { FIX_TGT, FIX_EXT, FIX_IMM }; // insn.tgt, ext.u32[0], insn.imm
+typedef struct {
+  size_t word;  // word holding the address
+  int kind;     // FIX_*
+  uint32_t old; // stack-program address
+} RegFixup;
+
+static RegWord *rcode = NULL;
+static size_t rcode_sz = 0;
+static size_t rcode_cap = 0;
+static RegFixup *rfix = NULL;
+static int rfix_count = 0;
+static int rfix_cap = 0;
+static RegSlot *rslots = NULL;
+static size_t r_last = 0; // word index of the last instruction emitted
+static int r_last_pure = 0; // ... and it only writes register `a`
+
+static uint32_t r_read32(size_t at) {
+  uint32_t v;
+  memcpy(&v, code + at, 4);
+  return v;
+}
+
+static size_t r_word(void) {
+  if (rcode_sz >= rcode_cap) {
+    rcode_cap = rcode_cap ? rcode_cap * 2 : 1024;
+    rcode = realloc(rcode, rcode_cap * sizeof(RegWord));
+    if (!rcode)
+      fail("Out of memory (register code)");
+  }
+  memset(&rcode[rcode_sz], 0, sizeof(RegWord));
+  return rcode_sz++;
+}
+
+// Appends an instruction word and returns its index. `pure` marks
+// instructions whose only effect on the frame is writing register `a`, which
+// lets a following SET_LOCAL retarget them instead of emitting a move.
+static size_t r_insn(uint8_t op, int n, int a, int pure) {
+  size_t w = r_word();
+  rcode[w].i.op = op;
+  rcode[w].i.n = (uint8_t)n;
+  rcode[w].i.a = (uint16_t)a;
+  r_last = w;
+  r_last_pure = pure;
+  return w;
+}
+
+static void r_fixup(size_t word, int kind, uint32_t old) {
+  if (rfix_count >= rfix_cap) {
+    rfix_cap = rfix_cap ? rfix_cap * 2 : 256;
+    rfix = realloc(rfix, rfix_cap * sizeof(RegFixup));
+    if (!rfix)
+      fail("Out of memory (register fixups)");
+  }
+  rfix[rfix_count].word = word;
+  rfix[rfix_count].kind = kind;
+  rfix[rfix_count].old = old;
+  rfix_count++;
+}
+
+// Writes a pending slot out to its register.
+static void r_flush_slot(int d) {
+  if (rslots[d].kind == SLOT_COPY) {
+    size_t w = r_insn(R_MOV, 0, d, 1);
+    rcode[w].i.b = (uint16_t)rslots[d].v;
+  } else if (rslots[d].kind == SLOT_CONST) {
+    size_t w = r_insn(R_LOADI, 0, d, 1);
+    rcode[w].i.imm = rslots[d].v;
+  }
+  rslots[d].kind = SLOT_REG;
+}
+
+static void r_flush(int from, int depth) {
+  for (int d = from; d < depth; d++)
+    r_flush_slot(d);
+}
+
+// Register `w` is about to be overwritten: materialize every pending copy of
+// it first.
+static void r_clobber(int w, int depth) {
+  for (int d = 0; d < depth; d++)
+    if (rslots[d].kind == SLOT_COPY && rslots[d].v == w)
+      r_flush_slot(d);
+}
+
+// Returns the register holding slot d's value, materializing constants.
+static int r_src(int d) {
+  if (rslots[d].kind == SLOT_COPY)
+    return rslots[d].v;
+  if (rslots[d].kind == SLOT_CONST)
+    r_flush_slot(d);
+  return d;
+}
+
+static void r_set(int d, uint8_t kind, int32_t v) {
+  rslots[d].kind = kind;
+  rslots[d].v = v;
+}
+
+// Values left on the stack by a call to the function entered at `addr`.
+static int r_callee_rets(uint32_t addr) {
+  for (int i = 0; i < func_count; i++)
+    if (funcs[i].addr == addr)
+      return funcs[i].ret_count;
+  fail("Internal: register backend found a call to a non-function "
+       "(address %u)",
+       addr);
+}
+
+static void r_reach(int *depth, size_t *work, int *wn, uint32_t at, int d) {
+  if (at >= code_sz)
+    fail("Internal: register backend found a jump out of the program "
+         "(address %u)",
+         at);
+  if (d > REG_MAX_SLOTS)
+    fail("Register backend: frame needs more than %d slots",
+         REG_MAX_SLOTS);
+  if (depth[at] == REG_NO_DEPTH) {
+    depth[at] = d;
+    work[(*wn)++] = at;
+  } else if (depth[at] != d) {
+    fail("Register backend: stack depth at bytecode address %u differs "
+         "between paths (%d vs %d); the program leaves values on the stack "
+         "inside a loop or branch",
+         at, depth[at], d);
+  }
+}
+
+// Stack depth after the instruction at ip, or REG_NO_DEPTH if control does
+// not fall through. Branch targets are queued by the caller.
+static int r_effect(size_t ip, int d) {
+  uint8_t op = code[ip];
+  int pops = 0, pushes = 0;
+  switch (op) {
+  case OP_CONST_INT:
+  case OP_CONST_FLOAT:
+  case OP_CONST_STR:
+  case OP_GET_GLOBAL:
+  case OP_GET_LOCAL:
+  case OP_ALLOC_STRUCT:
+  case OP_ALLOC_STACK:
+  case OP_DUP:
+    pushes = 1;
+    break;
+  case OP_ADD:
+  case OP_SUB:
+  case OP_MUL:
+  case OP_DIV:
+  case OP_MOD:
+  case OP_ADD_F:
+  case OP_SUB_F:
+  case OP_MUL_F:
+  case OP_DIV_F:
+  case OP_LT:
+  case OP_LE:
+  case OP_GT:
+  case OP_GE:
+  case OP_EQ:
+  case OP_NE:
+  case OP_LT_F:
+  case OP_LE_F:
+  case OP_GT_F:
+  case OP_GE_F:
+  case OP_EQ_F:
+  case OP_NE_F:
+  case OP_AND:
+  case OP_OR:
+  case OP_BIT_AND:
+  case OP_BIT_OR:
+  case OP_BIT_XOR:
+  case OP_SHL:
+  case OP_SHR:
+  case OP_STR_CAT:
+  case OP_GET_INDEX:
+    pops = 2;
+    pushes = 1;
+    break;
+  case OP_NEG:
+  case OP_NEG_F:
+  case OP_NOT:
+  case OP_BIT_NOT:
+  case OP_I2F:
+  case OP_F2I:
+  case OP_INT_TO_STR:
+  case OP_FLOAT_TO_STR:
+  case OP_STRBUF_STR:
+  case OP_ALLOC_ARRAY:
+  case OP_GET_FIELD:
+  case OP_TAG_ALLOC:
+    pops = 1;
+    pushes = 1;
+    break;
+  case OP_SWAP:
+    pops = 2;
+    pushes = 2;
+    break;
+  case OP_JZ:
+  case OP_PRINT:
+  case OP_PRINT_F:
+  case OP_PRINT_STR:
+  case OP_PRINT_CHAR:
+  case OP_SET_GLOBAL:
+  case OP_SET_LOCAL:
+  case OP_POP:
+  case OP_FREE:
+  case OP_FREE_STR:
+  case OP_STRBUF_RESET:
+  case OP_STRBUF_FREE:
+    pops = 1;
+    break;
+  case OP_SET_FIELD:
+  case OP_INC_INDEX:
+  case OP_DEC_INDEX:
+    pops = 2;
+    break;
+  case OP_SET_INDEX:
+    pops = 3;
+    break;
+  case OP_PRINT_FMT:
+    pops = code[ip + 1] + 1;
+    break;
+  case OP_PRINT_FMT_SEG:
+    pops = code[ip + 5];
+    break;
+  case OP_STR_CAT_N:
+    pops = code[ip + 1];
+    pushes = 1;
+    break;
+  case OP_STRBUF_NEW:
+    pushes = 1;
+    break;
+  case OP_STRBUF_APPEND:
+    pops = 2;
+    break;
+  case OP_CALL:
+    pops = code[ip + 5];
+    pushes = r_callee_rets(r_read32(ip + 1));
+    break;
+  case OP_CALL_DYN_BOT:
+    pops = code[ip + 1] + 1;
+    pushes = code[ip + 2];
+    break;
+  case OP_NATIVE:
+    pushes = r_read32(ip + 1) <= 1; // clock, input_int
+    break;
+  case OP_RET:
+    pops = code[ip + 1];
+    break;
+  case OP_THROW:
+    pops = 1;
+    break;
+  case OP_JMP:
+  case OP_TRY:
+  case OP_END_TRY:
+  case OP_ARENA_BEGIN:
+  case OP_ARENA_END:
+  case OP_ABYSS_EYE:
+  case OP_HALT:
+    break;
+  default:
+    fail("Internal: register backend cannot translate opcode %d", op);
+  }
+  if (d < pops)
+    fail("Internal: stack underflow at bytecode address %zu", ip);
+  if (op == OP_JMP || op == OP_RET || op == OP_THROW || op == OP_HALT)
+    return REG_NO_DEPTH;
+  return d - pops + pushes;
+}
+
+// Register opcode for stack opcodes that map one-to-one, or -1.
+static int r_simple_op(uint8_t op) {
+  switch (op) {
+  case OP_ADD:
+    return R_ADD;
+  case OP_SUB:
+    return R_SUB;
+  case OP_MUL:
+    return R_MUL;
+  case OP_DIV:
+    return R_DIV;
+  case OP_MOD:
+    return R_MOD;
+  case OP_AND:
+    return R_AND;
+  case OP_OR:
+    return R_OR;
+  case OP_BIT_AND:
+    return R_BIT_AND;
+  case OP_BIT_OR:
+    return R_BIT_OR;
+  case OP_BIT_XOR:
+    return R_BIT_XOR;
+  case OP_SHL:
+    return R_SHL;
+  case OP_SHR:
+    return R_SHR;
+  case OP_LT:
+    return R_LT;
+  case OP_LE:
+    return R_LE;
+  case OP_GT:
+    return R_GT;
+  case OP_GE:
+    return R_GE;
+  case OP_EQ:
+    return R_EQ;
+  case OP_NE:
+    return R_NE;
+  case OP_ADD_F:
+    return R_ADD_F;
+  case OP_SUB_F:
+    return R_SUB_F;
+  case OP_MUL_F:
+    return R_MUL_F;
+  case OP_DIV_F:
+    return R_DIV_F;
+  case OP_LT_F:
+    return R_LT_F;
+  case OP_LE_F:
+    return R_LE_F;
+  case OP_GT_F:
+    return R_GT_F;
+  case OP_GE_F:
+    return R_GE_F;
+  case OP_EQ_F:
+    return R_EQ_F;
+  case OP_NE_F:
+    return R_NE_F;
+  case OP_STR_CAT:
+    return R_STR_CAT;
+  case OP_GET_INDEX:
+    return R_GET_INDEX;
+  case OP_NEG:
+    return R_NEG;
+  case OP_NEG_F:
+    return R_NEG_F;
+  case OP_NOT:
+    return R_NOT;
+  case OP_BIT_NOT:
+    return R_BIT_NOT;
+  case OP_I2F:
+    return R_I2F;
+  case OP_F2I:
+    return R_F2I;
+  case OP_INT_TO_STR:
+    return R_INT_TO_STR;
+  case OP_FLOAT_TO_STR:
+    return R_FLOAT_TO_STR;
+  case OP_PRINT:
+    return R_PRINT;
+  case OP_PRINT_F:
+    return R_PRINT_F;
+  case OP_PRINT_STR:
+    return R_PRINT_STR;
+  case OP_PRINT_CHAR:
+    return R_PRINT_CHAR;
+  case OP_FREE:
+    return R_FREE;
+  case OP_FREE_STR:
+    return R_FREE_STR;
+  case OP_STRBUF_RESET:
+    return R_STRBUF_RESET;
+  case OP_STRBUF_FREE:
+    return R_STRBUF_FREE;
+  case OP_STRBUF_STR:
+    return R_STRBUF_STR;
+  default:
+    return -1;
+  }
+}
+
+// Offset of an int compare within the R_JZ_* families, or -1.
+static int r_cmp_index(uint8_t op) {
+  if (op >= OP_LT && op <= OP_NE)
+    return op - OP_LT;
+  return -1;
+}
+
+size_t codegen_register_program(void) {
+  // --- 1. Depth analysis ---
+  int *depth = malloc((code_sz + 1) * sizeof(int));
+  uint8_t *leader = calloc(code_sz + 1, 1);
+  uint8_t *is_ref = calloc(code_sz + 1, 1);
+  size_t *work = malloc((code_sz + 1) * sizeof(size_t));
+  uint32_t *map = malloc((code_sz + 1) * sizeof(uint32_t));
+  if (!depth || !leader || !is_ref || !work || !map)
+    fail("Out of memory (register backend)");
+  for (size_t i = 0; i <= code_sz; i++)
+    depth[i] = REG_NO_DEPTH;
+  memset(map, 0xFF, (code_sz + 1) * sizeof(uint32_t));
+  for (int i = 0; i < func_ref_count; i++)
+    is_ref[func_refs[i]] = 1;
+
+  int wn = 0;
+  int max_depth = 0;
+  r_reach(depth, work, &wn, 0, 0);
+  for (int i = 0; i < func_count; i++) {
+    if (funcs[i].addr < code_sz) {
+      leader[funcs[i].addr] = 1;
+      r_reach(depth, work, &wn, funcs[i].addr, funcs[i].arg_count);
+    }
+  }
+  while (wn > 0) {
+    size_t ip = work[--wn];
+    int d = depth[ip];
+    uint8_t op = code[ip];
+    if (d > max_depth)
+      max_depth = d;
+    if (op == OP_JMP || op == OP_JZ || op == OP_TRY) {
+      uint32_t t = r_read32(ip + 1);
+      int td = op == OP_JZ ? d - 1 : op == OP_TRY ? d + 1 : d; // catch: +err
+      r_reach(depth, work, &wn, t, td);
+      leader[t] = 1;
+    }
+    int next = r_effect(ip, d);
+    if (next != REG_NO_DEPTH)
+      r_reach(depth, work, &wn, ip + 1 + op_operand_size(op), next);
+  }
+  // Depths only grow by one slot per instruction, so max_depth + 1 covers
+  // every slot an instruction can write.
+  rslots = calloc(max_depth + 2, sizeof(RegSlot));
+  if (!rslots)
+    fail("Out of memory (register backend)");
+
+  // --- 2. Translation ---
+  rcode_sz = 0;
+  rfix_count = 0;
+  int live = 0; // descriptors describe the current position
+
+  for (size_t ip = 0; ip < code_sz; ip += 1 + op_operand_size(code[ip])) {
+    uint8_t op = code[ip];
+    map[ip] = (uint32_t)rcode_sz;
+    int D = depth[ip];
+    if (D == REG_NO_DEPTH) {
+      live = 0; // unreachable: emit nothing
+      continue;
+    }
+    if (leader[ip] || !live) {
+      if (live)
+        r_flush(0, D);
+      for (int d = 0; d < D; d++)
+        r_set(d, SLOT_REG, 0);
+      map[ip] = (uint32_t)rcode_sz;
+      r_last_pure = 0;
+      live = 1;
+    }
+
+    int rop = r_simple_op(op);
+    size_t w;
+    switch (op) {
+    case OP_CONST_INT:
+      if (is_ref[ip + 1]) {
+        w = r_insn(R_LOADI, 0, D, 1);
+        rcode[w].i.imm = (int32_t)r_read32(ip + 1);
+        r_fixup(w, FIX_IMM, r_read32(ip + 1));
+        r_set(D, SLOT_REG, 0);
+      } else {
+        r_set(D, SLOT_CONST, (int32_t)r_read32(ip + 1));
+      }
+      break;
+    case OP_CONST_FLOAT:
+      r_insn(R_LOADK, 0, D, 1);
+      w = r_word();
+      memcpy(&rcode[w].k, code + ip + 1, 8);
+      r_set(D, SLOT_REG, 0);
+      break;
+    case OP_CONST_STR:
+      w = r_insn(R_LOADS, 0, D, 1);
+      rcode[w].i.imm = (int32_t)r_read32(ip + 1);
+      r_set(D, SLOT_REG, 0);
+      break;
+    case OP_GET_LOCAL: {
+      int x = code[ip + 1];
+      if (rslots[x].kind == SLOT_REG)
+        r_set(D, SLOT_COPY, x);
+      else
+        rslots[D] = rslots[x];
+      break;
+    }
+    case OP_SET_LOCAL: {
+      int x = code[ip + 1], t = D - 1;
+      if (rslots[t].kind == SLOT_COPY && rslots[t].v == x)
+        break; // x = x
+      int copied = 0;
+      for (int d = 0; d < t; d++)
+        if (d != x && rslots[d].kind == SLOT_COPY && rslots[d].v == x)
+          copied = 1;
+      if (rslots[t].kind == SLOT_REG && r_last_pure &&
+          rcode[r_last].i.a == t && !copied) {
+        rcode[r_last].i.a = (uint16_t)x; // compute straight into the local
+      } else {
+        r_clobber(x, t);
+        if (rslots[t].kind == SLOT_CONST) {
+          w = r_insn(R_LOADI, 0, x, 1);
+          rcode[w].i.imm = rslots[t].v;
+        } else {
+          int rs = r_src(t);
+          w = r_insn(R_MOV, 0, x, 1);
+          rcode[w].i.b = (uint16_t)rs;
+        }
+      }
+      r_set(x, SLOT_REG, 0);
+      r_last_pure = 0;
+      break;
+    }
+    case OP_GET_GLOBAL:
+      w = r_insn(R_GETG, 0, D, 1);
+      rcode[w].i.b = code[ip + 1];
+      r_set(D, SLOT_REG, 0);
+      break;
+    case OP_SET_GLOBAL: {
+      int s = r_src(D - 1);
+      w = r_insn(R_SETG, 0, s, 0);
+      rcode[w].i.b = code[ip + 1];
+      break;
+    }
+    case OP_DUP:
+      if (rslots[D - 1].kind == SLOT_REG)
+        r_set(D, SLOT_COPY, D - 1);
+      else
+        rslots[D] = rslots[D - 1];
+      break;
+    case OP_POP:
+      break;
+    case OP_SWAP:
+      if (rslots[D - 1].kind != SLOT_REG && rslots[D - 2].kind != SLOT_REG) {
+        RegSlot tmp = rslots[D - 1];
+        rslots[D - 1] = rslots[D - 2];
+        rslots[D - 2] = tmp;
+      } else {
+        r_flush(D - 2, D);
+        w = r_insn(R_SWAP, 0, D - 2, 0);
+        rcode[w].i.b = (uint16_t)(D - 1);
+      }
+      break;
+
+    case OP_ADD:
+    case OP_SUB:
+    case OP_MUL:
+    case OP_DIV:
+    case OP_MOD:
+    case OP_AND:
+    case OP_OR:
+    case OP_BIT_AND:
+    case OP_BIT_OR:
+    case OP_BIT_XOR:
+    case OP_SHL:
+    case OP_SHR:
+    case OP_LT:
+    case OP_LE:
+    case OP_GT:
+    case OP_GE:
+    case OP_EQ:
+    case OP_NE:
+    case OP_ADD_F:
+    case OP_SUB_F:
+    case OP_MUL_F:
+    case OP_DIV_F:
+    case OP_LT_F:
+    case OP_LE_F:
+    case OP_GT_F:
+    case OP_GE_F:
+    case OP_EQ_F:
+    case OP_NE_F:
+    case OP_STR_CAT:
+    case OP_GET_INDEX: {
+      int a = D - 2, b = D - 1;
+      size_t nip = ip + 1;
+      // <cmp>; JZ t -> one compare-and-branch
+      if (r_cmp_index(op) >= 0 && nip < code_sz && code[nip] == OP_JZ &&
+          !leader[nip]) {
+        int ra = r_src(a);
+        int imm = rslots[b].kind == SLOT_CONST;
+        int rb = imm ? 0 : r_src(b);
+        r_flush(0, a);
+        w = r_insn((imm ? R_JZ_LTI : R_JZ_LT) + r_cmp_index(op), 0, ra, 0);
+        if (imm)
+          rcode[w].i.imm = rslots[b].v;
+        else
+          rcode[w].i.b = (uint16_t)rb;
+        r_fixup(r_word(), FIX_EXT, r_read32(nip + 1));
+        map[nip] = (uint32_t)w;
+        ip = nip; // the loop steps over the JZ
+        break;
+      }
+      // Fold constant int arithmetic that stays in int32 range.
+      if ((op == OP_ADD || op == OP_SUB || op == OP_MUL) &&
+          rslots[a].kind == SLOT_CONST && rslots[b].kind == SLOT_CONST) {
+        int64_t x = rslots[a].v, y = rslots[b].v;
+        int64_t v = op == OP_ADD ? x + y : op == OP_SUB ? x - y : x * y;
+        if (v >= INT32_MIN && v <= INT32_MAX) {
+          r_set(a, SLOT_CONST, (int32_t)v);
+          break;
+        }
+      }
+      // x + k, x - k -> ADDI
+      if ((op == OP_ADD || op == OP_SUB) && rslots[b].kind == SLOT_CONST) {
+        int64_t k = op == OP_ADD ? rslots[b].v : -(int64_t)rslots[b].v;
+        if (k >= INT16_MIN && k <= INT16_MAX) {
+          w = r_insn(R_ADDI, 0, a, 1);
+          rcode[w].i.b = (uint16_t)r_src(a);
+          rcode[w].i.c = (uint16_t)(int16_t)k;
+          r_set(a, SLOT_REG, 0);
+          break;
+        }
+      }
+      int ra = r_src(a), rb = r_src(b);
+      w = r_insn(rop, 0, a, 1);
+      rcode[w].i.b = (uint16_t)ra;
+      rcode[w].i.c = (uint16_t)rb;
+      r_set(a, SLOT_REG, 0);
+      break;
+    }
+    case OP_NEG:
+    case OP_NEG_F:
+    case OP_NOT:
+    case OP_BIT_NOT:
+    case OP_I2F:
+    case OP_F2I:
+    case OP_INT_TO_STR:
+    case OP_FLOAT_TO_STR:
+    case OP_STRBUF_STR: {
+      int rb = r_src(D - 1);
+      w = r_insn(rop, 0, D - 1, 1);
+      rcode[w].i.b = (uint16_t)rb;
+      r_set(D - 1, SLOT_REG, 0);
+      break;
+    }
+    case OP_PRINT:
+    case OP_PRINT_F:
+    case OP_PRINT_STR:
+    case OP_PRINT_CHAR:
+    case OP_FREE:
+    case OP_FREE_STR:
+    case OP_STRBUF_RESET:
+    case OP_STRBUF_FREE: {
+      int ra = r_src(D - 1);
+      r_insn(rop, 0, ra, 0);
+      break;
+    }
+    case OP_PRINT_FMT: {
+      int argc = code[ip + 1];
+      r_flush(D - argc - 1, D);
+      r_insn(R_PRINT_FMT, argc, D - argc - 1, 0);
+      break;
+    }
+    case OP_PRINT_FMT_SEG: {
+      int argc = code[ip + 5];
+      r_flush(D - argc, D);
+      w = r_insn(R_PRINT_FMT_SEG, argc, D - argc, 0);
+      rcode[w].i.imm = (int32_t)r_read32(ip + 1);
+      break;
+    }
+    case OP_STRBUF_NEW:
+      r_insn(R_STRBUF_NEW, 0, D, 1);
+      r_set(D, SLOT_REG, 0);
+      break;
+    case OP_STRBUF_APPEND: {
+      int ra = r_src(D - 2), rb = r_src(D - 1);
+      w = r_insn(R_STRBUF_APPEND, code[ip + 1], ra, 0);
+      rcode[w].i.b = (uint16_t)rb;
+      break;
+    }
+    case OP_STR_CAT_N: {
+      int n = code[ip + 1];
+      r_flush(D - n, D);
+      w = r_insn(R_STR_CAT_N, n, D - n, 0);
+      rcode[w].i.imm = (int32_t)r_read32(ip + 2);
+      r_set(D - n, SLOT_REG, 0);
+      break;
+    }
+
+    case OP_JMP:
+      r_flush(0, D);
+      w = r_insn(R_JMP, 0, 0, 0);
+      r_fixup(w, FIX_TGT, r_read32(ip + 1));
+      live = 0;
+      break;
+    case OP_JZ: {
+      int ra = r_src(D - 1);
+      r_flush(0, D - 1);
+      w = r_insn(R_JZ, 0, ra, 0);
+      r_fixup(w, FIX_TGT, r_read32(ip + 1));
+      break;
+    }
+    case OP_CALL: {
+      int argc = code[ip + 5];
+      r_flush(0, D);
+      w = r_insn(R_CALL, argc, D - argc, 0);
+      r_fixup(w, FIX_TGT, r_read32(ip + 1));
+      for (int d = D - argc; d <= max_depth; d++)
+        r_set(d, SLOT_REG, 0);
+      break;
+    }
+    case OP_CALL_DYN_BOT: {
+      int argc = code[ip + 1];
+      r_flush(0, D);
+      r_insn(R_CALL_DYN, argc, D - argc - 1, 0);
+      for (int d = D - argc - 1; d <= max_depth; d++)
+        r_set(d, SLOT_REG, 0);
+      break;
+    }
+    case OP_RET: {
+      int n = code[ip + 1];
+      r_flush(D - n, D);
+      r_insn(R_RET, n, D - n, 0);
+      live = 0;
+      break;
+    }
+    case OP_HALT:
+      r_insn(R_HALT, 0, 0, 0);
+      live = 0;
+      break;
+
+    case OP_TRY:
+      r_flush(0, D);
+      w = r_insn(R_TRY, 0, D, 0);
+      r_fixup(w, FIX_TGT, r_read32(ip + 1));
+      break;
+    case OP_END_TRY:
+      r_insn(R_END_TRY, 0, 0, 0);
+      break;
+    case OP_THROW: {
+      int ra = r_src(D - 1);
+      r_flush(0, D - 1);
+      r_insn(R_THROW, 0, ra, 0);
+      live = 0;
+      break;
+    }
+
+    case OP_ALLOC_STRUCT:
+    case OP_ALLOC_STACK:
+      r_insn(op == OP_ALLOC_STRUCT ? R_ALLOC_STRUCT : R_ALLOC_STACK, 0, D, 1);
+      w = r_word();
+      rcode[w].u32[0] = r_read32(ip + 1);
+      rcode[w].u32[1] = r_read32(ip + 5);
+      r_set(D, SLOT_REG, 0);
+      break;
+    case OP_ALLOC_ARRAY: {
+      int rb = r_src(D - 1);
+      w = r_insn(R_ALLOC_ARRAY, 0, D - 1, 1);
+      rcode[w].i.b = (uint16_t)rb;
+      w = r_word();
+      rcode[w].u32[0] = r_read32(ip + 1);
+      rcode[w].u32[1] = r_read32(ip + 5);
+      r_set(D - 1, SLOT_REG, 0);
+      break;
+    }
+    case OP_GET_FIELD: {
+      int rb = r_src(D - 1);
+      w = r_insn(R_GET_FIELD, 0, D - 1, 1);
+      rcode[w].i.b = (uint16_t)rb;
+      rcode[w].i.c = code[ip + 1];
+      r_set(D - 1, SLOT_REG, 0);
+      break;
+    }
+    case OP_SET_FIELD: {
+      int ra = r_src(D - 2), rb = r_src(D - 1);
+      w = r_insn(R_SET_FIELD, 0, ra, 0);
+      rcode[w].i.b = (uint16_t)rb;
+      rcode[w].i.c = code[ip + 1];
+      break;
+    }
+    case OP_SET_INDEX: {
+      int ra = r_src(D - 3), rb = r_src(D - 2), rc = r_src(D - 1);
+      w = r_insn(R_SET_INDEX, 0, ra, 0);
+      rcode[w].i.b = (uint16_t)rb;
+      rcode[w].i.c = (uint16_t)rc;
+      break;
+    }
+    case OP_INC_INDEX:
+    case OP_DEC_INDEX: {
+      int ra = r_src(D - 2), rb = r_src(D - 1);
+      w = r_insn(op == OP_INC_INDEX ? R_INC_INDEX : R_DEC_INDEX, 0, ra, 0);
+      rcode[w].i.b = (uint16_t)rb;
+      break;
+    }
+    case OP_TAG_ALLOC: {
+      int ra = r_src(D - 1);
+      w = r_insn(R_TAG_ALLOC, 0, ra, 0);
+      rcode[w].i.imm = (int32_t)r_read32(ip + 1);
+      break;
+    }
+    case OP_NATIVE: {
+      uint32_t nid = r_read32(ip + 1);
+      w = r_insn(R_NATIVE, 0, D, nid <= 1);
+      rcode[w].i.imm = (int32_t)nid;
+      r_set(D, SLOT_REG, 0);
+      break;
+    }
+    case OP_ABYSS_EYE:
+      r_insn(R_ABYSS_EYE, 0, 0, 0);
+      break;
+    case OP_ARENA_BEGIN:
+      r_insn(R_ARENA_BEGIN, 0, 0, 0);
+      break;
+    case OP_ARENA_END:
+      r_insn(R_ARENA_END, 0, 0, 0);
+      break;
+    default:
+      fail("Internal: register backend cannot translate opcode %d", op);
+    }
+  }
+  map[code_sz] = (uint32_t)rcode_sz;
+
+  // --- 3. Code addresses -> word indices ---
+  for (int i = 0; i < rfix_count; i++) {
+    uint32_t old = rfix[i].old;
+    if (old > code_sz || depth[old] == REG_NO_DEPTH)
+      fail("Internal: register backend found a jump to an unreachable "
+           "address (%u)",
+           old);
+    if (rfix[i].kind == FIX_EXT)
+      rcode[rfix[i].word].u32[0] = map[old];
+    else if (rfix[i].kind == FIX_IMM)
+      rcode[rfix[i].word].i.imm = (int32_t)map[old];
+    else
+      rcode[rfix[i].word].i.tgt = map[old];
+  }
+  for (int i = 0; i < func_count; i++)
+    if (funcs[i].addr < code_sz)
+      funcs[i].addr = map[funcs[i].addr];
+  codegen_remap_lines(map, code_sz);
+
+  size_t words = rcode_sz;
+  codegen_replace((uint8_t *)rcode, rcode_sz * sizeof(RegWord),
+                  rcode_cap * sizeof(RegWord));
+  rcode = NULL;
+  rcode_sz = rcode_cap = 0;
+  free(rslots);
+  rslots = NULL;
+  free(depth);
+  free(leader);
+  free(is_ref);
+  free(work);
+  free(map);
+  return words;
+}
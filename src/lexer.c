@@ -11,6 +11,7 @@ typedef struct FileContext {
   size_t pos;
   int line;
   int col;
+  int file;
   Token saved_tok; // Save the lookahead token
   struct FileContext *prev;
 } FileContext;
@@ -32,12 +33,35 @@ static int is_loaded(const char *path) {
   return 0;
 }
 
+// Every file name ever read, never freed: tokens and the line table refer
+// to them by index.
+static char *file_names[MAX_LOADED_FILES + 1];
+static int file_name_count = 0;
+
+static int file_id(const char *path) {
+  for (int i = 0; i < file_name_count; i++)
+    if (!strcmp(file_names[i], path))
+      return i;
+  file_names[file_name_count] = strdup(path);
+  return file_name_count++;
+}
+
+const char *lexer_file_name(int file) { return file_names[file]; }
+int lexer_file_count(void) { return file_name_count; }
+
 static char *src;
 static size_t pos = 0;
 static int line = 1;
 static int col = 1;
+static int file = 0;
+static int last_line = 1, last_file = 0;
 Token cur;
 
+void lexer_last_pos(int *f, int *l) {
+  *f = last_file;
+  *l = last_line;
+}
+
 static const char *tk_names[] = {[TK_EOF] = "EOF",
                                  [TK_ID] = "Identifier",
                                  [TK_IMPORT] = "import",
@@ -84,11 +108,12 @@ void print_error_context() {
   fprintf(stderr, "\033[1;31m^ HERE\033[0m\n\n");
 }
 
-void lexer_init(char *source) {
+void lexer_init(char *source, const char *filename) {
   src = source;
   pos = 0;
   line = 1;
   col = 1;
+  file = file_id(filename);
   cur.text = NULL;
 }
 
@@ -99,6 +124,10 @@ void lexer_reset_to_start(void) {
   pos = 0;
   line = 1;
   col = 1;
+  file = 0;
+  last_line = 1;
+  last_file = 0;
+  cur.line = 0;
   if (cur.text) {
     free(cur.text);
     cur.text = NULL;
@@ -144,6 +173,7 @@ void lexer_include(char *filename) {
   ctx->pos = pos;
   ctx->line = line;
   ctx->col = col;
+  ctx->file = file;
   ctx->saved_tok = cur; // Save the token we already read
 
   // Steal ownership of text so it isn't freed
@@ -157,6 +187,7 @@ void lexer_include(char *filename) {
   pos = 0;
   line = 1;
   col = 1;
+  file = file_id(filename);
 
   // Prime the first token of the new file
   next();
@@ -166,6 +197,7 @@ TkKind peek_kind() {
   size_t saved_pos = pos;
   int saved_line = line;
   int saved_col = col;
+  int saved_last_line = last_line, saved_last_file = last_file;
   Token saved_cur = cur;
   if (saved_cur.text)
     saved_cur.text = strdup(saved_cur.text);
@@ -179,6 +211,8 @@ TkKind peek_kind() {
   pos = saved_pos;
   line = saved_line;
   col = saved_col;
+  last_line = saved_last_line;
+  last_file = saved_last_file;
 
   return k;
 }
@@ -187,6 +221,10 @@ void next() {
   if (cur.text)
     free(cur.text);
   cur.text = NULL;
+  if (cur.line) {
+    last_line = cur.line;
+    last_file = cur.file;
+  }
 
   while (1) {
     while (src[pos] && isspace(src[pos])) {
@@ -228,6 +266,7 @@ void next() {
 
   cur.line = line;
   cur.col = col;
+  cur.file = file;
 
   if (!src[pos]) {
     if (ctx_stack) {
@@ -239,6 +278,7 @@ void next() {
       pos = ctx->pos;
       line = ctx->line;
       col = ctx->col;
+      file = ctx->file;
 
       // Restore the saved token
       cur = ctx->saved_tok;
@@ -270,6 +310,8 @@ void next() {
       cur.kind = TK_VOID;
     else if (!strcmp(cur.text, "str"))
       cur.kind = TK_STR_TYPE;
+    else if (!strcmp(cur.text, "strbuf"))
+      cur.kind = TK_STRBUF_TYPE;
     else if (!strcmp(cur.text, "struct"))
       cur.kind = TK_STRUCT;
     else if (!strcmp(cur.text, "new"))
@@ -312,6 +354,8 @@ void next() {
       cur.kind = TK_CONTINUE;
     else if (!strcmp(cur.text, "null"))
       cur.kind = TK_NULL;
+    else if (!strcmp(cur.text, "arena"))
+      cur.kind = TK_ARENA;
     else
       cur.kind = TK_ID;
     return;
@@ -1,15 +1,109 @@
+#include "../include/cache.h"
 #include "../include/codegen.h"
 #include "../include/common.h"
 #include "../include/lexer.h"
 #include "../include/native.h"
 #include "../include/parser.h"
+#include "../include/peephole.h"
 #include "../include/symbols.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define ABYSS_VERSION "0.1.0"
 
+// --- NATIVE BUILD ---
+// One unit builds with LTO. Split units compile separately without it: the
+// per-unit gcc runs are then the whole cost and run in parallel, where
+// -flto would push most of the work into a link step that is largely
+// serial. -ffp-contract=off keeps a * b + c as two rounded operations, as
+// in the VM: fused into an FMA, float results drift from the VM's.
+#define NATIVE_STEM "abyss_native_temp"
+#define NATIVE_CFLAGS                                                         \
+  "-O3 -g -march=native -fno-strict-aliasing -ffp-contract=off -Wall "        \
+  "-Wno-unused-variable -Wno-unused-label -Wno-unused-parameter "             \
+  "-Wno-unused-but-set-variable -Wno-infinite-recursion "                     \
+  "-D_POSIX_C_SOURCE=200809L"
+#define NATIVE_CC_ONE "gcc " NATIVE_CFLAGS " -flto=auto -o %s %s -lm"
+#define NATIVE_CC_UNIT "gcc " NATIVE_CFLAGS " -c -o %s %s"
+// What the flags above mean on this host, for the compile cache key: the
+// gcc version and the target -march=native resolves to (CPU and ISA flags).
+#define NATIVE_PROBE                                                          \
+  "gcc -dumpfullversion && gcc -march=native -Q --help=target"
+
+// Object file of a unit source: x.c -> x.o.
+static char *obj_path(const char *src) {
+  char *path = strdup(src);
+  path[strlen(path) - 1] = 'o';
+  return path;
+}
+
+// Runs cmds through the shell, at most jobs at a time. Returns 0 if all of
+// them succeed; after a failure no further command starts.
+static int run_jobs(char **cmds, int n, int jobs) {
+  int next = 0, running = 0, failed = 0;
+  fflush(stdout);
+  while (next < n || running) {
+    while (!failed && next < n && running < jobs) {
+      pid_t pid = fork();
+      if (pid == 0) {
+        execl("/bin/sh", "sh", "-c", cmds[next], (char *)NULL);
+        _exit(127);
+      }
+      if (pid < 0) {
+        failed = 1;
+        break;
+      }
+      next++;
+      running++;
+    }
+    if (!running)
+      break;
+    int status;
+    if (wait(&status) < 0)
+      return 1;
+    running--;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      failed = 1;
+  }
+  return failed;
+}
+
+// Compiles the units of a split program in parallel and links them.
+static int build_units(NativeFile *files, int units, int jobs,
+                       const char *out_file) {
+  char **cmds = malloc(units * sizeof(char *));
+  size_t link_cap = strlen(out_file) + 64;
+  for (int i = 0; i < units; i++)
+    link_cap += strlen(files[i].path) + 1;
+  char *link = malloc(link_cap);
+  size_t len = snprintf(link, link_cap, "gcc -g -o %s", out_file);
+  for (int i = 0; i < units; i++) {
+    char *obj = obj_path(files[i].path);
+    size_t cap = sizeof(NATIVE_CC_UNIT) + 2 * strlen(files[i].path);
+    cmds[i] = malloc(cap);
+    snprintf(cmds[i], cap, NATIVE_CC_UNIT, obj, files[i].path);
+    len += snprintf(link + len, link_cap - len, " %s", obj);
+    free(obj);
+  }
+  snprintf(link + len, link_cap - len, " -lm");
+
+  int res = run_jobs(cmds, units, jobs);
+  if (res == 0)
+    res = system(link);
+  for (int i = 0; i < units; i++) {
+    char *obj = obj_path(files[i].path);
+    remove(obj);
+    free(obj);
+    free(cmds[i]);
+  }
+  free(cmds);
+  free(link);
+  return res;
+}
+
 int main(int argc, char **argv) {
   if (argc > 1) {
     if (strcmp(argv[1], "--version") == 0 || strcmp(argv[1], "-v") == 0) {
@@ -20,6 +114,10 @@ int main(int argc, char **argv) {
 
   int is_native = 0;
   int enable_eye = 0;
+  int enable_fuse = 1;
+  int is_register = 0;
+  int use_cache = 1;
+  long jobs = sysconf(_SC_NPROCESSORS_ONLN);
   char *src_file = NULL;
   char *out_file = NULL;
 
@@ -32,15 +130,35 @@ int main(int argc, char **argv) {
     } else if (strcmp(argv[argi], "--eye") == 0) {
       enable_eye = 1;
       argi++;
+    } else if (strcmp(argv[argi], "--no-fuse") == 0) {
+      enable_fuse = 0;
+      argi++;
+    } else if (strcmp(argv[argi], "--register") == 0) {
+      is_register = 1;
+      argi++;
+    } else if (strcmp(argv[argi], "--no-cache") == 0) {
+      use_cache = 0;
+      argi++;
+    } else if (strncmp(argv[argi], "-j", 2) == 0) {
+      // -jN or -j N: gcc processes for a split native build.
+      const char *n = argv[argi][2] ? argv[argi] + 2 : NULL;
+      argi++;
+      if (!n && argi < argc)
+        n = argv[argi++];
+      jobs = n ? strtol(n, NULL, 10) : jobs;
     } else {
       argi++;
     }
   }
   if (argi + 2 > argc) {
-    fprintf(stderr, "Usage: %s [--native] [--eye] <source.al> <output>\n",
+    fprintf(stderr,
+            "Usage: %s [--native] [--eye] [--no-fuse] [--register] "
+            "[--no-cache] [-j N] <source.al> <output>\n",
             argv[0]);
     return 1;
   }
+  if (jobs < 1)
+    jobs = 1;
   src_file = argv[argi];
   out_file = argv[argi + 1];
 
@@ -59,7 +177,7 @@ int main(int argc, char **argv) {
   fclose(f);
 
   // Init Modules
-  lexer_init(src);
+  lexer_init(src, src_file);
   codegen_init();
   symbols_init();
 
@@ -75,29 +193,78 @@ int main(int argc, char **argv) {
   }
   emit(OP_HALT);
 
+  // Superinstruction fusion over the finished program. Both backends consume
+  // the fused bytecode. The register backend translates the plain stack
+  // program instead: its operands already cover what fusion would save.
+  if (is_register && !is_native)
+    codegen_register_program();
+  else if (enable_fuse)
+    peephole_optimize();
+
   // --- NEW: NATIVE COMPILATION ROUTINE ---
   if (is_native) {
     printf("⚡ Translating AbyssLang to Native C...%s\n",
            enable_eye ? " (Abyss Eye: ON)" : "");
-    generate_native_code("abyss_native_temp.c", enable_eye);
-
-    char cmd[1024];
-    snprintf(cmd, sizeof(cmd),
-             "gcc -O3 -flto=auto -march=native -fno-strict-aliasing -Wall "
-             "-Wno-unused-variable -Wno-unused-label -Wno-unused-parameter "
-             "-D_POSIX_C_SOURCE=200809L "
-             "-o %s abyss_native_temp.c -lm",
-             out_file);
-    printf("🔨 Compiling Native Binary: %s\n", out_file);
-    int res = system(cmd);
-
-    if (res == 0) {
-      printf("✅ Native compilation successful! Run with: ./%s\n", out_file);
-      remove("abyss_native_temp.c"); // Clean up the temp file
+    // The C goes to a fresh directory, so concurrent builds never see each
+    // other's files; the unit names inside it stay fixed.
+    const char *tmp = getenv("TMPDIR");
+    char dir[1024], stem[1100];
+    snprintf(dir, sizeof(dir), "%s/abyss_native_XXXXXX",
+             tmp && *tmp ? tmp : "/tmp");
+    if (!mkdtemp(dir)) {
+      fprintf(stderr, "Cannot create a build directory: %s\n", dir);
+      return 1;
+    }
+    snprintf(stem, sizeof(stem), "%s/" NATIVE_STEM, dir);
+    NativeFile *files;
+    int units = generate_native_code(stem, enable_eye, &files);
+    // The unit sources, and the shared header when split.
+    int file_count = units > 1 ? units + 1 : 1;
+    char **texts = malloc(file_count * sizeof(char *));
+    size_t *lens = malloc(file_count * sizeof(size_t));
+    for (int i = 0; i < file_count; i++) {
+      texts[i] = files[i].text;
+      lens[i] = files[i].len;
+    }
+
+    // The format string, not the expanded command, goes into the cache key:
+    // neither the output path nor the build directory changes the binary.
+    const char *cc_fmt = units > 1 ? NATIVE_CC_UNIT : NATIVE_CC_ONE;
+    char key[CACHE_KEY_LEN];
+    if (use_cache &&
+        !cache_key(texts, lens, file_count, cc_fmt, NATIVE_PROBE, key))
+      use_cache = 0;
+    int res, hit = use_cache && cache_fetch(key, out_file);
+    if (hit) {
+      printf("♻️  Reusing cached native binary: %s\n", out_file);
+      res = 0;
+    } else if (units > 1) {
+      printf("🔨 Compiling Native Binary: %s (%d units, %ld jobs)\n",
+             out_file, units, jobs);
+      res = build_units(files, units, (int)jobs, out_file);
     } else {
-      printf("❌ Native compilation failed.\n");
+      size_t cap = sizeof(NATIVE_CC_ONE) + strlen(out_file) +
+                   strlen(files[0].path);
+      char *cmd = malloc(cap);
+      snprintf(cmd, cap, NATIVE_CC_ONE, out_file, files[0].path);
+      printf("🔨 Compiling Native Binary: %s\n", out_file);
+      res = system(cmd);
+      free(cmd);
+    }
+
+    if (res != 0) {
+      printf("❌ Native compilation failed. Generated C kept in %s\n", dir);
+      return res;
+    }
+    if (!hit) {
+      printf("✅ Native compilation successful! Run with: ./%s\n", out_file);
+      if (use_cache)
+        cache_store(key, out_file);
     }
-    return res;
+    for (int i = 0; i < file_count; i++)
+      remove(files[i].path); // Clean up the temp files
+    rmdir(dir);
+    return 0;
   }
 
   // --- STANDARD BYTECODE OUTPUT ---
@@ -107,31 +274,98 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  fwrite(MAGIC, 1, 7, f);
-  uint8_t ver = VERSION;
-  fwrite(&ver, 1, 1, f);
-
-  fwrite(&str_count, 4, 1, f);
+  // Lay out the sections first (see BcHeader), then write them in order.
+  size_t size = codegen_size();
+  uint8_t *buffer = codegen_buffer();
+#define BC_ALIGN_UP(x) (((x) + BC_ALIGN - 1) & ~(size_t)(BC_ALIGN - 1))
+  BcHeader h = {.version = VERSION,
+                .flags = is_register ? BC_FLAG_REGISTER : 0,
+                .str_count = str_count,
+                .struct_count = struct_count};
+  memcpy(h.magic, MAGIC, 7);
+  size_t off = BC_ALIGN_UP(sizeof(h));
+  h.str_index = off;
+  off = BC_ALIGN_UP(off + str_count * sizeof(uint32_t));
+  h.struct_table = off;
+  off = BC_ALIGN_UP(off + struct_count * sizeof(BcStruct));
+  BcFunc *ftable = malloc((func_count + 1) * sizeof(BcFunc));
+  int *fidx = malloc((func_count + 1) * sizeof(int));
+  for (int i = 0; i < func_count; i++)
+    if (funcs[i].addr < size) {
+      fidx[h.func_count] = i;
+      ftable[h.func_count++] = (BcFunc){.addr = funcs[i].addr,
+                                        .argc = funcs[i].arg_count,
+                                        .rets = funcs[i].ret_count};
+    }
+  h.func_table = off;
+  off += h.func_count * sizeof(BcFunc);
+  h.fmt_count = fmt_seg_count;
+  h.fmt_table = off;
+  off += fmt_seg_count * sizeof(BcFmtSeg);
+  BcLine *ltable = malloc((src_line_count + 1) * sizeof(BcLine));
+  h.line_count = src_line_count;
+  h.line_table = off;
+  off += src_line_count * sizeof(BcLine);
+  uint32_t *index = malloc((str_count + 1) * sizeof(uint32_t));
+  BcStruct *table = malloc((struct_count + 1) * sizeof(BcStruct));
   for (int i = 0; i < str_count; i++) {
-    uint32_t len = strlen(strs[i]);
-    fwrite(&len, 4, 1, f);
-    fwrite(strs[i], 1, len, f);
+    index[i] = off + STR_HDR;
+    off += STR_HDR + strlen(strs[i]) + 1;
   }
-
-  fwrite(&struct_count, 4, 1, f);
   for (int i = 0; i < struct_count; i++) {
-    uint32_t len = strlen(structs[i].name);
-    fwrite(&len, 4, 1, f);
-    fwrite(structs[i].name, 1, len, f);
-    uint32_t size = structs[i].size;
-    fwrite(&size, 4, 1, f);
+    table[i] = (BcStruct){(uint32_t)off, (uint32_t)structs[i].size};
+    off += strlen(structs[i].name) + 1;
   }
+  for (uint32_t i = 0; i < h.func_count; i++) {
+    ftable[i].name = off;
+    off += strlen(funcs[fidx[i]].name) + 1;
+  }
+  uint32_t *file_off = malloc((lexer_file_count() + 1) * sizeof(uint32_t));
+  for (int i = 0; i < lexer_file_count(); i++) {
+    file_off[i] = off;
+    off += strlen(lexer_file_name(i)) + 1;
+  }
+  for (int i = 0; i < src_line_count; i++)
+    ltable[i] = (BcLine){src_lines[i].addr, (uint32_t)src_lines[i].line,
+                         file_off[src_lines[i].file]};
+  size_t data_end = off;
+  h.code = BC_ALIGN_UP(off);
+  h.code_size = size;
+  h.file_size = h.code + size + BC_PAD;
 
-  size_t size = codegen_size();
-  uint8_t *buffer = codegen_buffer();
-
-  fwrite(&size, 4, 1, f);
+  static const uint8_t zeros[BC_ALIGN + BC_PAD];
+  fwrite(&h, sizeof(h), 1, f);
+  fwrite(zeros, 1, h.str_index - sizeof(h), f);
+  fwrite(index, sizeof(uint32_t), str_count, f);
+  fwrite(zeros, 1, h.struct_table - (h.str_index + str_count * 4), f);
+  fwrite(table, sizeof(BcStruct), struct_count, f);
+  fwrite(zeros, 1,
+         h.func_table - (h.struct_table + struct_count * sizeof(BcStruct)), f);
+  fwrite(ftable, sizeof(BcFunc), h.func_count, f);
+  if (fmt_seg_count) // fmt_segs stays NULL until the first segment
+    fwrite(fmt_segs, sizeof(BcFmtSeg), fmt_seg_count, f);
+  fwrite(ltable, sizeof(BcLine), src_line_count, f);
+  for (int i = 0; i < str_count; i++) {
+    uint32_t len = strlen(strs[i]);
+    fwrite(&len, STR_HDR, 1, f);
+    fwrite(strs[i], 1, len + 1, f);
+  }
+  for (int i = 0; i < struct_count; i++)
+    fwrite(structs[i].name, 1, strlen(structs[i].name) + 1, f);
+  for (uint32_t i = 0; i < h.func_count; i++)
+    fwrite(funcs[fidx[i]].name, 1, strlen(funcs[fidx[i]].name) + 1, f);
+  for (int i = 0; i < lexer_file_count(); i++)
+    fwrite(lexer_file_name(i), 1, strlen(lexer_file_name(i)) + 1, f);
+  fwrite(zeros, 1, h.code - data_end, f);
   fwrite(buffer, 1, size, f);
+  fwrite(zeros, 1, BC_PAD, f);
+#undef BC_ALIGN_UP
+  free(index);
+  free(table);
+  free(ftable);
+  free(fidx);
+  free(ltable);
+  free(file_off);
 
   fclose(f);
 
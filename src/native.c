@@ -1,46 +1,1903 @@
 #include "../include/native.h"
 #include "../include/codegen.h"
 #include "../include/common.h"
+#include "../include/lexer.h"
 #include "../include/symbols.h"
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-void generate_native_code(const char *out_filename, int enable_profiler) {
-  FILE *f = fopen(out_filename, "w");
+// C operator for each compare-and-branch superinstruction, in the order the
+// LT/LE/GT/GE/EQ/NE variants appear in the opcode enum.
+static const char *cmp_ops[] = {"<", "<=", ">", ">=", "==", "!="};
+
+// Points the C that follows at the .al line it was compiled from.
+static void line_directive(FILE *f, const SrcLine *l) {
+  fprintf(f, "#line %d \"", l->line);
+  for (const char *c = lexer_file_name(l->file); *c; c++)
+    fprintf(f, *c == '"' || *c == '\\' ? "\\%c" : "%c", *c);
+  fprintf(f, "\"\n");
+}
+
+// --- Code regions ---
+// Every AbyssLang function becomes its own C function and top-level code
+// (global initializers, then the entry call) becomes main(). Top-level code
+// is interleaved with the function bodies it jumps around, so instructions
+// are assigned to regions by following control flow from each entry, as the
+// VM's verifier does; code nothing reaches is not emitted.
+#define TOP_LEVEL -1
+#define UNREACHED -2
+
+static int *owner;         // region of each instruction start
+static FuncInfo **fn_info; // emitted functions, by ascending entry address
+static int fn_count;
+static int *fn_try; // function contains OP_TRY
+// Only jump and catch targets get a C label, and only functions the
+// program can reach get a C function. Interface calls can only reach
+// functions whose address the program takes (func_refs).
+static uint8_t *is_target;
+static uint8_t *fn_live;
+static uint8_t *fn_ref;
+static int has_dyn_call;
+
+// Target of a jump, compare-and-branch or OP_TRY at ip, if it has one.
+static int jump_target(size_t ip, uint32_t *t) {
+  uint8_t op = code[ip];
+  size_t at;
+  if (op == OP_JMP || op == OP_JZ || op == OP_TRY ||
+      (op >= OP_LT_JZ && op <= OP_NE_JZ))
+    at = ip + 1;
+  else if (op >= OP_LOCAL_CONST_LT_JZ && op <= OP_LOCAL_CONST_NE_JZ)
+    at = ip + 6;
+  else if (op >= OP_LOCAL_LOCAL_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ)
+    at = ip + 3;
+  else
+    return 0;
+  memcpy(t, code + at, 4);
+  return 1;
+}
+
+static void claim(size_t *work, uint32_t start, int region) {
+  size_t n = 0;
+  work[n++] = start;
+  while (n) {
+    size_t ip = work[--n];
+    if (ip >= code_sz) {
+      fprintf(stderr, "FATAL: control flow leaves the code at %zu!\n", ip);
+      exit(1);
+    }
+    if (owner[ip] == region)
+      continue;
+    if (owner[ip] != UNREACHED) {
+      fprintf(stderr, "FATAL: bytecode at %zu belongs to two functions!\n",
+              ip);
+      exit(1);
+    }
+    owner[ip] = region;
+    uint8_t op = code[ip];
+    uint32_t t;
+    if (jump_target(ip, &t)) {
+      work[n++] = t;
+      is_target[t] = 1;
+    }
+    if (op == OP_TRY && region != TOP_LEVEL)
+      fn_try[region] = 1;
+    if (op != OP_JMP && op != OP_RET && op != OP_THROW && op != OP_HALT)
+      work[n++] = ip + 1 + op_operand_size(op);
+  }
+}
+
+static int fn_addr_cmp(const void *a, const void *b) {
+  uint32_t x = (*(FuncInfo *const *)a)->addr;
+  uint32_t y = (*(FuncInfo *const *)b)->addr;
+  return (x > y) - (x < y);
+}
+
+static void find_regions(void) {
+  fn_info = malloc((func_count + 1) * sizeof(FuncInfo *));
+  fn_count = 0;
+  for (int i = 0; i < func_count; i++)
+    if (funcs[i].addr < code_sz)
+      fn_info[fn_count++] = &funcs[i];
+  qsort(fn_info, fn_count, sizeof(FuncInfo *), fn_addr_cmp);
+  int n = 0;
+  for (int k = 0; k < fn_count; k++)
+    if (n == 0 || fn_info[k]->addr != fn_info[n - 1]->addr)
+      fn_info[n++] = fn_info[k];
+  fn_count = n;
+
+  fn_try = calloc(fn_count + 1, sizeof(int));
+  is_target = calloc(code_sz + 1, 1);
+  owner = malloc((code_sz + 1) * sizeof(int));
+  for (size_t i = 0; i <= code_sz; i++)
+    owner[i] = UNREACHED;
+  // Each instruction pushes at most two successors.
+  size_t *work = malloc((2 * code_sz + 1) * sizeof(size_t));
+  claim(work, 0, TOP_LEVEL);
+  for (int k = 0; k < fn_count; k++)
+    claim(work, fn_info[k]->addr, k);
+  free(work);
+}
+
+static int fn_index(uint32_t addr) {
+  int lo = 0, hi = fn_count - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (fn_info[mid]->addr == addr)
+      return mid;
+    if (fn_info[mid]->addr < addr)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+  fprintf(stderr, "FATAL: call to %u, which is no function entry!\n", addr);
+  exit(1);
+}
+
+// Code of function k lies in [fn_info[k]->addr, fn_end(k)).
+static size_t fn_end(int k) {
+  return k + 1 < fn_count ? fn_info[k + 1]->addr : code_sz;
+}
+
+// Marks the functions reachable from top-level code, by direct calls or
+// through a function reference, and the referenced ones in fn_ref; notes
+// whether reachable code makes interface calls at all.
+static void find_live(void) {
+  fn_live = calloc(fn_count + 1, 1);
+  fn_ref = calloc(fn_count + 1, 1);
+  int *work = malloc((fn_count + 1) * sizeof(int)), n = 0;
+  for (int i = 0; i < func_ref_count; i++) {
+    uint32_t addr;
+    memcpy(&addr, code + func_refs[i], 4);
+    int k = fn_index(addr);
+    fn_ref[k] = 1;
+    if (!fn_live[k])
+      fn_live[k] = 1, work[n++] = k;
+  }
+  has_dyn_call = 0;
+  int r = TOP_LEVEL;
+  for (;;) {
+    size_t from = r == TOP_LEVEL ? 0 : fn_info[r]->addr;
+    size_t to = r == TOP_LEVEL ? code_sz : fn_end(r);
+    for (size_t ip = from; ip < to; ip += 1 + op_operand_size(code[ip])) {
+      uint32_t addr;
+      if (owner[ip] != r)
+        continue;
+      if (code[ip] == OP_CALL_DYN_BOT)
+        has_dyn_call = 1;
+      if (code[ip] != OP_CALL)
+        continue;
+      memcpy(&addr, code + ip + 1, 4);
+      int k = fn_index(addr);
+      if (!fn_live[k])
+        fn_live[k] = 1, work[n++] = k;
+    }
+    if (!n)
+      break;
+    r = work[--n];
+  }
+  free(work);
+}
+
+// fn_<entry>_<name>: unique, and readable in perf and gdb.
+static void fn_name(FILE *f, int k) {
+  fprintf(f, "fn_%u_", fn_info[k]->addr);
+  for (const char *c = fn_info[k]->name; *c; c++)
+    fputc(isalnum((unsigned char)*c) ? *c : '_', f);
+}
+
+// Translates the instruction at ip, which belongs to region.
+static void emit_insn(FILE *f, size_t ip, int region, int enable_profiler) {
+  uint8_t op = code[ip++];
+
+  switch (op) {
+  case OP_HALT:
+    fprintf(f, region == TOP_LEVEL ? "  goto cleanup;\n" : "  exit(0);\n");
+    break;
+  case OP_CONST_INT: {
+    int32_t v;
+    memcpy(&v, code + ip, 4);
+    ip += 4;
+    fprintf(f, "  stack[sp++].i = %d;\n", v);
+    break;
+  }
+  case OP_CONST_FLOAT: {
+    uint64_t v;
+    memcpy(&v, code + ip, 8);
+    ip += 8;
+    // Emit as hex literal cast from unsigned to signed. This is safe
+    // for every possible IEEE-754 bit pattern, including future NaN,
+    // Infinity, and hex-float literals that could set the high bit.
+    fprintf(f, "  stack[sp++].i = (int64_t)0x%016lxULL;\n", v);
+    break;
+  }
+  case OP_CONST_STR: {
+    uint32_t v;
+    memcpy(&v, code + ip, 4);
+    ip += 4;
+    fprintf(f, "  stack[sp++].p = strs[%u];\n", v);
+    break;
+  }
+
+  case OP_ADD:
+    fprintf(f, "  stack[sp-2].i += stack[sp-1].i; sp--;\n");
+    break;
+  case OP_SUB:
+    fprintf(f, "  stack[sp-2].i -= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_MUL:
+    fprintf(f, "  stack[sp-2].i *= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_DIV:
+    fprintf(f, "  stack[sp-2].i /= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_MOD:
+    fprintf(f, "  stack[sp-2].i %%= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_NEG:
+    fprintf(f, "  stack[sp-1].i = -stack[sp-1].i;\n");
+    break;
+
+  case OP_ADD_F:
+    fprintf(f, "  stack[sp-2].f += stack[sp-1].f; sp--;\n");
+    break;
+  case OP_SUB_F:
+    fprintf(f, "  stack[sp-2].f -= stack[sp-1].f; sp--;\n");
+    break;
+  case OP_MUL_F:
+    fprintf(f, "  stack[sp-2].f *= stack[sp-1].f; sp--;\n");
+    break;
+  case OP_DIV_F:
+    fprintf(f, "  stack[sp-2].f /= stack[sp-1].f; sp--;\n");
+    break;
+  case OP_NEG_F:
+    fprintf(f, "  stack[sp-1].f = -stack[sp-1].f;\n");
+    break;
+
+  case OP_LT:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].i < stack[sp-1].i); sp--;\n");
+    break;
+  case OP_LE:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].i <= stack[sp-1].i); sp--;\n");
+    break;
+  case OP_GT:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].i > stack[sp-1].i); sp--;\n");
+    break;
+  case OP_GE:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].i >= stack[sp-1].i); sp--;\n");
+    break;
+  case OP_EQ:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].i == stack[sp-1].i); sp--;\n");
+    break;
+  case OP_NE:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].i != stack[sp-1].i); sp--;\n");
+    break;
+
+  case OP_LT_F:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].f < stack[sp-1].f); sp--;\n");
+    break;
+  case OP_LE_F:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].f <= stack[sp-1].f); sp--;\n");
+    break;
+  case OP_GT_F:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].f > stack[sp-1].f); sp--;\n");
+    break;
+  case OP_GE_F:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].f >= stack[sp-1].f); sp--;\n");
+    break;
+  case OP_EQ_F:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].f == stack[sp-1].f); sp--;\n");
+    break;
+  case OP_NE_F:
+    fprintf(f, "  stack[sp-2].i = (stack[sp-2].f != stack[sp-1].f); sp--;\n");
+    break;
+
+  case OP_AND:
+    fprintf(f, "  stack[sp-2].i = stack[sp-2].i && stack[sp-1].i; sp--;\n");
+    break;
+  case OP_OR:
+    fprintf(f, "  stack[sp-2].i = stack[sp-2].i || stack[sp-1].i; sp--;\n");
+    break;
+  case OP_NOT:
+    fprintf(f, "  stack[sp-1].i = !stack[sp-1].i;\n");
+    break;
+
+  case OP_BIT_AND:
+    fprintf(f, "  stack[sp-2].i &= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_BIT_OR:
+    fprintf(f, "  stack[sp-2].i |= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_BIT_XOR:
+    fprintf(f, "  stack[sp-2].i ^= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_SHL:
+    fprintf(f, "  stack[sp-2].i <<= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_SHR:
+    fprintf(f, "  stack[sp-2].i >>= stack[sp-1].i; sp--;\n");
+    break;
+  case OP_BIT_NOT:
+    fprintf(f, "  stack[sp-1].i = ~stack[sp-1].i;\n");
+    break;
+
+  case OP_JMP: {
+    uint32_t t;
+    memcpy(&t, code + ip, 4);
+    ip += 4;
+    fprintf(f, "  goto L_%u;\n", t);
+    break;
+  }
+  case OP_JZ: {
+    uint32_t t;
+    memcpy(&t, code + ip, 4);
+    ip += 4;
+    fprintf(f, "  if (!stack[--sp].i) goto L_%u;\n", t);
+    break;
+  }
+
+  case OP_PRINT:
+    fprintf(f, "  out_int(stack[--sp].i); out_char('\\n');\n");
+    break;
+  case OP_PRINT_F:
+    fprintf(f, "  out_float(stack[--sp].f); out_char('\\n');\n");
+    break;
+  case OP_PRINT_STR:
+    fprintf(f, "  out_lstr((char*)stack[--sp].p); out_char('\\n');\n");
+    break;
+  case OP_PRINT_CHAR:
+    fprintf(f, "  out_char((char)stack[--sp].i);\n");
+    break;
+  case OP_PRINT_FMT: {
+    uint8_t argc = code[ip++];
+    fprintf(
+        f,
+        "  { uint8_t argc = %u; char *fmt = (char *)stack[sp - 1 - argc].p; "
+        "int current_arg = 0; for (int i = 0; fmt[i]; i++) { if (fmt[i] == "
+        "'%%') { i++; if (fmt[i] == '{') i++; char type_buf[32]; int ti = 0; "
+        "while (fmt[i] && isalpha(fmt[i]) && ti < 31) type_buf[ti++] = "
+        "fmt[i++]; type_buf[ti] = 0; if (fmt[i] != '}') i--; if "
+        "(current_arg < argc) { Value val = stack[sp - argc + current_arg]; "
+        "if (!strcmp(type_buf, \"int\") || !strcmp(type_buf, \"integer\")) "
+        "out_int(val.i); else if (!strcmp(type_buf, \"float\")) "
+        "out_float(val.f); else if (!strcmp(type_buf, \"str\") || "
+        "!strcmp(type_buf, \"string\")) out_lstr((char *)val.p); else "
+        "if (!strcmp(type_buf, \"char\")) out_char((char)val.i); "
+        "current_arg++; } } else out_char(fmt[i]); } out_char('\\n'); sp -= "
+        "(argc + 1); }\n",
+        argc);
+    break;
+  }
+
+  case OP_PRINT_FMT_SEG: {
+    // Segments are known here, so the splice is emitted inline.
+    uint32_t first;
+    memcpy(&first, code + ip, 4);
+    uint8_t argc = code[ip + 4];
+    ip += 5;
+    fprintf(f, "  {");
+    int arg = 0;
+    for (const BcFmtSeg *s = fmt_segs + first;; s++) {
+      if (s->len)
+        fprintf(f, " out_mem(strs[%u], %u);", s->lit, s->len);
+      if (s->kind == FMT_END)
+        break;
+      int back = argc - arg++;
+      if (s->kind == FMT_INT)
+        fprintf(f, " out_int(stack[sp - %d].i);", back);
+      else if (s->kind == FMT_FLOAT)
+        fprintf(f, " out_float(stack[sp - %d].f);", back);
+      else if (s->kind == FMT_STR)
+        fprintf(f, " out_lstr((char *)stack[sp - %d].p);", back);
+      else if (s->kind == FMT_CHAR)
+        fprintf(f, " out_char((char)stack[sp - %d].i);", back);
+    }
+    fprintf(f, " out_char('\\n'); sp -= %u; }\n", argc);
+    break;
+  }
+
+  case OP_GET_GLOBAL:
+    fprintf(f, "  stack[sp++] = globals[%u];\n", code[ip++]);
+    break;
+  case OP_SET_GLOBAL:
+    fprintf(f, "  globals[%u] = stack[--sp];\n", code[ip++]);
+    break;
+  case OP_GET_LOCAL:
+    fprintf(f, "  stack[sp++] = stack[fp + %u];\n", code[ip++]);
+    break;
+  case OP_SET_LOCAL:
+    fprintf(f, "  stack[fp + %u] = stack[--sp];\n", code[ip++]);
+    break;
+
+  case OP_CALL: {
+    uint32_t addr;
+    memcpy(&addr, code + ip, 4);
+    ip += 4;
+    uint8_t argc = code[ip++];
+    fprintf(f, "  sp = ");
+    fn_name(f, fn_index(addr));
+    fprintf(f, "(sp - %u);\n", argc);
+    break;
+  }
+  case OP_RET: {
+    uint8_t count = code[ip++];
+    if (region == TOP_LEVEL) {
+      fprintf(f, "  goto cleanup;\n");
+      break;
+    }
+    // The results move down to the frame base, where the caller expects
+    // them, and the new stack top goes back to the caller.
+    fprintf(f, "  csp--; arena_release(call_stack[csp].arena_mark, %zu);%s",
+            ip, fn_try[region] ? " esp = entry_esp;" : "");
+    for (int i = 0; i < count; i++)
+      fprintf(f, " stack[fp + %d] = stack[sp - %d];", i, count - i);
+    fprintf(f, " return fp + %u;\n", count);
+    break;
+  }
+  case OP_CALL_DYN_BOT: {
+    uint8_t argc = code[ip++];
+    ip++; // return count, only needed by the VM's verifier
+    fprintf(f,
+            "  { uint32_t addr = stack[sp - %u - 1].i; for(int i=0; i<%u; "
+            "i++) stack[sp - %u - 1 + i] = stack[sp - %u + i]; sp--; sp = "
+            "fn_at(addr)(sp - %u); }\n",
+            argc, argc, argc, argc, argc);
+    break;
+  }
+  case OP_POP:
+    fprintf(f, "  sp--;\n");
+    break;
+  case OP_DUP:
+    fprintf(f, "  stack[sp] = stack[sp-1]; sp++;\n");
+    break;
+
+  case OP_ALLOC_STRUCT: {
+    uint32_t sid, cidx;
+    memcpy(&sid, code + ip, 4);
+    ip += 4;
+    memcpy(&cidx, code + ip, 4);
+    ip += 4;
+    if (cidx == 0xFFFFFFFF) {
+      fprintf(
+          f,
+          "  { uint32_t sz = structs[%u].size * 8; int64_t *p = "
+          "heap_alloc(sz); "
+          "track_alloc(p, %u, sz, 0, NULL, %zu, fp); stack[sp++].p = p; }\n",
+          sid, sid, ip);
+    } else {
+      fprintf(f,
+              "  { uint32_t sz = structs[%u].size * 8; int64_t *p = "
+              "heap_alloc(sz); "
+              "track_alloc(p, %u, sz, 0, strs[%u], %zu, fp); stack[sp++].p = "
+              "p; }\n",
+              sid, sid, cidx, ip);
+    }
+    break;
+  }
+  case OP_ALLOC_ARRAY: {
+    uint32_t elem_sz;
+    memcpy(&elem_sz, code + ip, 4);
+    ip += 4;
+    uint32_t cidx;
+    memcpy(&cidx, code + ip, 4);
+    ip += 4;
+    if (cidx == 0xFFFFFFFF) {
+      fprintf(f,
+              "  { int64_t c = stack[--sp].i; uint32_t sz = c * %u; int64_t "
+              "*p = heap_alloc(sz); track_alloc(p, 0xFFFFFFFF, sz, 0, "
+              "\"Array Alloc\", %zu, fp); stack[sp++].p = p; }\n",
+              elem_sz, ip);
+    } else {
+      fprintf(f,
+              "  { int64_t c = stack[--sp].i; uint32_t sz = c * %u; int64_t "
+              "*p = heap_alloc(sz); track_alloc(p, 0xFFFFFFFF, sz, 0, "
+              "strs[%u], %zu, fp); stack[sp++].p = p; }\n",
+              elem_sz, cidx, ip);
+    }
+    break;
+  }
+  case OP_ALLOC_STACK: {
+    uint32_t sid, cidx;
+    memcpy(&sid, code + ip, 4);
+    ip += 4;
+    memcpy(&cidx, code + ip, 4);
+    ip += 4;
+    if (cidx == 0xFFFFFFFF) {
+      fprintf(
+          f,
+          "  { uint32_t sz = structs[%u].size * 8; int64_t *p = "
+          "arena_alloc(sz); "
+          "track_alloc(p, %u, sz, 1, NULL, %zu, fp); stack[sp++].p = p; }\n",
+          sid, sid, ip);
+    } else {
+      fprintf(f,
+              "  { uint32_t sz = structs[%u].size * 8; int64_t *p = "
+              "arena_alloc(sz); "
+              "track_alloc(p, %u, sz, 1, strs[%u], %zu, fp); stack[sp++].p = "
+              "p; }\n",
+              sid, sid, cidx, ip);
+    }
+    break;
+  }
+  case OP_FREE:
+    fprintf(
+        f,
+        "  { void *p = stack[--sp].p; untrack_alloc(p, %zu); if "
+        "(!IN_ARENA(p) && !IN_REGION(p) && !(spill_count && spill_find(p) >= "
+        "0)) heap_free(p); }\n",
+        ip);
+    break;
+  case OP_FREE_STR:
+    fprintf(f,
+            "  { char *s = stack[--sp].p; untrack_alloc(s, %zu); if (s) "
+            "free(s - STR_HDR); }\n",
+            ip);
+    break;
+
+  case OP_GET_FIELD:
+    fprintf(f, "  { int64_t *p = stack[sp-1].p; stack[sp-1].i = p[%u]; }\n",
+            code[ip++]);
+    break;
+  case OP_SET_FIELD:
+    fprintf(f,
+            "  { int64_t v = stack[--sp].i; int64_t *p = stack[--sp].p; "
+            "p[%u] = v; }\n",
+            code[ip++]);
+    break;
+  case OP_GET_INDEX:
+    fprintf(f, "  { int64_t i = stack[--sp].i; int64_t *p = stack[--sp].p; "
+               "stack[sp++].i = p[i]; }\n");
+    break;
+  case OP_SET_INDEX:
+    fprintf(f, "  { int64_t v = stack[--sp].i; int64_t i = stack[--sp].i; "
+               "int64_t *p = stack[--sp].p; p[i] = v; }\n");
+    break;
+  case OP_INC_INDEX:
+    fprintf(f, "  { int64_t i = stack[--sp].i; int64_t *p = stack[--sp].p; "
+               "p[i]++; }\n");
+    break;
+  case OP_DEC_INDEX:
+    fprintf(f, "  { int64_t i = stack[--sp].i; int64_t *p = stack[--sp].p; "
+               "p[i]--; }\n");
+    break;
+
+  case OP_STR_CAT:
+    fprintf(
+        f,
+        "  { char *s2 = stack[--sp].p; char *s1 = stack[--sp].p; size_t l1 = "
+        "str_len(s1), l2 = str_len(s2); char *n = str_alloc(l1+l2); "
+        "memcpy(n, s1, l1); memcpy(n+l1, s2, l2); track_alloc(n, "
+        "0xFFFFFFFE, l1+l2+1, 0, "
+        "\"Dynamic String\", %zu, fp); stack[sp++].p = n; }\n",
+        ip);
+    break;
+
+  case OP_STR_CAT_N: {
+    uint8_t n = code[ip];
+    uint32_t kinds;
+    memcpy(&kinds, code + ip + 1, 4);
+    ip += 5;
+    fprintf(f,
+            "  { char *s = str_cat_n(&stack[sp - %u], %u, %uu); "
+            "track_alloc(s, 0xFFFFFFFE, str_len(s) + 1, 0, \"Dynamic "
+            "String\", %zu, fp); sp -= %u; stack[sp++].p = s; }\n",
+            n, n, kinds, ip, n);
+    break;
+  }
+
+  case OP_STRBUF_NEW:
+    fprintf(f, "  stack[sp++].p = calloc(1, sizeof(StrBuf));\n");
+    break;
+  case OP_STRBUF_APPEND: {
+    uint8_t kind = code[ip++];
+    fprintf(f,
+            "  { Value v = stack[--sp]; StrBuf *b = stack[--sp].p; "
+            "strbuf_append(b, %u, v, %zu, fp); }\n",
+            kind, ip);
+    break;
+  }
+  case OP_STRBUF_RESET:
+    fprintf(f, "  ((StrBuf *)stack[--sp].p)->len = 0;\n");
+    break;
+  case OP_STRBUF_STR:
+    fprintf(f, "  stack[sp-1].p = strbuf_str(stack[sp-1].p, %zu, fp);\n",
+            ip);
+    break;
+  case OP_STRBUF_FREE:
+    fprintf(f, "  strbuf_free(stack[--sp].p, %zu);\n", ip);
+    break;
+
+  case OP_I2F:
+    // Value conversion int -> float. No memcpy; union write is typed.
+    fprintf(f, "  stack[sp-1].f = (double)stack[sp-1].i;\n");
+    break;
+  case OP_F2I:
+    fprintf(f, "  stack[sp-1].i = (int64_t)stack[sp-1].f;\n");
+    break;
+  case OP_INT_TO_STR:
+    fprintf(f,
+            "  { int64_t v = stack[--sp].i; char buf[32]; "
+            "int n = snprintf(buf, sizeof(buf), \"%%ld\", (long)v); "
+            "char *s = str_alloc(n); memcpy(s, buf, n); "
+            "track_alloc(s, 0xFFFFFFFE, n+1, 0, \"int->str\", %zu, fp); "
+            "stack[sp++].p = s; }\n",
+            ip);
+    break;
+  case OP_FLOAT_TO_STR:
+    fprintf(f,
+            "  { double v = stack[--sp].f; char buf[64]; "
+            "int n = snprintf(buf, sizeof(buf), \"%%.6f\", v); "
+            "char *s = str_alloc(n); memcpy(s, buf, n); "
+            "track_alloc(s, 0xFFFFFFFE, n+1, 0, \"float->str\", %zu, fp); "
+            "stack[sp++].p = s; }\n",
+            ip);
+    break;
+  case OP_SWAP:
+    fprintf(f, "  { Value tmp = stack[sp-1]; stack[sp-1] = stack[sp-2]; "
+               "stack[sp-2] = tmp; }\n");
+    break;
+
+  case OP_ABYSS_EYE:
+    fprintf(f, "  abyss_eye();\n");
+    break;
+  case OP_ARENA_BEGIN:
+    fprintf(f, "  region_begin(%zu);\n", ip);
+    break;
+  case OP_ARENA_END:
+    fprintf(f,
+            "  if (region_depth > 0) region_release(region_depth - 1, "
+            "%zu);\n",
+            ip);
+    break;
+
+  case OP_TRY: {
+    uint32_t catch_addr;
+    memcpy(&catch_addr, code + ip, 4);
+    ip += 4;
+    // THROW longjmps back here, possibly from a function further down;
+    // sp is reloaded from the frame, so no local needs to be volatile.
+    fprintf(f,
+            "  if (esp >= EXCEPTION_STACK_SIZE) fatal_handler_overflow();\n"
+            "  exception_stack[esp].old_sp = sp; exception_stack[esp].old_csp "
+            "= csp; exception_stack[esp].old_regions = region_depth; if "
+            "(setjmp(exception_stack[esp++].env)) { sp = "
+            "exception_stack[esp].old_sp; stack[sp++] = thrown; goto L_%u; "
+            "}\n",
+            catch_addr);
+    break;
+  }
+  case OP_END_TRY:
+    fprintf(f, "  if (esp > 0) esp--;\n");
+    break;
+  case OP_THROW:
+    fprintf(
+        f, "  { Value err_val = stack[--sp]; if (esp == 0) { fprintf(stderr, "
+           "\"Uncaught Exception: %%s\\n\", (char *)err_val.p); exit(1); } "
+           "esp--; if (csp > exception_stack[esp].old_csp) arena_release("
+           "call_stack[exception_stack[esp].old_csp].arena_mark, %zu); "
+           "if (region_depth > exception_stack[esp].old_regions) "
+           "region_release(exception_stack[esp].old_regions, %zu); "
+           "csp = exception_stack[esp].old_csp; thrown = err_val; "
+           "longjmp(exception_stack[esp].env, 1); }\n",
+        ip, ip);
+    break;
+
+  case OP_NATIVE: {
+    uint32_t nid;
+    memcpy(&nid, code + ip, 4);
+    ip += 4;
+    if (nid == 0)
+      fprintf(
+          f,
+          "  { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); "
+          "double t = ts.tv_sec + ts.tv_nsec / 1e9; stack[sp++].f = t; }\n");
+    else if (nid == 1)
+      fprintf(f, "  { char buf[64]; int64_t v=0; out_flush(); "
+                 "if(fgets(buf, sizeof(buf), stdin)) v = atoll(buf); "
+                 "stack[sp++].i = v; }\n");
+    break;
+  }
+  case OP_TAG_ALLOC: {
+    uint32_t sidx;
+    memcpy(&sidx, code + ip, 4);
+    ip += 4;
+    if (enable_profiler) {
+      fprintf(
+          f,
+          "  { void *p = stack[sp-1].p; "
+          "uint32_t idx = ((uintptr_t)p >> 4) & 0xFFFF; "
+          "AllocInfo *c = alloc_table[idx]; "
+          "while(c) { if(c->ptr == p && !c->is_freed) { c->tag = strs[%u]; "
+          "break; } c = c->next; } }\n",
+          sidx);
+    }
+    // When profiling is off: emit nothing (zero overhead)
+    break;
+  }
+
+  // --- Superinstructions ---
+  case OP_LT_JZ:
+  case OP_LE_JZ:
+  case OP_GT_JZ:
+  case OP_GE_JZ:
+  case OP_EQ_JZ:
+  case OP_NE_JZ: {
+    uint32_t t;
+    memcpy(&t, code + ip, 4);
+    ip += 4;
+    fprintf(f,
+            "  sp -= 2; if (!(stack[sp].i %s stack[sp+1].i)) goto L_%u;\n",
+            cmp_ops[op - OP_LT_JZ], t);
+    break;
+  }
+  case OP_LOCAL_CONST_LT_JZ:
+  case OP_LOCAL_CONST_LE_JZ:
+  case OP_LOCAL_CONST_GT_JZ:
+  case OP_LOCAL_CONST_GE_JZ:
+  case OP_LOCAL_CONST_EQ_JZ:
+  case OP_LOCAL_CONST_NE_JZ: {
+    uint8_t a = code[ip];
+    int32_t k;
+    uint32_t t;
+    memcpy(&k, code + ip + 1, 4);
+    memcpy(&t, code + ip + 5, 4);
+    ip += 9;
+    fprintf(f, "  if (!(stack[fp + %u].i %s %d)) goto L_%u;\n", a,
+            cmp_ops[op - OP_LOCAL_CONST_LT_JZ], k, t);
+    break;
+  }
+  case OP_LOCAL_LOCAL_LT_JZ:
+  case OP_LOCAL_LOCAL_LE_JZ:
+  case OP_LOCAL_LOCAL_GT_JZ:
+  case OP_LOCAL_LOCAL_GE_JZ:
+  case OP_LOCAL_LOCAL_EQ_JZ:
+  case OP_LOCAL_LOCAL_NE_JZ: {
+    uint8_t a = code[ip], b = code[ip + 1];
+    uint32_t t;
+    memcpy(&t, code + ip + 2, 4);
+    ip += 6;
+    fprintf(f, "  if (!(stack[fp + %u].i %s stack[fp + %u].i)) goto L_%u;\n",
+            a, cmp_ops[op - OP_LOCAL_LOCAL_LT_JZ], b, t);
+    break;
+  }
+  case OP_INC_LOCAL: {
+    uint8_t a = code[ip];
+    int32_t k;
+    memcpy(&k, code + ip + 1, 4);
+    ip += 5;
+    fprintf(f, "  stack[fp + %u].i += %d;\n", a, k);
+    break;
+  }
+  case OP_GET_LOCAL_FIELD:
+    fprintf(f, "  stack[sp++].i = ((int64_t *)stack[fp + %u].p)[%u];\n",
+            code[ip], code[ip + 1]);
+    ip += 2;
+    break;
+  case OP_GET_LOCAL2:
+    fprintf(f,
+            "  stack[sp] = stack[fp + %u]; stack[sp+1] = stack[fp + %u]; "
+            "sp += 2;\n",
+            code[ip], code[ip + 1]);
+    ip += 2;
+    break;
+
+  default:
+    fprintf(stderr, "FATAL: Unimplemented opcode %d in native transpiler!\n",
+            op);
+    exit(1);
+  }
+}
+
+// Emits region's instructions in [from, to) in address order, so
+// fallthrough stays fallthrough. A #line before every instruction
+// attributes its C to the source line, so gdb and perf annotate on the
+// binary show .al lines. It is repeated because one instruction's C can
+// span several lines.
+static void emit_region(FILE *f, int region, size_t from, size_t to,
+                        int enable_profiler) {
+  int line = -1; // src_lines entry covering ip
+  for (size_t ip = from; ip < to; ip += 1 + op_operand_size(code[ip])) {
+    if (owner[ip] != region)
+      continue;
+    while (line + 1 < src_line_count && src_lines[line + 1].addr <= ip)
+      line++;
+    if (is_target[ip])
+      fprintf(f, "L_%zu:\n", ip);
+    if (line >= 0)
+      line_directive(f, &src_lines[line]);
+    emit_insn(f, ip, region, enable_profiler);
+  }
+}
+
+// --- Stack slots as C locals ---
+// The operand stack depth is the same at an instruction however control
+// reaches it, so in a function every stack[fp + k] the code touches is a
+// slot known at translation time. In functions without try, slot k becomes
+// two C locals, i<k> (int64_t; also pointers) and f<k> (double), and the
+// type tracked for each slot at each instruction says which one holds the
+// value. gcc then keeps locals and temporaries in registers. The value
+// stack in memory carries only call arguments and results, and the operands
+// of the opcodes that still use the stack templates (allocation, strings,
+// formatted print, throw, natives, Abyss Eye): those spill the slots they
+// read and reload what they push.
+//
+// Functions with try keep their slots in memory: after a longjmp back into
+// them, locals changed since setjmp would be indeterminate.
+enum { SLOT_I, SLOT_F };
+#define SLOT_CAP 1024 // deeper functions use the memory stack
+
+static uint8_t *is_leader;     // instruction starts a block
+static uint8_t **entry_type;   // slot types at each block entry
+static int *entry_depth;       // stack depth at each block entry
+static int slot_max;           // deepest slot of the current function
+
+// Values the instruction at ip pops and pushes. Copies (GET_LOCAL, DUP,
+// SWAP...) are listed too, for the depth; slot_transfer() gives them their
+// types. TAG_ALLOC only peeks, but counts as pop and push so the stack
+// template finds its operand spilled.
+static void stack_effect(size_t ip, int *pops, int *pushes) {
+  uint8_t op = code[ip];
+  int po = 0, pu = 0;
+  switch (op) {
+  case OP_CONST_INT:
+  case OP_CONST_FLOAT:
+  case OP_CONST_STR:
+  case OP_GET_GLOBAL:
+  case OP_GET_LOCAL:
+  case OP_ALLOC_STRUCT:
+  case OP_ALLOC_STACK:
+  case OP_DUP:
+  case OP_STRBUF_NEW:
+  case OP_GET_LOCAL_FIELD:
+    pu = 1;
+    break;
+  case OP_GET_LOCAL2:
+    pu = 2;
+    break;
+  case OP_ADD:
+  case OP_SUB:
+  case OP_MUL:
+  case OP_DIV:
+  case OP_MOD:
+  case OP_ADD_F:
+  case OP_SUB_F:
+  case OP_MUL_F:
+  case OP_DIV_F:
+  case OP_LT:
+  case OP_LE:
+  case OP_GT:
+  case OP_GE:
+  case OP_EQ:
+  case OP_NE:
+  case OP_LT_F:
+  case OP_LE_F:
+  case OP_GT_F:
+  case OP_GE_F:
+  case OP_EQ_F:
+  case OP_NE_F:
+  case OP_AND:
+  case OP_OR:
+  case OP_BIT_AND:
+  case OP_BIT_OR:
+  case OP_BIT_XOR:
+  case OP_SHL:
+  case OP_SHR:
+  case OP_STR_CAT:
+  case OP_GET_INDEX:
+    po = 2;
+    pu = 1;
+    break;
+  case OP_NEG:
+  case OP_NEG_F:
+  case OP_NOT:
+  case OP_BIT_NOT:
+  case OP_I2F:
+  case OP_F2I:
+  case OP_INT_TO_STR:
+  case OP_FLOAT_TO_STR:
+  case OP_STRBUF_STR:
+  case OP_ALLOC_ARRAY:
+  case OP_GET_FIELD:
+  case OP_TAG_ALLOC:
+    po = 1;
+    pu = 1;
+    break;
+  case OP_SWAP:
+    po = 2;
+    pu = 2;
+    break;
+  case OP_JZ:
+  case OP_PRINT:
+  case OP_PRINT_F:
+  case OP_PRINT_STR:
+  case OP_PRINT_CHAR:
+  case OP_SET_GLOBAL:
+  case OP_SET_LOCAL:
+  case OP_POP:
+  case OP_FREE:
+  case OP_FREE_STR:
+  case OP_STRBUF_RESET:
+  case OP_STRBUF_FREE:
+  case OP_THROW:
+    po = 1;
+    break;
+  case OP_SET_FIELD:
+  case OP_INC_INDEX:
+  case OP_DEC_INDEX:
+  case OP_STRBUF_APPEND:
+  case OP_LT_JZ:
+  case OP_LE_JZ:
+  case OP_GT_JZ:
+  case OP_GE_JZ:
+  case OP_EQ_JZ:
+  case OP_NE_JZ:
+    po = 2;
+    break;
+  case OP_SET_INDEX:
+    po = 3;
+    break;
+  case OP_PRINT_FMT:
+    po = code[ip + 1] + 1;
+    break;
+  case OP_PRINT_FMT_SEG:
+    po = code[ip + 5];
+    break;
+  case OP_STR_CAT_N:
+    po = code[ip + 1];
+    pu = 1;
+    break;
+  case OP_CALL: {
+    uint32_t addr;
+    memcpy(&addr, code + ip + 1, 4);
+    po = code[ip + 5];
+    pu = fn_info[fn_index(addr)]->ret_count;
+    break;
+  }
+  case OP_CALL_DYN_BOT:
+    po = code[ip + 1] + 1;
+    pu = code[ip + 2];
+    break;
+  case OP_RET:
+    po = code[ip + 1];
+    break;
+  case OP_NATIVE: {
+    uint32_t nid;
+    memcpy(&nid, code + ip + 1, 4);
+    pu = nid <= 1; // clock, input_int
+    break;
+  }
+  }
+  *pops = po;
+  *pushes = pu;
+}
+
+// Applies the instruction at ip to depth and slot types. Returns 0 if the
+// code does something the slot model cannot follow (a local above the
+// stack top, a stack too deep), so the function keeps the memory stack.
+static int slot_transfer(size_t ip, int *depth, uint8_t *type) {
+  uint8_t op = code[ip], a = code[ip + 1], b = code[ip + 2];
+  int d = *depth, pops, pushes;
+  stack_effect(ip, &pops, &pushes);
+  if (pops > d || d - pops + pushes > SLOT_CAP)
+    return 0;
+  switch (op) {
+  case OP_GET_LOCAL:
+  case OP_GET_LOCAL_FIELD:
+  case OP_INC_LOCAL:
+  case OP_LOCAL_CONST_LT_JZ:
+  case OP_LOCAL_CONST_LE_JZ:
+  case OP_LOCAL_CONST_GT_JZ:
+  case OP_LOCAL_CONST_GE_JZ:
+  case OP_LOCAL_CONST_EQ_JZ:
+  case OP_LOCAL_CONST_NE_JZ:
+    if (a >= d)
+      return 0;
+    break;
+  case OP_SET_LOCAL:
+    if (a >= d - 1)
+      return 0;
+    break;
+  case OP_GET_LOCAL2:
+  case OP_LOCAL_LOCAL_LT_JZ:
+  case OP_LOCAL_LOCAL_LE_JZ:
+  case OP_LOCAL_LOCAL_GT_JZ:
+  case OP_LOCAL_LOCAL_GE_JZ:
+  case OP_LOCAL_LOCAL_EQ_JZ:
+  case OP_LOCAL_LOCAL_NE_JZ:
+    if (a >= d || b >= d)
+      return 0;
+    break;
+  }
+
+  switch (op) {
+  case OP_GET_LOCAL:
+    type[d] = type[a];
+    break;
+  case OP_GET_LOCAL2:
+    type[d] = type[a];
+    type[d + 1] = type[b];
+    break;
+  case OP_SET_LOCAL:
+    type[a] = type[d - 1];
+    break;
+  case OP_DUP:
+    type[d] = type[d - 1];
+    break;
+  case OP_SWAP: {
+    uint8_t t = type[d - 1];
+    type[d - 1] = type[d - 2];
+    type[d - 2] = t;
+    break;
+  }
+  case OP_INC_LOCAL:
+    type[a] = SLOT_I;
+    break;
+  case OP_TAG_ALLOC:
+    break;
+  default: {
+    int is_float = op == OP_CONST_FLOAT || op == OP_ADD_F || op == OP_SUB_F ||
+                   op == OP_MUL_F || op == OP_DIV_F || op == OP_NEG_F ||
+                   op == OP_I2F;
+    if (op == OP_NATIVE) {
+      uint32_t nid;
+      memcpy(&nid, code + ip + 1, 4);
+      is_float = nid == 0; // clock() returns seconds
+    }
+    for (int k = d - pops; k < d - pops + pushes; k++)
+      type[k] = is_float ? SLOT_F : SLOT_I;
+  }
+  }
+  *depth = d - pops + pushes;
+  if (*depth > slot_max)
+    slot_max = *depth;
+  return 1;
+}
+
+// Joins a state into the entry of the block at `at`: a slot whose type
+// differs between predecessors is kept as SLOT_I. Queues the block if its
+// entry changed.
+static int slot_merge(size_t at, int depth, const uint8_t *type, size_t *work,
+                      size_t *wn) {
+  if (!entry_type[at]) {
+    entry_type[at] = malloc(depth + 1);
+    memcpy(entry_type[at], type, depth);
+    entry_depth[at] = depth;
+  } else {
+    if (entry_depth[at] != depth)
+      return 0;
+    int changed = 0;
+    for (int k = 0; k < depth; k++)
+      if (entry_type[at][k] != type[k] && entry_type[at][k] != SLOT_I)
+        entry_type[at][k] = SLOT_I, changed = 1;
+    if (!changed)
+      return 1;
+  }
+  if (!(is_leader[at] & 2)) {
+    is_leader[at] |= 2;
+    work[(*wn)++] = at;
+  }
+  return 1;
+}
+
+// Finds the slot types at every block entry of function k, whose code lies
+// in [from, to). Returns 0 if the function must keep the memory stack.
+static int slot_analyze(int k, size_t from, size_t to) {
+  size_t n = 0, wn = 0;
+  for (size_t ip = from; ip < to; ip += 1 + op_operand_size(code[ip])) {
+    uint32_t t;
+    if (owner[ip] == k && jump_target(ip, &t))
+      is_leader[t] = 1;
+    n++;
+  }
+  is_leader[from] = 1;
+  size_t *work = malloc((n + 1) * sizeof(size_t));
+  uint8_t *type = malloc(SLOT_CAP + 2);
+  slot_max = fn_info[k]->arg_count;
+  memset(type, SLOT_I, fn_info[k]->arg_count);
+  int ok = slot_max <= SLOT_CAP &&
+           slot_merge(from, fn_info[k]->arg_count, type, work, &wn);
+  while (ok && wn) {
+    size_t ip = work[--wn];
+    is_leader[ip] &= ~2;
+    int depth = entry_depth[ip];
+    memcpy(type, entry_type[ip], depth);
+    for (;;) {
+      uint8_t op = code[ip];
+      uint32_t t;
+      if (!slot_transfer(ip, &depth, type)) {
+        ok = 0;
+        break;
+      }
+      if (jump_target(ip, &t) &&
+          !(op != OP_TRY && slot_merge(t, depth, type, work, &wn))) {
+        ok = 0; // try only appears in functions that are not translated
+        break;
+      }
+      if (op == OP_JMP || op == OP_RET || op == OP_THROW || op == OP_HALT)
+        break;
+      ip += 1 + op_operand_size(op);
+      if (is_leader[ip]) {
+        ok = slot_merge(ip, depth, type, work, &wn);
+        break;
+      }
+    }
+  }
+  free(work);
+  free(type);
+  return ok;
+}
+
+// Forgets function k's block entries, once it is emitted or rejected.
+static void slot_reset(size_t from, size_t to) {
+  for (size_t ip = from; ip <= to && ip <= code_sz; ip++) {
+    free(entry_type[ip]);
+    entry_type[ip] = NULL;
+    is_leader[ip] = 0;
+  }
+}
+
+// Slot k as a C expression of type want, converting the bits if the slot
+// currently holds the other type. Results live in a small ring of
+// buffers, enough for the operands of one instruction.
+static const char *slot_val(const uint8_t *type, int k, int want) {
+  static char ring[8][32];
+  static int next;
+  char *s = ring[next++ & 7];
+  if (type[k] == want)
+    snprintf(s, sizeof(ring[0]), "%c%d", want == SLOT_F ? 'f' : 'i', k);
+  else
+    snprintf(s, sizeof(ring[0]), want == SLOT_F ? "as_f(i%d)" : "as_i(f%d)",
+             k);
+  return s;
+}
+
+#define SI(k) slot_val(cur, (k), SLOT_I)
+#define SF(k) slot_val(cur, (k), SLOT_F)
+// The local that holds slot k before and after the instruction.
+#define SRC(k) (cur[k] == SLOT_F ? 'f' : 'i'), (k)
+#define DST(k) (post[k] == SLOT_F ? 'f' : 'i'), (k)
+
+// Brings slots [0, depth) from the types in `from` to those in `to`.
+static void slot_convert(FILE *f, int depth, const uint8_t *from,
+                         const uint8_t *to) {
+  for (int k = 0; k < depth; k++)
+    if (from[k] != to[k])
+      fprintf(f, " %c%d = %s;", to[k] == SLOT_F ? 'f' : 'i', k,
+              slot_val(from, k, to[k]));
+}
+
+// A jump from a block whose slots have types `type`.
+static void slot_goto(FILE *f, uint32_t t, int depth, const uint8_t *type) {
+  fprintf(f, " {");
+  slot_convert(f, depth, type, entry_type[t]);
+  fprintf(f, " goto L_%u; }\n", t);
+}
+
+// Copies slots [from, to) to the value stack, at the same frame offsets.
+static void slot_spill(FILE *f, const uint8_t *type, int from, int to) {
+  for (int k = from; k < to; k++)
+    fprintf(f, " stack[fp + %d].%c = %c%d;", k, type[k] == SLOT_F ? 'f' : 'i',
+            type[k] == SLOT_F ? 'f' : 'i', k);
+}
+
+static void slot_reload(FILE *f, const uint8_t *type, int from, int to) {
+  for (int k = from; k < to; k++)
+    fprintf(f, " %c%d = stack[fp + %d].%c;", type[k] == SLOT_F ? 'f' : 'i', k,
+            k, type[k] == SLOT_F ? 'f' : 'i');
+}
+
+// Translates the instruction at ip of function k, with slot types cur at
+// depth d before it and post after it.
+static void slot_insn(FILE *f, size_t ip, int k, int d, const uint8_t *cur,
+                      const uint8_t *post, int enable_profiler) {
+  uint8_t op = code[ip];
+  uint8_t a = code[ip + 1], b = code[ip + 2];
+  int32_t v;
+  uint32_t t;
+  switch (op) {
+  case OP_HALT:
+    fprintf(f, "  exit(0);\n");
+    break;
+  case OP_CONST_INT:
+    memcpy(&v, code + ip + 1, 4);
+    fprintf(f, "  i%d = %d;\n", d, v);
+    break;
+  case OP_CONST_FLOAT: {
+    uint64_t bits;
+    memcpy(&bits, code + ip + 1, 8);
+    fprintf(f, "  f%d = as_f((int64_t)0x%016lxULL);\n", d, bits);
+    break;
+  }
+  case OP_CONST_STR:
+    memcpy(&t, code + ip + 1, 4);
+    fprintf(f, "  i%d = (intptr_t)strs[%u];\n", d, t);
+    break;
+
+  case OP_ADD:
+  case OP_SUB:
+  case OP_MUL:
+  case OP_DIV:
+  case OP_MOD:
+  case OP_BIT_AND:
+  case OP_BIT_OR:
+  case OP_BIT_XOR:
+  case OP_SHL:
+  case OP_SHR:
+  case OP_AND:
+  case OP_OR:
+  case OP_LT:
+  case OP_LE:
+  case OP_GT:
+  case OP_GE:
+  case OP_EQ:
+  case OP_NE: {
+    const char *c = op == OP_ADD       ? "+"
+                    : op == OP_SUB     ? "-"
+                    : op == OP_MUL     ? "*"
+                    : op == OP_DIV     ? "/"
+                    : op == OP_MOD     ? "%"
+                    : op == OP_BIT_AND ? "&"
+                    : op == OP_BIT_OR  ? "|"
+                    : op == OP_BIT_XOR ? "^"
+                    : op == OP_SHL     ? "<<"
+                    : op == OP_SHR     ? ">>"
+                    : op == OP_AND     ? "&&"
+                    : op == OP_OR      ? "||"
+                                       : cmp_ops[op - OP_LT];
+    fprintf(f, "  i%d = %s %s %s;\n", d - 2, SI(d - 2), c, SI(d - 1));
+    break;
+  }
+  case OP_ADD_F:
+  case OP_SUB_F:
+  case OP_MUL_F:
+  case OP_DIV_F:
+    fprintf(f, "  f%d = %s %c %s;\n", d - 2, SF(d - 2),
+            "+-*/"[op - OP_ADD_F], SF(d - 1));
+    break;
+  case OP_LT_F:
+  case OP_LE_F:
+  case OP_GT_F:
+  case OP_GE_F:
+  case OP_EQ_F:
+  case OP_NE_F:
+    fprintf(f, "  i%d = %s %s %s;\n", d - 2, SF(d - 2), cmp_ops[op - OP_LT_F],
+            SF(d - 1));
+    break;
+  case OP_NEG:
+    fprintf(f, "  i%d = -%s;\n", d - 1, SI(d - 1));
+    break;
+  case OP_NOT:
+    fprintf(f, "  i%d = !%s;\n", d - 1, SI(d - 1));
+    break;
+  case OP_BIT_NOT:
+    fprintf(f, "  i%d = ~%s;\n", d - 1, SI(d - 1));
+    break;
+  case OP_NEG_F:
+    fprintf(f, "  f%d = -%s;\n", d - 1, SF(d - 1));
+    break;
+  case OP_I2F:
+    fprintf(f, "  f%d = (double)%s;\n", d - 1, SI(d - 1));
+    break;
+  case OP_F2I:
+    fprintf(f, "  i%d = (int64_t)%s;\n", d - 1, SF(d - 1));
+    break;
+
+  case OP_JMP:
+    memcpy(&t, code + ip + 1, 4);
+    fprintf(f, " ");
+    slot_goto(f, t, d, cur);
+    break;
+  case OP_JZ:
+    memcpy(&t, code + ip + 1, 4);
+    fprintf(f, "  if (!%s)", SI(d - 1));
+    slot_goto(f, t, d - 1, post);
+    break;
+  case OP_LT_JZ:
+  case OP_LE_JZ:
+  case OP_GT_JZ:
+  case OP_GE_JZ:
+  case OP_EQ_JZ:
+  case OP_NE_JZ:
+    memcpy(&t, code + ip + 1, 4);
+    fprintf(f, "  if (!(%s %s %s))", SI(d - 2), cmp_ops[op - OP_LT_JZ],
+            SI(d - 1));
+    slot_goto(f, t, d - 2, post);
+    break;
+  case OP_LOCAL_CONST_LT_JZ:
+  case OP_LOCAL_CONST_LE_JZ:
+  case OP_LOCAL_CONST_GT_JZ:
+  case OP_LOCAL_CONST_GE_JZ:
+  case OP_LOCAL_CONST_EQ_JZ:
+  case OP_LOCAL_CONST_NE_JZ:
+    memcpy(&v, code + ip + 2, 4);
+    memcpy(&t, code + ip + 6, 4);
+    fprintf(f, "  if (!(%s %s %d))", SI(a), cmp_ops[op - OP_LOCAL_CONST_LT_JZ],
+            v);
+    slot_goto(f, t, d, post);
+    break;
+  case OP_LOCAL_LOCAL_LT_JZ:
+  case OP_LOCAL_LOCAL_LE_JZ:
+  case OP_LOCAL_LOCAL_GT_JZ:
+  case OP_LOCAL_LOCAL_GE_JZ:
+  case OP_LOCAL_LOCAL_EQ_JZ:
+  case OP_LOCAL_LOCAL_NE_JZ:
+    memcpy(&t, code + ip + 3, 4);
+    fprintf(f, "  if (!(%s %s %s))", SI(a), cmp_ops[op - OP_LOCAL_LOCAL_LT_JZ],
+            SI(b));
+    slot_goto(f, t, d, post);
+    break;
+
+  case OP_PRINT:
+    fprintf(f, "  out_int(%s); out_char('\\n');\n", SI(d - 1));
+    break;
+  case OP_PRINT_F:
+    fprintf(f, "  out_float(%s); out_char('\\n');\n", SF(d - 1));
+    break;
+  case OP_PRINT_STR:
+    fprintf(f, "  out_lstr(PTR(%s)); out_char('\\n');\n", SI(d - 1));
+    break;
+  case OP_PRINT_CHAR:
+    fprintf(f, "  out_char((char)%s);\n", SI(d - 1));
+    break;
+
+  case OP_GET_GLOBAL:
+    fprintf(f, "  i%d = globals[%u].i;\n", d, a);
+    break;
+  case OP_SET_GLOBAL:
+    fprintf(f, "  globals[%u].%c = %c%d;\n", a, cur[d - 1] ? 'f' : 'i',
+            cur[d - 1] ? 'f' : 'i', d - 1);
+    break;
+  case OP_GET_LOCAL:
+    fprintf(f, "  %c%d = %c%d;\n", DST(d), DST(a));
+    break;
+  case OP_SET_LOCAL:
+    fprintf(f, "  %c%d = %c%d;\n", DST(a), DST(d - 1));
+    break;
+  case OP_GET_LOCAL2:
+    fprintf(f, "  %c%d = %c%d; %c%d = %c%d;\n", DST(d), DST(a), DST(d + 1),
+            DST(b));
+    break;
+  case OP_INC_LOCAL:
+    memcpy(&v, code + ip + 2, 4);
+    fprintf(f, "  i%d = %s + %d;\n", a, SI(a), v);
+    break;
+  case OP_GET_LOCAL_FIELD:
+    fprintf(f, "  i%d = ((int64_t *)PTR(%s))[%u];\n", d, SI(a), b);
+    break;
+  case OP_POP:
+    fprintf(f, "  ;\n");
+    break;
+  case OP_DUP:
+    fprintf(f, "  %c%d = %c%d;\n", DST(d), DST(d - 1));
+    break;
+  case OP_SWAP:
+    if (cur[d - 1] == cur[d - 2])
+      fprintf(f, "  { %s t = %c%d; %c%d = %c%d; %c%d = t; }\n",
+              cur[d - 1] ? "double" : "int64_t", DST(d - 1), DST(d - 1),
+              DST(d - 2), DST(d - 2));
+    else // four different locals, so no temporary
+      fprintf(f, "  %c%d = %c%d; %c%d = %c%d;\n", DST(d - 1), SRC(d - 2),
+              DST(d - 2), SRC(d - 1));
+    break;
+
+  case OP_GET_FIELD:
+    fprintf(f, "  i%d = ((int64_t *)PTR(%s))[%u];\n", d - 1, SI(d - 1), a);
+    break;
+  case OP_SET_FIELD:
+    fprintf(f, "  ((int64_t *)PTR(%s))[%u] = %s;\n", SI(d - 2), a, SI(d - 1));
+    break;
+  case OP_GET_INDEX:
+    fprintf(f, "  i%d = ((int64_t *)PTR(%s))[%s];\n", d - 2, SI(d - 2),
+            SI(d - 1));
+    break;
+  case OP_SET_INDEX:
+    fprintf(f, "  ((int64_t *)PTR(%s))[%s] = %s;\n", SI(d - 3), SI(d - 2),
+            SI(d - 1));
+    break;
+  case OP_INC_INDEX:
+  case OP_DEC_INDEX:
+    fprintf(f, "  ((int64_t *)PTR(%s))[%s]%s;\n", SI(d - 2), SI(d - 1),
+            op == OP_INC_INDEX ? "++" : "--");
+    break;
+
+  case OP_CALL:
+  case OP_CALL_DYN_BOT: {
+    // The callee's frame starts where its arguments are; a dynamic call's
+    // arguments move down over the address, as in the stack template.
+    int argc = op == OP_CALL ? code[ip + 5] : a;
+    int base = d - argc - (op == OP_CALL_DYN_BOT);
+    int pops, pushes;
+    stack_effect(ip, &pops, &pushes);
+    fprintf(f, " ");
+    for (int j = 0; j < argc; j++)
+      fprintf(f, " stack[fp + %d].%c = %c%d;", base + j,
+              cur[d - argc + j] ? 'f' : 'i', cur[d - argc + j] ? 'f' : 'i',
+              d - argc + j);
+    if (op == OP_CALL) {
+      memcpy(&t, code + ip + 1, 4);
+      fprintf(f, " ");
+      fn_name(f, fn_index(t));
+    } else {
+      fprintf(f, " fn_at(%s)", SI(base));
+    }
+    fprintf(f, "(fp + %d);", base);
+    slot_reload(f, post, base, base + pushes);
+    fprintf(f, "\n");
+    break;
+  }
+  case OP_RET: {
+    int count = a;
+    fprintf(f, " ");
+    for (int j = 0; j < count; j++)
+      fprintf(f, " stack[fp + %d].%c = %c%d;", j, cur[d - count + j] ? 'f' : 'i',
+              cur[d - count + j] ? 'f' : 'i', d - count + j);
+    fprintf(f,
+            " csp--; arena_release(call_stack[csp].arena_mark, %zu); return "
+            "fp + %d;\n",
+            ip + 2, count);
+    break;
+  }
+
+  case OP_TAG_ALLOC:
+    // Only Abyss Eye reads the tag, and it leaves the value in place.
+    if (enable_profiler) {
+      fprintf(f, " ");
+      slot_spill(f, cur, d - 1, d);
+      fprintf(f, " sp = fp + %d;\n", d);
+      emit_insn(f, ip, k, enable_profiler);
+    } else {
+      fprintf(f, "  ;\n");
+    }
+    break;
+
+  default: {
+    // Everything else runs its stack template on the spilled operands.
+    int pops, pushes;
+    stack_effect(ip, &pops, &pushes);
+    fprintf(f, " ");
+    slot_spill(f, cur, d - pops, d);
+    fprintf(f, " sp = fp + %d;\n", d);
+    emit_insn(f, ip, k, enable_profiler);
+    if (pushes) {
+      fprintf(f, " ");
+      slot_reload(f, post, d - pops, d - pops + pushes);
+      fprintf(f, "\n");
+    }
+  }
+  }
+}
+
+// Emits function k with its stack slots in C locals; slot_analyze() must
+// have succeeded for it.
+static void emit_slot_function(FILE *f, int k, size_t from, size_t to,
+                               int enable_profiler) {
+  int argc = fn_info[k]->arg_count;
+  fprintf(f, "  size_t sp;");
+  for (int s = 0; s < slot_max; s++)
+    fprintf(f, "%s i%d", s ? "," : " int64_t", s);
+  if (slot_max)
+    fprintf(f, ";");
+  for (int s = 0; s < slot_max; s++)
+    fprintf(f, "%s f%d", s ? "," : " double", s);
+  fprintf(f, "%s\n ", slot_max ? ";" : "");
+  for (int s = 0; s < argc; s++)
+    fprintf(f, " i%d = stack[fp + %d].i;", s, s);
+  fprintf(f, " call_stack[csp++].arena_mark = arena_top;\n");
+
+  uint8_t *cur = malloc(SLOT_CAP + 2), *post = malloc(SLOT_CAP + 2);
+  int d = 0, falls = 0, line = -1;
+  for (size_t ip = from; ip < to; ip += 1 + op_operand_size(code[ip])) {
+    if (owner[ip] != k)
+      continue;
+    if (is_leader[ip]) {
+      if (falls) {
+        fprintf(f, " ");
+        slot_convert(f, d, cur, entry_type[ip]);
+        fprintf(f, "\n");
+      }
+      d = entry_depth[ip];
+      memcpy(cur, entry_type[ip], d);
+    }
+    while (line + 1 < src_line_count && src_lines[line + 1].addr <= ip)
+      line++;
+    if (is_target[ip])
+      fprintf(f, "L_%zu:\n", ip);
+    if (line >= 0)
+      line_directive(f, &src_lines[line]);
+    int pd = d;
+    memcpy(post, cur, d);
+    slot_transfer(ip, &pd, post);
+    slot_insn(f, ip, k, d, cur, post, enable_profiler);
+    uint8_t op = code[ip];
+    falls = !(op == OP_JMP || op == OP_RET || op == OP_THROW || op == OP_HALT);
+    d = pd;
+    memcpy(cur, post, d);
+  }
+  free(cur);
+  free(post);
+}
+
+// --- TRANSLATION UNITS ---
+// A large program is split into several .c files so gcc can build them in
+// parallel. They all include one header: runtime globals are declared extern
+// there and out-of-line runtime functions prototyped, while the definitions
+// stay in the runtime unit. Unsplit, hdr is that unit itself.
+
+#define SHARD_BYTES (16 * 1024) // bytecode per function unit, roughly
+#define MAX_UNITS 256
+
+static FILE *hdr;
+static int split;
+static NativeFile *out_files; // in opening order
+static int out_count;
+
+// Units are generated in memory, so the caller can hash exactly the text
+// that gcc will see; write_units() puts them on disk once complete.
+static FILE *open_unit(const char *stem, int n, const char *ext) {
+  char path[1024];
+  if (n)
+    snprintf(path, sizeof(path), "%s_%d%s", stem, n, ext);
+  else
+    snprintf(path, sizeof(path), "%s%s", stem, ext);
+  NativeFile *nf = &out_files[out_count++];
+  nf->path = strdup(path);
+  FILE *f = open_memstream(&nf->text, &nf->len);
   if (!f) {
-    fprintf(stderr, "Could not open %s for writing.\n", out_filename);
+    fprintf(stderr, "Could not buffer %s.\n", path);
     exit(1);
   }
+  if (split && strcmp(ext, ".c") == 0) {
+    const char *base = strrchr(stem, '/');
+    fprintf(f, "#include \"%s.h\"\n\n", base ? base + 1 : stem);
+  }
+  return f;
+}
+
+// Writes the closed units to their paths.
+static void write_units(void) {
+  for (int i = 0; i < out_count; i++) {
+    NativeFile *nf = &out_files[i];
+    FILE *f = fopen(nf->path, "w");
+    if (!f || fwrite(nf->text, 1, nf->len, f) != nf->len || fclose(f) != 0) {
+      fprintf(stderr, "Could not write %s.\n", nf->path);
+      exit(1);
+    }
+  }
+}
+
+static void rt_extern(const char *decl) {
+  if (split)
+    fprintf(hdr, "extern %s;\n", decl);
+}
+
+// A runtime global, defined in f.
+static void rt_var(FILE *f, const char *decl, const char *init) {
+  rt_extern(decl);
+  fprintf(f, "%s%s;\n", decl, init);
+}
+
+// Opens the definition of an out-of-line runtime function in f.
+static void rt_fn(FILE *f, const char *sig) {
+  if (split)
+    fprintf(hdr, "%s;\n", sig);
+  fprintf(f, "%s {\n", sig);
+}
+
+// Bytecode of the live functions.
+static size_t live_bytes(void) {
+  size_t total = 0;
+  for (int k = 0; k < fn_count; k++)
+    if (fn_live[k])
+      total += fn_end(k) - fn_info[k]->addr;
+  return total;
+}
+
+// Function units: one per SHARD_BYTES of live bytecode, at most MAX_UNITS.
+// Below two the program stays in one file. The count depends on the program
+// alone, never on the host, so the generated C (and the binary) is the same
+// whatever -j a build runs with. $ABYSS_SHARD_BYTES overrides the share, so
+// tests can push small programs through the split build.
+static int shard_count(void) {
+  size_t share = SHARD_BYTES;
+  const char *env = getenv("ABYSS_SHARD_BYTES");
+  if (env && strtol(env, NULL, 10) > 0)
+    share = strtol(env, NULL, 10);
+  size_t n = live_bytes() / share;
+  if (n > MAX_UNITS)
+    n = MAX_UNITS;
+  return n < 2 ? 1 : (int)n;
+}
+
+int generate_native_code(const char *stem, int enable_profiler,
+                         NativeFile **files) {
+  find_regions();
+  find_live();
+  int shards = shard_count();
+  split = shards > 1;
+  // <stem>.c, up to shards function units and the header.
+  out_files = calloc(shards + 2, sizeof(NativeFile));
+  out_count = 0;
+  if (split)
+    hdr = open_unit(stem, 0, ".h");
+  FILE *f = open_unit(stem, 0, ".c");
+  if (!split)
+    hdr = f;
 
   // --- 1. C HEADERS & VM STATE ---
-  fprintf(f, "#define _POSIX_C_SOURCE 200809L\n");
+  fprintf(hdr, "#define _POSIX_C_SOURCE 200809L\n");
+  fprintf(hdr, "#define _DEFAULT_SOURCE\n"); // MAP_ANONYMOUS (slabs)
   fprintf(
-      f,
+      hdr,
       "#include <stdint.h>\n#include <stdio.h>\n#include <stdlib.h>\n#include "
-      "<string.h>\n#include <time.h>\n#include <ctype.h>\n\n");
+      "<string.h>\n#include <time.h>\n#include <ctype.h>\n#include "
+      "<errno.h>\n#include <math.h>\n#include <setjmp.h>\n#include "
+      "<unistd.h>\n#include <sys/mman.h>\n\n");
 
-  fprintf(f,
+  fprintf(hdr,
           "#define C_RESET \"\\033[0m\"\n#define C_BOLD \"\\033[1m\"\n#define "
           "C_RED \"\\033[31m\"\n#define C_GRAY \"\\033[90m\"\n#define C_CYAN "
           "\"\\033[36m\"\n#define C_GREEN \"\\033[32m\"\n#define C_YELLOW "
           "\"\\033[33m\"\n#define C_MAGENTA \"\\033[35m\"\n\n");
 
   // --- NEW: THE VALUE UNION (Eliminates memcpy overhead!) ---
-  fprintf(f, "typedef union { int64_t i; double f; void *p; } Value;\n");
-  fprintf(f, "Value stack[1024 * 1024];\n");
-  fprintf(f, "Value globals[1024];\n\n");
+  fprintf(hdr, "typedef union { int64_t i; double f; void *p; } Value;\n");
+  // Bit casts between the int64_t and double locals of a stack slot.
+  fprintf(hdr, "static inline double as_f(int64_t i) { double d; memcpy(&d, "
+               "&i, 8); return d; }\n"
+               "static inline int64_t as_i(double d) { int64_t i; memcpy(&i, "
+               "&d, 8); return i; }\n"
+               "#define PTR(x) ((void *)(intptr_t)(x))\n");
+  rt_var(f, "Value stack[1024 * 1024]", "");
+  rt_var(f, "Value globals[1024]", "");
+  fprintf(f, "\n");
 
-  fprintf(f, "typedef struct { size_t ret_addr; size_t old_fp; } Frame;\n");
-  fprintf(f, "Frame call_stack[4096]; size_t csp = 0;\n");
-  fprintf(f, "typedef struct { size_t catch_addr; size_t old_sp; size_t "
-             "old_fp; size_t old_csp; } ExceptionFrame;\n");
-  fprintf(f, "ExceptionFrame exception_stack[256]; size_t esp = 0;\n\n");
+  // Calls are C calls, so a frame only keeps what stack() and throw need.
+  fprintf(hdr, "typedef struct { size_t arena_mark; } Frame;\n");
+  rt_var(f, "Frame call_stack[4096]", "");
+  rt_var(f, "size_t csp", " = 0");
+  fprintf(hdr, "typedef struct { jmp_buf env; size_t old_sp; size_t old_csp; "
+               "uint32_t old_regions; } ExceptionFrame;\n");
+  fprintf(hdr, "#define EXCEPTION_STACK_SIZE 256\n");
+  rt_var(f, "ExceptionFrame exception_stack[EXCEPTION_STACK_SIZE]", "");
+  rt_var(f, "size_t esp", " = 0");
+  rt_var(f, "Value thrown", "");
+  rt_fn(f, "void fatal_handler_overflow(void)");
+  fprintf(f, "  fprintf(stderr, \"\\033[1;31m[FATAL ERROR]\\033[0m Exception "
+             "handler stack overflow (limit %%d open try blocks).\\n  This "
+             "usually means a try inside unbounded recursion.\\n\", "
+             "EXCEPTION_STACK_SIZE); exit(1);\n}\n\n");
+
+  // stack() arena: same bump region as the VM, reset by RET and THROW.
+  fprintf(hdr, "#define ARENA_SIZE (64 * 1024 * 1024)\n"
+               "#define IN_ARENA(p) ((uint8_t *)(p) >= arena && (uint8_t *)(p) "
+               "< arena + ARENA_SIZE)\n");
+  // Past ARENA_SIZE, structs spill to the heap, as in the VM.
+  rt_var(f, "uint8_t arena[ARENA_SIZE] __attribute__((aligned(16)))", "");
+  rt_var(f, "size_t arena_top", " = 0");
+  fprintf(hdr, "typedef struct { void *ptr; size_t at; } Spill;\n");
+  rt_var(f, "Spill *spills", " = NULL");
+  rt_var(f, "uint32_t spill_count", " = 0");
+  rt_var(f, "uint32_t spill_cap", " = 0");
+  rt_fn(f, "void *arena_alloc(uint32_t size)");
+  fprintf(f, "  size = size ? (size + 7) & ~7u : 8;\n"
+             "  void *p;\n"
+             "  if (arena_top + size <= ARENA_SIZE) { p = arena + arena_top; "
+             "memset(p, 0, size); }\n"
+             "  else { if (spill_count == spill_cap) { spill_cap = spill_cap ? "
+             "spill_cap * 2 : 64; spills = realloc(spills, spill_cap * "
+             "sizeof(Spill)); }\n"
+             "    p = calloc(1, size);\n"
+             "    if (!p || !spills) { fprintf(stderr, \"\\033[1;31m[FATAL "
+             "ERROR]\\033[0m Out of memory for stack() structs.\\n\"); "
+             "exit(1); }\n"
+             "    spills[spill_count++] = (Spill){p, arena_top}; }\n"
+             "  arena_top += size; return p;\n}\n\n");
+  rt_fn(f, "int64_t spill_find(const void *p)");
+  fprintf(f, "  for (uint32_t i = spill_count; i-- > 0;) if (spills[i].ptr == "
+             "p) return i;\n  return -1;\n}\n\n");
+  rt_fn(f, "void spill_release(size_t mark)");
+  fprintf(f, "  while (spill_count > 0 && spills[spill_count - 1].at >= mark) "
+             "free(spills[--spill_count].ptr);\n}\n\n");
+
+  // new() slabs: same size classes and region as the VM's heap_alloc.
+  fprintf(hdr, "#define SLAB_MAX 512\n#define SLAB_CLASSES (SLAB_MAX / 8 + "
+               "1)\n#define SLAB_CHUNK (64 * 1024)\n"
+               "#define SLAB_REGION ((size_t)1 << 30)\n"
+               "#define SLAB_FREED 0xDEADF4EE5AB5F4EEULL\n");
+  rt_var(f, "uint8_t *slab_base", " = NULL");
+  rt_var(f, "size_t slab_used", " = 0");
+  rt_var(f, "uint8_t slab_class[SLAB_REGION / SLAB_CHUNK]", "");
+  rt_var(f, "void *slab_free_list[SLAB_CLASSES]", "");
+  rt_var(f, "size_t slab_next[SLAB_CLASSES]", "");
+  rt_var(f, "size_t slab_end[SLAB_CLASSES]", "");
+  rt_var(f, "uint64_t slab_allocs", " = 0");
+  rt_var(f, "uint64_t slab_reused", " = 0");
+  rt_fn(f, "int slab_refill(uint32_t c)");
+  fprintf(f, "  if (slab_used + SLAB_CHUNK > SLAB_REGION) return 0;\n"
+             "  if (!slab_base) { void *r = mmap(NULL, SLAB_REGION, PROT_READ "
+             "| PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, "
+             "0); if (r == MAP_FAILED) { slab_used = SLAB_REGION; return 0; } "
+             "slab_base = r; }\n"
+             "  slab_class[slab_used / SLAB_CHUNK] = (uint8_t)c; slab_next[c] "
+             "= slab_used; slab_end[c] = slab_used + SLAB_CHUNK; slab_used += "
+             "SLAB_CHUNK; return 1;\n}\n");
+  rt_fn(f, "int slab_listed(uint32_t c, const void *ptr)");
+  fprintf(f, "  for (void *p = slab_free_list[c]; p; p = *(void **)p) if (p "
+             "== ptr) return 1;\n  return 0;\n}\n");
+  rt_fn(f, "void fatal_double_free(void)");
+  fprintf(f, "  fprintf(stderr, \"\\033[1;31m[FATAL ERROR]\\033[0m Double "
+             "free of a new() object.\\n  free() was already called on it; "
+             "free each new() result once.\\n\"); exit(1);\n}\n");
+  // arena { } blocks: same region scheme as the VM.
+  fprintf(hdr, "#define REGION_SIZE ((size_t)1 << 30)\n#define REGION_DEPTH "
+               "256\n"
+               "typedef struct { size_t mark; size_t open_ip; uint32_t "
+               "objects; } Region;\n"
+               "#define IN_REGION(p) (region_base && (uint8_t *)(p) >= "
+               "region_base && (uint8_t *)(p) < region_base + REGION_SIZE)\n");
+  rt_var(f, "uint8_t *region_base", " = NULL");
+  rt_var(f, "size_t region_top", " = 0");
+  rt_var(f, "size_t region_clean", " = 0");
+  rt_var(f, "Region regions[REGION_DEPTH]", "");
+  rt_var(f, "uint32_t region_depth", " = 0");
+  rt_var(f, "uint64_t regions_closed", " = 0");
+  rt_var(f, "uint64_t region_objects", " = 0");
+  rt_fn(f, "void region_fatal(const char *what)");
+  fprintf(f, "  fprintf(stderr, \"\\033[1;31m[FATAL ERROR]\\033[0m arena "
+             "block %%s.\\n\", what); exit(1);\n}\n");
+  rt_fn(f, "void region_begin(size_t ip)");
+  fprintf(f, "  if (region_depth == REGION_DEPTH) region_fatal(\"nesting too "
+             "deep (limit 256)\");\n"
+             "  if (!region_base) { void *r = mmap(NULL, REGION_SIZE, "
+             "PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | "
+             "MAP_NORESERVE, -1, 0); if (r == MAP_FAILED) region_fatal(\"memory "
+             "could not be reserved\"); region_base = r; }\n"
+             "  regions[region_depth++] = (Region){region_top, ip, 0};\n}\n");
+  rt_fn(f, "void *region_alloc(uint32_t size)");
+  fprintf(f, "  size = size ? (size + 7) & ~7u : 8;\n"
+             "  if (size > REGION_SIZE - region_top) region_fatal(\"memory "
+             "exhausted (limit 1024 MiB)\");\n"
+             "  uint8_t *p = region_base + region_top;\n"
+             "  if (region_top < region_clean) memset(p, 0, size < "
+             "region_clean - region_top ? size : region_clean - region_top);\n"
+             "  region_top += size; if (region_top > region_clean) "
+             "region_clean = region_top;\n"
+             "  regions[region_depth - 1].objects++; region_objects++; return "
+             "p;\n}\n");
+  fprintf(hdr, "static inline void *heap_alloc(uint32_t size) {\n"
+               "  if (region_depth) return region_alloc(size);\n"
+               "  uint32_t c = size > 8 ? (size + 7) >> 3 : 2;\n"
+               "  if (c >= SLAB_CLASSES) return calloc(1, size);\n"
+               "  void *p = slab_free_list[c];\n"
+               "  if (p) { slab_free_list[c] = *(void **)p; memset(p, 0, c * "
+               "8); slab_reused++; }\n"
+               "  else { if (slab_next[c] + c * 8 > slab_end[c] && "
+               "!slab_refill(c)) return calloc(1, size); p = slab_base + "
+               "slab_next[c]; slab_next[c] += c * 8; }\n"
+               "  slab_allocs++; return p;\n}\n");
+  // As in the VM, a heap string freed through OP_FREE is told apart by its
+  // alignment.
+  fprintf(hdr, "static inline void heap_free(void *p) {\n"
+               "  if (((uintptr_t)p & 7) == %d) free((char *)p - %d);\n"
+               "  else if (slab_base && (uint8_t *)p >= slab_base && (uint8_t "
+               "*)p < slab_base + slab_used) { uint32_t c = "
+               "slab_class[((uint8_t *)p - slab_base) / SLAB_CHUNK]; "
+               "uint64_t *w = p; if (w[1] == SLAB_FREED && slab_listed(c, p)) "
+               "fatal_double_free(); *(void **)p = slab_free_list[c]; w[1] = "
+               "SLAB_FREED; slab_free_list[c] = p; }\n"
+               "  else free(p);\n}\n\n",
+          STR_HDR, STR_HDR);
+
+  // Output buffer: same scheme and formatting as the VM's out_* helpers.
+  fprintf(hdr, "#define OUT_SIZE (64 * 1024)\n");
+  rt_var(f, "char out_buf[OUT_SIZE]", "");
+  rt_var(f, "size_t out_len", " = 0");
+  rt_var(f, "int out_tty", " = 0");
+  rt_fn(f, "void out_flush(void)");
+  fprintf(f, "  fflush(stdout);\n"
+             "  for (size_t done = 0; done < out_len;) { ssize_t n = "
+             "write(STDOUT_FILENO, out_buf + done, out_len - done); if (n < 0 "
+             "&& errno == EINTR) continue; if (n <= 0) break; done += "
+             "(size_t)n; }\n"
+             "  out_len = 0;\n}\n");
+  fprintf(hdr, "static inline void out_reserve(size_t n) { if (out_len + n > "
+               "OUT_SIZE) out_flush(); }\n");
+  fprintf(hdr, "static inline void out_char(char c) { out_reserve(1); "
+               "out_buf[out_len++] = c; if (c == '\\n' && out_tty) "
+               "out_flush(); }\n");
+  rt_fn(f, "void out_mem(const char *s, size_t n)");
+  fprintf(f, "  while (n) { if (out_len == OUT_SIZE) out_flush(); size_t k = "
+             "OUT_SIZE - out_len < n ? OUT_SIZE - out_len : n; memcpy(out_buf "
+             "+ out_len, s, k); out_len += k; s += k; n -= k; }\n}\n");
+  fprintf(hdr, "static inline void out_str(const char *s) { out_mem(s, "
+               "strlen(s)); }\n");
+  // Length-prefixed strings, as in the VM (see STR_HDR).
+  fprintf(hdr, "#define STR_HDR %d\n", STR_HDR);
+  fprintf(hdr, "static inline uint32_t str_len(const char *s) { uint32_t n; "
+               "memcpy(&n, s - STR_HDR, sizeof(n)); return n; }\n");
+  fprintf(hdr, "static inline void out_lstr(const char *s) { out_mem(s, "
+               "str_len(s)); }\n");
+  rt_fn(f, "char *str_alloc(size_t n)");
+  fprintf(f, "  char *s = malloc(STR_HDR + n + 1); uint32_t len = (uint32_t)n; "
+             "memcpy(s, &len, sizeof(len)); s += STR_HDR; s[n] = 0; return "
+             "s;\n}\n");
+  fprintf(hdr, "static inline void out_digits(uint64_t u, int width) { char "
+               "tmp[20]; int n = 0; do tmp[n++] = (char)('0' + u %% 10); while "
+               "((u /= 10) || n < width); while (n) out_buf[out_len++] = "
+               "tmp[--n]; }\n");
+  fprintf(hdr, "static inline void out_int(int64_t v) { out_reserve(21); if (v "
+               "< 0) out_buf[out_len++] = '-'; out_digits(v < 0 ? 0 - "
+               "(uint64_t)v : (uint64_t)v, 1); }\n");
+  fprintf(hdr, "static inline int float_micros(double v, uint64_t *r) {\n"
+               "  double a = v < 0 ? -v : v; if (!(a < 1e9)) return 0;\n"
+               "  double s = a * 1e6; uint64_t u = (uint64_t)s; double frac = "
+               "s - (double)u, err = s * 0x1p-52; if (frac > 0.5 + err || frac < "
+               "0.5 - err) { *r = u + (frac > 0.5); return 1; }\n"
+               "  return 0;\n}\n");
+  rt_fn(f, "void out_float(double v)");
+  fprintf(f, "  uint64_t r; if (float_micros(v, &r)) { out_reserve(18); if "
+             "(signbit(v)) out_buf[out_len++] = '-'; out_digits(r / 1000000, "
+             "1); out_buf[out_len++] = '.'; out_digits(r %% 1000000, 6); "
+             "return; }\n"
+             "  char buf[512]; snprintf(buf, sizeof(buf), \"%%.6f\", v); "
+             "out_str(buf);\n}\n\n");
+  // OP_STR_CAT_N and strbuf appends, as in the VM: lengths first, one
+  // allocation, numbers formatted in place.
+  fprintf(hdr, "static inline int dec_len(uint64_t u) { int n = 1; while (u >= "
+               "10) u /= 10, n++; return n; }\n");
+  fprintf(hdr, "static inline void dec_put(char *end, uint64_t u, int width) { "
+               "while (width--) { *--end = (char)('0' + u %% 10); u /= 10; } "
+               "}\n");
+  fprintf(hdr,
+          "static inline uint32_t part_len(uint32_t kind, Value v, uint64_t "
+          "*num) {\n"
+          "  switch (kind) {\n"
+          "  case %d: return str_len(v.p);\n"
+          "  case %d: *num = v.i < 0 ? 0 - (uint64_t)v.i : (uint64_t)v.i; "
+          "return (v.i < 0) + dec_len(*num);\n"
+          "  case %d: if (float_micros(v.f, num)) return (signbit(v.f) != 0) "
+          "+ dec_len(*num / 1000000) + 7; *num = UINT64_MAX; return "
+          "(uint32_t)snprintf(NULL, 0, \"%%.6f\", v.f);\n"
+          "  default: return 1; }\n}\n",
+          CAT_STR, CAT_INT, CAT_FLOAT);
+  fprintf(hdr,
+          "static inline void part_put(char *d, uint32_t kind, Value v, "
+          "uint32_t len, uint64_t num) {\n"
+          "  switch (kind) {\n"
+          "  case %d: memcpy(d, v.p, len); break;\n"
+          "  case %d: if (v.i < 0) *d = '-'; dec_put(d + len, num, len - (v.i "
+          "< 0)); break;\n"
+          "  case %d: { if (num == UINT64_MAX) { snprintf(d, len + 1, "
+          "\"%%.6f\", v.f); break; } int sign = signbit(v.f) != 0, whole = "
+          "(int)len - 7 - sign; if (sign) *d = '-'; dec_put(d + sign + whole, "
+          "num / 1000000, whole); d[sign + whole] = '.'; dec_put(d + len, num "
+          "%% 1000000, 6); break; }\n"
+          "  default: *d = (char)v.i; }\n}\n",
+          CAT_STR, CAT_INT, CAT_FLOAT);
+  rt_fn(f, "char *str_cat_n(const Value *part, uint32_t n, uint32_t kinds)");
+  fprintf(f,
+          "  uint64_t num[%d]; uint32_t len[%d]; size_t total = 0;\n"
+          "  for (uint32_t i = 0; i < n; i++) total += len[i] = "
+          "part_len((kinds >> 2 * i) & 3, part[i], &num[i]);\n"
+          "  char *s = str_alloc(total), *d = s;\n"
+          "  for (uint32_t i = 0; i < n; d += len[i++]) part_put(d, (kinds >> "
+          "2 * i) & 3, part[i], len[i], num[i]);\n"
+          "  return s;\n}\n",
+          CAT_MAX, CAT_MAX);
 
   // --- 2. STRINGS & STRUCTS ---
-  fprintf(f, "char *strs[%d] = {\n", str_count == 0 ? 1 : str_count);
+  // One data array holding every literal behind its length header (octal
+  // escapes, so a following digit cannot extend them), then strs[] pointing
+  // at the chars.
+  fprintf(f, "static char str_data[] =\n");
   for (int i = 0; i < str_count; i++) {
+    uint32_t len = strlen(strs[i]);
+    uint8_t hdr[STR_HDR];
+    memcpy(hdr, &len, STR_HDR);
     fprintf(f, "  \"");
+    for (int j = 0; j < STR_HDR; j++)
+      fprintf(f, "\\%03o", hdr[j]);
     for (int j = 0; strs[i][j]; j++) {
       if (strs[i][j] == '\n')
         fprintf(f, "\\n");
@@ -51,13 +1908,24 @@ void generate_native_code(const char *out_filename, int enable_profiler) {
       else
         fprintf(f, "%c", strs[i][j]);
     }
-    fprintf(f, "\",\n");
+    fprintf(f, "\\0\"\n");
+  }
+  fprintf(f, "  \"\";\n");
+  char decl[64];
+  snprintf(decl, sizeof(decl), "char *strs[%d]", str_count ? str_count : 1);
+  rt_extern(decl);
+  fprintf(f, "%s = {\n", decl);
+  for (size_t i = 0, off = STR_HDR; i < (size_t)str_count; i++) {
+    fprintf(f, "  str_data + %zu,\n", off);
+    off += STR_HDR + strlen(strs[i]) + 1;
   }
   fprintf(f, "};\n\n");
 
-  fprintf(f, "typedef struct { char *name; uint32_t size; } StructMeta;\n");
-  fprintf(f, "StructMeta structs[%d] = {\n",
-          struct_count == 0 ? 1 : struct_count);
+  fprintf(hdr, "typedef struct { char *name; uint32_t size; } StructMeta;\n");
+  snprintf(decl, sizeof(decl), "StructMeta structs[%d]",
+           struct_count ? struct_count : 1);
+  rt_extern(decl);
+  fprintf(f, "%s = {\n", decl);
   for (int i = 0; i < struct_count; i++) {
     fprintf(f, "  {\"%s\", %d},\n", structs[i].name, structs[i].size);
   }
@@ -65,18 +1933,23 @@ void generate_native_code(const char *out_filename, int enable_profiler) {
 
   // --- 3. ABYSS EYE TRACKER ---
   if (enable_profiler) {
-    fprintf(f,
+    fprintf(hdr,
             "typedef struct AllocInfo { void *ptr; uint32_t struct_id; "
             "uint32_t size; size_t alloc_fp; size_t alloc_ip; size_t free_ip; "
             "char *tag; char *comment; int is_stack; int is_freed; struct "
             "AllocInfo *next; } AllocInfo;\n");
 
-    fprintf(f, "#define ALLOC_BUCKETS 65536\n");
-    fprintf(f, "AllocInfo *alloc_table[ALLOC_BUCKETS] = {NULL};\n");
-    fprintf(f, "int stack_alloc_count = 0;\n\n");
+    fprintf(hdr, "#define ALLOC_BUCKETS 65536\n");
+    rt_var(f, "AllocInfo *alloc_table[ALLOC_BUCKETS]", " = {NULL}");
+    // Live stack() records in arena order, so a release pops only its own.
+    fprintf(f, "AllocInfo **stack_allocs = NULL; size_t stack_alloc_count = "
+               "0, stack_alloc_cap = 0;\n");
+    // Live arena { } records in region order, for the same reason.
+    fprintf(f, "AllocInfo **region_allocs = NULL; size_t region_alloc_count "
+               "= 0, region_alloc_cap = 0;\n\n");
 
-    fprintf(f, "void track_alloc(void *ptr, uint32_t sid, uint32_t size, int "
-               "is_stack, char *comment, size_t ip, size_t fp) {\n");
+    rt_fn(f, "void track_alloc(void *ptr, uint32_t sid, uint32_t size, int "
+             "is_stack, char *comment, size_t ip, size_t fp)");
     fprintf(f, "  uint32_t idx = ((uintptr_t)ptr >> 4) & 0xFFFF;\n");
     fprintf(
         f, "  AllocInfo *node = malloc(sizeof(AllocInfo)); node->ptr = ptr; "
@@ -84,26 +1957,46 @@ void generate_native_code(const char *out_filename, int enable_profiler) {
            "node->alloc_ip = ip; node->free_ip = 0; node->tag = NULL; "
            "node->comment = comment; node->is_stack = is_stack; node->is_freed "
            "= 0; node->next = alloc_table[idx]; alloc_table[idx] = node;\n"
-           "  if (is_stack) stack_alloc_count++;\n}\n");
+           "  if (is_stack) { if (stack_alloc_count == stack_alloc_cap) { "
+           "stack_alloc_cap = stack_alloc_cap ? stack_alloc_cap * 2 : 256; "
+           "stack_allocs = realloc(stack_allocs, stack_alloc_cap * "
+           "sizeof(AllocInfo *)); } stack_allocs[stack_alloc_count++] = node; "
+           "}\n"
+           "  else if (region_depth && IN_REGION(ptr)) { if "
+           "(region_alloc_count == region_alloc_cap) { region_alloc_cap = "
+           "region_alloc_cap ? region_alloc_cap * 2 : 256; region_allocs = "
+           "realloc(region_allocs, region_alloc_cap * sizeof(AllocInfo *)); } "
+           "region_allocs[region_alloc_count++] = node; }\n}\n");
 
-    fprintf(f, "void untrack_alloc(void *ptr, size_t ip) {\n"
-               "  uint32_t idx = ((uintptr_t)ptr >> 4) & 0xFFFF;\n"
+    rt_fn(f, "void untrack_alloc(void *ptr, size_t ip)");
+    fprintf(f, "  uint32_t idx = ((uintptr_t)ptr >> 4) & 0xFFFF;\n"
                "  AllocInfo *curr = alloc_table[idx]; while(curr) { "
                "if(curr->ptr == ptr && "
                "!curr->is_freed) { curr->is_freed = 1; curr->free_ip = ip; "
                "return; } curr = curr->next; }\n}\n");
 
-    fprintf(
-        f,
-        "void free_stack_allocs(size_t current_fp, size_t ip) {\n"
-        "  if (stack_alloc_count == 0) return;\n"
-        "  for(int i=0; i<ALLOC_BUCKETS; i++) { AllocInfo "
-        "*curr = alloc_table[i]; while(curr) { if(curr->is_stack && "
-        "!curr->is_freed && curr->alloc_fp >= current_fp) { curr->is_freed = "
-        "1; curr->free_ip = ip; free(curr->ptr); stack_alloc_count--; "
-        "} curr = curr->next; } }\n}\n");
-
-    fprintf(f, "void abyss_eye() {\n");
+    rt_fn(f, "size_t arena_pos(const void *p, uint32_t *s)");
+    fprintf(f, "  if (IN_ARENA(p)) return (size_t)((const uint8_t *)p - "
+               "arena);\n  while (*s > 0 && spills[*s - 1].ptr != p) (*s)--;\n"
+               "  return *s ? spills[*s - 1].at : 0;\n}\n");
+    rt_fn(f, "void arena_release(size_t mark, size_t ip)");
+    fprintf(f, "  uint32_t s = spill_count;\n"
+               "  while (stack_alloc_count > 0 && "
+               "arena_pos(stack_allocs[stack_alloc_count-1]->ptr, &s) >= mark) { "
+               "AllocInfo *a = stack_allocs[--stack_alloc_count]; if "
+               "(!a->is_freed) { a->is_freed = 1; a->free_ip = ip; } }\n"
+               "  spill_release(mark); arena_top = mark;\n}\n");
+    rt_fn(f, "void region_release(uint32_t depth, size_t ip)");
+    fprintf(f, "  size_t mark = regions[depth].mark;\n"
+               "  while (region_alloc_count > 0 && (uint8_t "
+               "*)region_allocs[region_alloc_count-1]->ptr >= region_base + "
+               "mark) { AllocInfo *a = region_allocs[--region_alloc_count]; if "
+               "(!a->is_freed) { a->is_freed = 1; a->free_ip = ip; } }\n"
+               "  regions_closed += region_depth - depth; region_top = mark; "
+               "region_depth = depth;\n}\n");
+
+    rt_fn(f, "void abyss_eye(void)");
+    fprintf(f, "  out_flush();\n");
     fprintf(
         f,
         "  uint32_t as=0, ah=0, tf=0, ta=0; int ac=0; "
@@ -145,498 +2038,195 @@ void generate_native_code(const char *out_filename, int enable_profiler) {
             "\" C_BOLD \"%%-8u\" C_RESET \"                                   "
             "                                          \" C_BOLD C_CYAN "
             "\"│\\n\" C_RESET, ta);\n");
+    fprintf(f,
+            "  printf(C_BOLD C_CYAN \"  │\" C_RESET \"  Slab Allocations    : "
+            "\" C_BOLD \"%%-8u\" C_RESET \" recycled \" C_BOLD \"%%-8u\" "
+            "C_RESET \"                                                       "
+            "    \" C_BOLD C_CYAN \"│\\n\" C_RESET, (uint32_t)slab_allocs, "
+            "(uint32_t)slab_reused);\n");
     fprintf(
         f,
         "  printf(C_BOLD C_CYAN \"  "
         "╰───────────────────────────────────────────────────────────────────"
         "───────────────────────────────────────────╯\\n\\n\" C_RESET);\n");
+    fprintf(
+        f,
+        "  if (region_depth || regions_closed) { char row[128];\n"
+        "  printf(C_BOLD C_YELLOW \"  "
+        "╭───────────────────────────────────────────────────────────────────"
+        "───────────────────────────────────────────╮\\n\" C_RESET);\n"
+        "  printf(C_BOLD C_YELLOW \"  │\" C_RESET C_BOLD \"  🧱   A R E N A  "
+        " B L O C K S                                                        "
+        "                       \" C_BOLD C_YELLOW \"│\\n\" C_RESET);\n"
+        "  printf(C_BOLD C_YELLOW \"  "
+        "├───────────────────────────────────────────────────────────────────"
+        "───────────────────────────────────────────┤\\n\" C_RESET);\n"
+        "  for (uint32_t i = 0; i < region_depth; i++) { size_t end = i + 1 < "
+        "region_depth ? regions[i + 1].mark : region_top; snprintf(row, "
+        "sizeof(row), \"  Open #%%-3u  opened at IP:%%04lX   objects %%-8u  "
+        "bytes %%zu\", i + 1, (unsigned long)regions[i].open_ip, "
+        "regions[i].objects, end - regions[i].mark); printf(C_BOLD C_YELLOW "
+        "\"  │\" C_RESET \"%%-109s\" C_BOLD C_YELLOW \"│\\n\" C_RESET, row); "
+        "}\n"
+        "  snprintf(row, sizeof(row), \"  Closed: %%-8lu  objects served "
+        "%%-10lu  peak bytes %%zu\", (unsigned long)regions_closed, (unsigned "
+        "long)region_objects, region_clean);\n"
+        "  printf(C_BOLD C_YELLOW \"  │\" C_RESET C_GRAY \"%%-109s\" C_RESET "
+        "C_BOLD C_YELLOW \"│\\n\" C_RESET, row);\n"
+        "  printf(C_BOLD C_YELLOW \"  "
+        "╰───────────────────────────────────────────────────────────────────"
+        "───────────────────────────────────────────╯\\n\\n\" C_RESET); }\n");
     fprintf(f, "}\n\n");
   } else {
     // --- NO PROFILER: empty stubs, zero overhead ---
-    fprintf(f,
+    fprintf(hdr,
             "static inline void track_alloc(void *p, uint32_t s, uint32_t sz, "
             "int st, char *c, size_t i, size_t f) { (void)p;(void)s;(void)sz;"
             "(void)st;(void)c;(void)i;(void)f; }\n");
-    fprintf(f, "static inline void untrack_alloc(void *p, size_t i) { "
-               "(void)p;(void)i; }\n");
-    fprintf(f, "static inline void free_stack_allocs(size_t f, size_t i) { "
-               "(void)f;(void)i; }\n");
-    fprintf(
-        f,
-        "void abyss_eye() { printf(\"[Abyss Eye disabled in fast native mode. "
-        "Use --native --eye to enable.]\\n\"); }\n\n");
+    fprintf(hdr, "static inline void untrack_alloc(void *p, size_t i) { "
+                 "(void)p;(void)i; }\n");
+    fprintf(hdr, "static inline void arena_release(size_t m, size_t i) { "
+                 "if (spill_count) spill_release(m); arena_top = m; (void)i; "
+                 "}\n");
+    fprintf(hdr, "static inline void region_release(uint32_t d, size_t i) { "
+                 "regions_closed += region_depth - d; region_top = "
+                 "regions[d].mark; region_depth = d; (void)i; }\n");
+    rt_fn(f, "void abyss_eye(void)");
+    fprintf(f, "  out_flush(); printf(\"[Abyss Eye disabled in fast native "
+               "mode. Use --native --eye to enable.]\\n\");\n}\n\n");
   }
 
-  // --- 4. MAIN FUNCTION & JUMP TABLE ---
-  fprintf(f, "int main() {\n");
-  fprintf(f, "  register size_t sp = 0, fp = 0;\n");
-
-  fprintf(f, "  static void *jump_table[%zu] = {0};\n", code_sz + 1);
-  size_t ip = 0;
-  while (ip < code_sz) {
-    fprintf(f, "  jump_table[%zu] = &&L_%zu;\n", ip, ip);
-    uint8_t op = code[ip++];
-
-    if (op == OP_CONST_INT || op == OP_CONST_STR || op == OP_JMP ||
-        op == OP_JZ || op == OP_TRY || op == OP_NATIVE || op == OP_TAG_ALLOC)
-      ip += 4;
-    else if (op == OP_CONST_FLOAT)
-      ip += 8;
-    else if (op == OP_CALL)
-      ip += 5;
-    else if (op == OP_ALLOC_STRUCT || op == OP_ALLOC_ARRAY ||
-             op == OP_ALLOC_STACK)
-      ip += 8;
-    else if (op == OP_GET_GLOBAL || op == OP_SET_GLOBAL || op == OP_GET_LOCAL ||
-             op == OP_SET_LOCAL || op == OP_RET || op == OP_GET_FIELD ||
-             op == OP_SET_FIELD || op == OP_PRINT_FMT || op == OP_CALL_DYN_BOT)
-      ip += 1;
-  }
-
-  // --- 5. BYTECODE TRANSLATION LOOP ---
-  ip = 0;
-  while (ip < code_sz) {
-    fprintf(f, "L_%zu:\n", ip);
-    uint8_t op = code[ip++];
-
-    switch (op) {
-    case OP_HALT:
-      fprintf(f, "  goto cleanup;\n");
-      break;
-    case OP_CONST_INT: {
-      int32_t v;
-      memcpy(&v, code + ip, 4);
-      ip += 4;
-      fprintf(f, "  stack[sp++].i = %d;\n", v);
-      break;
-    }
-    case OP_CONST_FLOAT: {
-      uint64_t v;
-      memcpy(&v, code + ip, 8);
-      ip += 8;
-      // Emit as hex literal cast from unsigned to signed. This is safe
-      // for every possible IEEE-754 bit pattern, including future NaN,
-      // Infinity, and hex-float literals that could set the high bit.
-      fprintf(f, "  stack[sp++].i = (int64_t)0x%016lxULL;\n", v);
-      break;
-    }
-    case OP_CONST_STR: {
-      uint32_t v;
-      memcpy(&v, code + ip, 4);
-      ip += 4;
-      fprintf(f, "  stack[sp++].p = strs[%u];\n", v);
-      break;
-    }
-
-    case OP_ADD:
-      fprintf(f, "  stack[sp-2].i += stack[sp-1].i; sp--;\n");
-      break;
-    case OP_SUB:
-      fprintf(f, "  stack[sp-2].i -= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_MUL:
-      fprintf(f, "  stack[sp-2].i *= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_DIV:
-      fprintf(f, "  stack[sp-2].i /= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_MOD:
-      fprintf(f, "  stack[sp-2].i %%= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_NEG:
-      fprintf(f, "  stack[sp-1].i = -stack[sp-1].i;\n");
-      break;
-
-    case OP_ADD_F:
-      fprintf(f, "  stack[sp-2].f += stack[sp-1].f; sp--;\n");
-      break;
-    case OP_SUB_F:
-      fprintf(f, "  stack[sp-2].f -= stack[sp-1].f; sp--;\n");
-      break;
-    case OP_MUL_F:
-      fprintf(f, "  stack[sp-2].f *= stack[sp-1].f; sp--;\n");
-      break;
-    case OP_DIV_F:
-      fprintf(f, "  stack[sp-2].f /= stack[sp-1].f; sp--;\n");
-      break;
-    case OP_NEG_F:
-      fprintf(f, "  stack[sp-1].f = -stack[sp-1].f;\n");
-      break;
-
-    case OP_LT:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].i < stack[sp-1].i); sp--;\n");
-      break;
-    case OP_LE:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].i <= stack[sp-1].i); sp--;\n");
-      break;
-    case OP_GT:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].i > stack[sp-1].i); sp--;\n");
-      break;
-    case OP_GE:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].i >= stack[sp-1].i); sp--;\n");
-      break;
-    case OP_EQ:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].i == stack[sp-1].i); sp--;\n");
-      break;
-    case OP_NE:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].i != stack[sp-1].i); sp--;\n");
-      break;
-
-    case OP_LT_F:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].f < stack[sp-1].f); sp--;\n");
-      break;
-    case OP_LE_F:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].f <= stack[sp-1].f); sp--;\n");
-      break;
-    case OP_GT_F:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].f > stack[sp-1].f); sp--;\n");
-      break;
-    case OP_GE_F:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].f >= stack[sp-1].f); sp--;\n");
-      break;
-    case OP_EQ_F:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].f == stack[sp-1].f); sp--;\n");
-      break;
-    case OP_NE_F:
-      fprintf(f, "  stack[sp-2].i = (stack[sp-2].f != stack[sp-1].f); sp--;\n");
-      break;
-
-    case OP_AND:
-      fprintf(f, "  stack[sp-2].i = stack[sp-2].i && stack[sp-1].i; sp--;\n");
-      break;
-    case OP_OR:
-      fprintf(f, "  stack[sp-2].i = stack[sp-2].i || stack[sp-1].i; sp--;\n");
-      break;
-    case OP_NOT:
-      fprintf(f, "  stack[sp-1].i = !stack[sp-1].i;\n");
-      break;
-
-    case OP_BIT_AND:
-      fprintf(f, "  stack[sp-2].i &= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_BIT_OR:
-      fprintf(f, "  stack[sp-2].i |= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_BIT_XOR:
-      fprintf(f, "  stack[sp-2].i ^= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_SHL:
-      fprintf(f, "  stack[sp-2].i <<= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_SHR:
-      fprintf(f, "  stack[sp-2].i >>= stack[sp-1].i; sp--;\n");
-      break;
-    case OP_BIT_NOT:
-      fprintf(f, "  stack[sp-1].i = ~stack[sp-1].i;\n");
-      break;
-
-    case OP_JMP: {
-      uint32_t t;
-      memcpy(&t, code + ip, 4);
-      ip += 4;
-      fprintf(f, "  goto L_%u;\n", t);
-      break;
-    }
-    case OP_JZ: {
-      uint32_t t;
-      memcpy(&t, code + ip, 4);
-      ip += 4;
-      fprintf(f, "  if (!stack[--sp].i) goto L_%u;\n", t);
-      break;
-    }
-
-    case OP_PRINT:
-      fprintf(f, "  printf(\"%%ld\\n\", stack[--sp].i);\n");
-      break;
-    case OP_PRINT_F:
-      fprintf(f, "  printf(\"%%.6f\\n\", stack[--sp].f);\n");
-      break;
-    case OP_PRINT_STR:
-      fprintf(f, "  printf(\"%%s\\n\", (char*)stack[--sp].p);\n");
-      break;
-    case OP_PRINT_CHAR:
-      fprintf(f, "  printf(\"%%c\", (char)stack[--sp].i);\n");
-      break;
-    case OP_PRINT_FMT: {
-      uint8_t argc = code[ip++];
-      fprintf(
-          f,
-          "  { uint8_t argc = %u; char *fmt = (char *)stack[sp - 1 - argc].p; "
-          "int current_arg = 0; for (int i = 0; fmt[i]; i++) { if (fmt[i] == "
-          "'%%') { i++; if (fmt[i] == '{') i++; char type_buf[32]; int ti = 0; "
-          "while (fmt[i] && isalpha(fmt[i]) && ti < 31) type_buf[ti++] = "
-          "fmt[i++]; type_buf[ti] = 0; if (fmt[i] == '}') i++; else i--; if "
-          "(current_arg < argc) { Value val = stack[sp - argc + current_arg]; "
-          "if (!strcmp(type_buf, \"int\") || !strcmp(type_buf, \"integer\")) "
-          "printf(\"%%ld\", val.i); else if (!strcmp(type_buf, \"float\")) "
-          "printf(\"%%.6f\", val.f); else if (!strcmp(type_buf, \"str\") || "
-          "!strcmp(type_buf, \"string\")) printf(\"%%s\", (char *)val.p); else "
-          "if (!strcmp(type_buf, \"char\")) printf(\"%%c\", (char)val.i); "
-          "current_arg++; } } else putchar(fmt[i]); } printf(\"\\n\"); sp -= "
-          "(argc + 1); }\n",
-          argc);
-      break;
-    }
-
-    case OP_GET_GLOBAL:
-      fprintf(f, "  stack[sp++] = globals[%u];\n", code[ip++]);
-      break;
-    case OP_SET_GLOBAL:
-      fprintf(f, "  globals[%u] = stack[--sp];\n", code[ip++]);
-      break;
-    case OP_GET_LOCAL:
-      fprintf(f, "  stack[sp++] = stack[fp + %u];\n", code[ip++]);
-      break;
-    case OP_SET_LOCAL:
-      fprintf(f, "  stack[fp + %u] = stack[--sp];\n", code[ip++]);
-      break;
-
-    case OP_CALL: {
-      uint32_t addr;
-      memcpy(&addr, code + ip, 4);
-      ip += 4;
-      uint8_t argc = code[ip++];
-      fprintf(f,
-              "  call_stack[csp].ret_addr = %zu; call_stack[csp].old_fp = fp; "
-              "csp++; fp = sp - %u; goto L_%u;\n",
-              ip, argc, addr);
-      break;
-    }
-    case OP_RET: {
-      uint8_t count = code[ip++];
-      fprintf(
-          f,
-          "  { Value rets[8]; for(int i=0; i<%u; i++) rets[i] = stack[--sp]; "
-          "free_stack_allocs(fp, %zu); if(csp==0) goto cleanup; csp--; size_t "
-          "r = call_stack[csp].ret_addr; "
-          "sp = fp; "
-          "fp = call_stack[csp].old_fp; for(int "
-          "i=%u-1; i>=0; i--) stack[sp++] = rets[i]; goto *jump_table[r]; }\n",
-          count, ip, count);
-      break;
-    }
-    case OP_CALL_DYN_BOT: {
-      uint8_t argc = code[ip++];
-      fprintf(f,
-              "  { uint32_t addr = stack[sp - %u - 1].i; for(int i=0; i<%u; "
-              "i++) stack[sp - %u - 1 + i] = stack[sp - %u + i]; sp--; "
-              "call_stack[csp].ret_addr = %zu; call_stack[csp].old_fp = fp; "
-              "csp++; fp = sp - %u; goto *jump_table[addr]; }\n",
-              argc, argc, argc, argc, ip, argc);
-      break;
-    }
-    case OP_POP:
-      fprintf(f, "  sp--;\n");
-      break;
-    case OP_DUP:
-      fprintf(f, "  stack[sp] = stack[sp-1]; sp++;\n");
-      break;
+  // String builders, as in the VM. They track their block themselves, so
+  // they come after Abyss Eye and take ip and fp for it.
+  fprintf(hdr, "typedef struct { char *s; uint32_t len; uint32_t cap; } "
+               "StrBuf;\n");
+  rt_fn(f, "char *strbuf_grow(StrBuf *b, uint32_t n, size_t ip, size_t fp)");
+  fprintf(f,
+          "  if ((size_t)b->len + n > b->cap) { size_t cap = b->cap ? b->cap "
+          ": 56; while (cap < (size_t)b->len + n) cap *= 2; if (b->s) "
+          "untrack_alloc(b->s, ip); char *blk = realloc(b->s ? b->s - STR_HDR "
+          ": NULL, STR_HDR + cap + 1); b->s = blk + STR_HDR; b->cap = "
+          "(uint32_t)cap; track_alloc(b->s, 0xFFFFFFFE, b->cap + 1, 0, "
+          "\"String Builder\", ip, fp); }\n"
+          "  char *d = b->s + b->len; b->len += n; return d;\n}\n");
+  rt_fn(f, "void strbuf_append(StrBuf *b, uint32_t kind, Value v, size_t ip, "
+           "size_t fp)");
+  fprintf(f, "  uint64_t num = 0; uint32_t len = part_len(kind, v, &num); "
+             "part_put(strbuf_grow(b, len, ip, fp), kind, v, len, num);\n}\n");
+  rt_fn(f, "char *strbuf_str(StrBuf *b, size_t ip, size_t fp)");
+  fprintf(f,
+          "  char *s = b->s; if (!s) { s = str_alloc(0); track_alloc(s, "
+          "0xFFFFFFFE, 1, 0, \"String Builder\", ip, fp); return s; }\n"
+          "  memcpy(s - STR_HDR, &b->len, sizeof(b->len)); s[b->len] = 0; "
+          "b->s = NULL; b->len = b->cap = 0; return s;\n}\n");
+  rt_fn(f, "void strbuf_free(StrBuf *b, size_t ip)");
+  fprintf(f, "  if (!b) return;\n"
+             "  if (b->s) { untrack_alloc(b->s, ip); free(b->s - STR_HDR); }\n"
+             "  free(b);\n}\n\n");
 
-    case OP_ALLOC_STRUCT: {
-      uint32_t sid, cidx;
-      memcpy(&sid, code + ip, 4);
-      ip += 4;
-      memcpy(&cidx, code + ip, 4);
-      ip += 4;
-      if (cidx == 0xFFFFFFFF) {
-        fprintf(
-            f,
-            "  { uint32_t sz = structs[%u].size * 8; int64_t *p = calloc(1, "
-            "sz); "
-            "track_alloc(p, %u, sz, 0, NULL, %zu, fp); stack[sp++].p = p; }\n",
-            sid, sid, ip);
-      } else {
-        fprintf(f,
-                "  { uint32_t sz = structs[%u].size * 8; int64_t *p = "
-                "calloc(1, sz); "
-                "track_alloc(p, %u, sz, 0, strs[%u], %zu, fp); stack[sp++].p = "
-                "p; }\n",
-                sid, sid, cidx, ip);
-      }
-      break;
-    }
-    case OP_ALLOC_ARRAY: {
-      uint32_t elem_sz;
-      memcpy(&elem_sz, code + ip, 4);
-      ip += 4;
-      uint32_t cidx;
-      memcpy(&cidx, code + ip, 4);
-      ip += 4;
-      if (cidx == 0xFFFFFFFF) {
-        fprintf(f,
-                "  { int64_t c = stack[--sp].i; uint32_t sz = c * %u; int64_t "
-                "*p = calloc(1, sz); track_alloc(p, 0xFFFFFFFF, sz, 0, "
-                "\"Array Alloc\", %zu, fp); stack[sp++].p = p; }\n",
-                elem_sz, ip);
-      } else {
-        fprintf(f,
-                "  { int64_t c = stack[--sp].i; uint32_t sz = c * %u; int64_t "
-                "*p = calloc(1, sz); track_alloc(p, 0xFFFFFFFF, sz, 0, "
-                "strs[%u], %zu, fp); stack[sp++].p = p; }\n",
-                elem_sz, cidx, ip);
-      }
-      break;
-    }
-    case OP_ALLOC_STACK: {
-      uint32_t sid, cidx;
-      memcpy(&sid, code + ip, 4);
-      ip += 4;
-      memcpy(&cidx, code + ip, 4);
-      ip += 4;
-      if (cidx == 0xFFFFFFFF) {
-        fprintf(
-            f,
-            "  { uint32_t sz = structs[%u].size * 8; int64_t *p = calloc(1, "
-            "sz); "
-            "track_alloc(p, %u, sz, 1, NULL, %zu, fp); stack[sp++].p = p; }\n",
-            sid, sid, ip);
-      } else {
-        fprintf(f,
-                "  { uint32_t sz = structs[%u].size * 8; int64_t *p = "
-                "calloc(1, sz); "
-                "track_alloc(p, %u, sz, 1, strs[%u], %zu, fp); stack[sp++].p = "
-                "p; }\n",
-                sid, sid, cidx, ip);
-      }
-      break;
+  // --- 4. FUNCTIONS ---
+  // Each AbyssLang function is `size_t fn(size_t fp)`: its arguments are
+  // the top values of stack[], starting at fp, and it returns the new stack
+  // top after moving its results down to stack[fp]. OP_CALL is a direct C
+  // call; OP_CALL_DYN_BOT asks fn_at(), a switch over the entry addresses
+  // of the functions used as values, for the function. Split across units,
+  // they lose static.
+  const char *link = split ? "" : "static ";
+  for (int k = 0; k < fn_count; k++) {
+    if (!fn_live[k])
+      continue;
+    fprintf(hdr, "%ssize_t ", link);
+    fn_name(hdr, k);
+    fprintf(hdr, "(size_t fp);\n");
+  }
+  if (has_dyn_call) {
+    fprintf(hdr, "typedef size_t (*AbyssFn)(size_t fp);\n");
+    char sig[64];
+    snprintf(sig, sizeof(sig), "%sAbyssFn fn_at(int64_t addr)", link);
+    rt_fn(f, sig);
+    fprintf(f, "  switch (addr) {\n");
+    for (int k = 0; k < fn_count; k++) {
+      if (!fn_ref[k])
+        continue;
+      fprintf(f, "  case %u: return ", fn_info[k]->addr);
+      fn_name(f, k);
+      fprintf(f, ";\n");
     }
-    case OP_FREE:
-      fprintf(
-          f, "  { void *p = stack[--sp].p; untrack_alloc(p, %zu); free(p); }\n",
-          ip);
-      break;
-
-    case OP_GET_FIELD:
-      fprintf(f, "  { int64_t *p = stack[sp-1].p; stack[sp-1].i = p[%u]; }\n",
-              code[ip++]);
-      break;
-    case OP_SET_FIELD:
-      fprintf(f,
-              "  { int64_t v = stack[--sp].i; int64_t *p = stack[--sp].p; "
-              "p[%u] = v; }\n",
-              code[ip++]);
-      break;
-    case OP_GET_INDEX:
-      fprintf(f, "  { int64_t i = stack[--sp].i; int64_t *p = stack[--sp].p; "
-                 "stack[sp++].i = p[i]; }\n");
-      break;
-    case OP_SET_INDEX:
-      fprintf(f, "  { int64_t v = stack[--sp].i; int64_t i = stack[--sp].i; "
-                 "int64_t *p = stack[--sp].p; p[i] = v; }\n");
-      break;
-    case OP_INC_INDEX:
-      fprintf(f, "  { int64_t i = stack[--sp].i; int64_t *p = stack[--sp].p; "
-                 "p[i]++; }\n");
-      break;
-    case OP_DEC_INDEX:
-      fprintf(f, "  { int64_t i = stack[--sp].i; int64_t *p = stack[--sp].p; "
-                 "p[i]--; }\n");
-      break;
-
-    case OP_STR_CAT:
-      fprintf(
-          f,
-          "  { char *s2 = stack[--sp].p; char *s1 = stack[--sp].p; size_t l1 = "
-          "strlen(s1), l2 = strlen(s2); char *n = malloc(l1+l2+1); strcpy(n, "
-          "s1); strcat(n, s2); track_alloc(n, 0xFFFFFFFE, l1+l2+1, 0, "
-          "\"Dynamic String\", %zu, fp); stack[sp++].p = n; }\n",
-          ip);
-      break;
-
-    case OP_I2F:
-      // Value conversion int -> float. No memcpy; union write is typed.
-      fprintf(f, "  stack[sp-1].f = (double)stack[sp-1].i;\n");
-      break;
-    case OP_F2I:
-      fprintf(f, "  stack[sp-1].i = (int64_t)stack[sp-1].f;\n");
-      break;
-    case OP_INT_TO_STR:
-      fprintf(f,
-              "  { int64_t v = stack[--sp].i; char buf[32]; "
-              "int n = snprintf(buf, sizeof(buf), \"%%ld\", (long)v); "
-              "char *s = malloc(n+1); memcpy(s, buf, n+1); "
-              "track_alloc(s, 0xFFFFFFFE, n+1, 0, \"int->str\", %zu, fp); "
-              "stack[sp++].p = s; }\n",
-              ip);
-      break;
-    case OP_FLOAT_TO_STR:
-      fprintf(f,
-              "  { double v = stack[--sp].f; char buf[64]; "
-              "int n = snprintf(buf, sizeof(buf), \"%%.6f\", v); "
-              "char *s = malloc(n+1); memcpy(s, buf, n+1); "
-              "track_alloc(s, 0xFFFFFFFE, n+1, 0, \"float->str\", %zu, fp); "
-              "stack[sp++].p = s; }\n",
-              ip);
-      break;
-    case OP_SWAP:
-      fprintf(f, "  { Value tmp = stack[sp-1]; stack[sp-1] = stack[sp-2]; "
-                 "stack[sp-2] = tmp; }\n");
-      break;
+    fprintf(f, "  }\n  fprintf(stderr, \"\\033[1;31m[FATAL ERROR]\\033[0m "
+               "call to %%ld, which is no function.\\n\", (long)addr); "
+               "exit(1);\n}\n");
+  }
+  fprintf(f, "\n");
 
-    case OP_ABYSS_EYE:
-      fprintf(f, "  abyss_eye();\n");
-      break;
+  // --- 5. BYTECODE TRANSLATION ---
+  fprintf(f, "int main() {\n");
+  fprintf(f, "  out_tty = isatty(STDOUT_FILENO); atexit(out_flush);\n");
+  fprintf(f, "  size_t sp = 0, fp = 0;\n");
+  emit_region(f, TOP_LEVEL, 0, code_sz, enable_profiler);
+  fprintf(f, "cleanup:\n  return 0;\n}\n\n");
 
-    case OP_TRY: {
-      uint32_t catch_addr;
-      memcpy(&catch_addr, code + ip, 4);
-      ip += 4;
-      fprintf(f,
-              "  exception_stack[esp++] = (ExceptionFrame){%u, sp, fp, csp};\n",
-              catch_addr);
-      break;
-    }
-    case OP_END_TRY:
-      fprintf(f, "  if (esp > 0) esp--;\n");
-      break;
-    case OP_THROW:
-      fprintf(
-          f, "  { Value err_val = stack[--sp]; if (esp == 0) { fprintf(stderr, "
-             "\"Uncaught Exception: %%s\\n\", (char *)err_val.p); exit(1); } "
-             "esp--; size_t ca = exception_stack[esp].catch_addr; sp = "
-             "exception_stack[esp].old_sp; fp = exception_stack[esp].old_fp; "
-             "csp = exception_stack[esp].old_csp; stack[sp++] = err_val; goto "
-             "*jump_table[ca]; }\n");
-      break;
+  // Split, the live functions fill the function units in address order, so a
+  // module's functions mostly share a unit, each unit holding about the
+  // same amount of bytecode.
+  size_t total = live_bytes(), done = 0;
+  int unit = 0, group = -1;
+  FILE *out = f;
 
-    case OP_NATIVE: {
-      uint32_t nid;
-      memcpy(&nid, code + ip, 4);
-      ip += 4;
-      if (nid == 0)
-        fprintf(
-            f,
-            "  { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); "
-            "double t = ts.tv_sec + ts.tv_nsec / 1e9; stack[sp++].f = t; }\n");
-      else if (nid == 1)
-        fprintf(f, "  { char buf[64]; int64_t v=0; if(fgets(buf, sizeof(buf), "
-                   "stdin)) v = atoll(buf); stack[sp++].i = v; }\n");
-      break;
+  is_leader = calloc(code_sz + 1, 1);
+  entry_type = calloc(code_sz + 1, sizeof(uint8_t *));
+  entry_depth = calloc(code_sz + 1, sizeof(int));
+  for (int k = 0; k < fn_count; k++) {
+    size_t from = fn_info[k]->addr, to = fn_end(k);
+    if (!fn_live[k])
+      continue;
+    // A function bigger than a unit's share skips groups; units stay
+    // numbered without gaps.
+    if (split && (int)(done * shards / total) != group) {
+      if (out != f)
+        fclose(out);
+      group = (int)(done * shards / total);
+      out = open_unit(stem, ++unit, ".c");
     }
-    case OP_TAG_ALLOC: {
-      uint32_t sidx;
-      memcpy(&sidx, code + ip, 4);
-      ip += 4;
-      if (enable_profiler) {
-        fprintf(
-            f,
-            "  { void *p = stack[sp-1].p; "
-            "uint32_t idx = ((uintptr_t)p >> 4) & 0xFFFF; "
-            "AllocInfo *c = alloc_table[idx]; "
-            "while(c) { if(c->ptr == p && !c->is_freed) { c->tag = strs[%u]; "
-            "break; } c = c->next; } }\n",
-            sidx);
-      }
-      // When profiling is off: emit nothing (zero overhead)
-      break;
-    }
-    default:
-      fprintf(stderr, "FATAL: Unimplemented opcode %d in native transpiler!\n",
-              op);
-      exit(1);
+    done += to - from;
+    fprintf(out, "%ssize_t ", link);
+    fn_name(out, k);
+    fprintf(out, "(size_t fp) {\n");
+    if (!fn_try[k] && slot_analyze(k, from, to)) {
+      emit_slot_function(out, k, from, to, enable_profiler);
+    } else {
+      fprintf(out, "  size_t sp = fp + %d;%s\n"
+                   "  call_stack[csp++].arena_mark = arena_top;\n",
+              fn_info[k]->arg_count,
+              fn_try[k] ? " size_t entry_esp = esp;" : "");
+      emit_region(out, k, from, to, enable_profiler);
     }
+    slot_reset(from, to);
+    fprintf(out, "}\n\n");
   }
+  if (out != f)
+    fclose(out);
+  if (split)
+    fclose(hdr);
 
-  fprintf(f, "cleanup:\n  return 0;\n}\n");
+  free(owner);
+  free(fn_info);
+  free(fn_try);
+  free(is_target);
+  free(fn_live);
+  free(fn_ref);
+  free(is_leader);
+  free(entry_type);
+  free(entry_depth);
   fclose(f);
+
+  // .c files in unit order, then the header. Split, the header was opened
+  // first and <stem>.c second; the function units follow in order.
+  if (split) {
+    NativeFile h = out_files[0];
+    memmove(out_files, out_files + 1, (out_count - 1) * sizeof(NativeFile));
+    out_files[out_count - 1] = h;
+  }
+  write_units();
+  *files = out_files;
+  return unit + 1;
 }
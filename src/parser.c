@@ -49,6 +49,8 @@ static const char *type_name(DataType t, int sid, int ad) {
     return "struct";
   case TYPE_ARRAY:
     return "array";
+  case TYPE_STRBUF:
+    return "strbuf";
   }
   return "unknown";
 }
@@ -61,7 +63,8 @@ static void check_assign_compat(DataType dst, int dst_sid, int dst_ad,
                                 const char *context) {
   // Null (encoded as int 0) is assignable to any pointer-like type.
   if (src == TYPE_INT && (dst == TYPE_STR || dst == TYPE_STRUCT ||
-                          dst == TYPE_ARRAY || dst_ad > 0))
+                          dst == TYPE_ARRAY || dst == TYPE_STRBUF ||
+                          dst_ad > 0))
     return; // allow null to pointer
 
   // Exact match
@@ -140,6 +143,8 @@ static void skip_brace_block(void);
 // --- LOOP CONTEXT ---
 typedef struct Loop {
   size_t continue_addr;
+  int local_base; // local_count when the loop body starts
+  int arena_base; // arena_depth when the loop body starts
   size_t *break_patches;
   int break_count;
   int break_cap;
@@ -148,9 +153,21 @@ typedef struct Loop {
 
 Loop *current_loop = NULL;
 
+// arena { } blocks open around the statement being compiled. The runtime
+// keeps its own stack of open blocks, so every exit that skips a block's
+// closing brace (return, break, continue) closes it explicitly.
+static int arena_depth = 0;
+
+static void close_arenas(int base) {
+  for (int i = base; i < arena_depth; i++)
+    emit(OP_ARENA_END);
+}
+
 void enter_loop(size_t continue_addr) {
   Loop *l = malloc(sizeof(Loop));
   l->continue_addr = continue_addr;
+  l->local_base = local_count;
+  l->arena_base = arena_depth;
   l->break_patches = NULL;
   l->break_count = 0;
   l->break_cap = 0;
@@ -158,9 +175,75 @@ void enter_loop(size_t continue_addr) {
   current_loop = l;
 }
 
+// Locals declared inside the loop body live on the value stack. A jump out of
+// (or back to the top of) the body must drop them, exactly like falling off
+// the end of their block would, or the stack depth at the jump target is off.
+static void pop_loop_locals(void) {
+  for (int i = current_loop->local_base; i < local_count; i++)
+    emit(OP_POP);
+}
+
+// A native called as a statement. Natives leave their arguments on the stack,
+// and clock/input_int also push a result; drop all of it so a call inside a
+// loop does not grow the stack on every iteration.
+static void emit_native_stmt(int nid, int args) {
+  emit(OP_NATIVE);
+  emit32(nid);
+  for (int i = 0; i < args + (nid <= 1); i++)
+    emit(OP_POP);
+}
+
+static void strbuf_operand(const char *name) {
+  int d1, d2;
+  if (expression(&d1, &d2) != TYPE_STRBUF)
+    fail("%s expects a strbuf as its first argument", name);
+}
+
+// strbuf_new(), strbuf_append(b, x), strbuf_reset(b) and strbuf_str(b),
+// called with cur just past the '('. Returns 0 if name is none of them;
+// otherwise parses the rest of the call through ')' and sets *ret.
+static int strbuf_builtin(const char *name, DataType *ret) {
+  if (!strcmp(name, "strbuf_new")) {
+    expect(TK_RPAREN);
+    emit(OP_STRBUF_NEW);
+    *ret = TYPE_STRBUF;
+  } else if (!strcmp(name, "strbuf_append")) {
+    strbuf_operand(name);
+    expect(TK_COMMA);
+    int sid, ad;
+    DataType t = expression(&sid, &ad);
+    int kind = t == TYPE_STR     ? CAT_STR
+               : t == TYPE_INT   ? CAT_INT
+               : t == TYPE_FLOAT ? CAT_FLOAT
+               : t == TYPE_CHAR  ? CAT_CHAR
+                                 : -1;
+    if (kind < 0)
+      fail("strbuf_append cannot append %s", type_name(t, sid, ad));
+    expect(TK_RPAREN);
+    emit(OP_STRBUF_APPEND);
+    emit(kind);
+    *ret = TYPE_VOID;
+  } else if (!strcmp(name, "strbuf_reset")) {
+    strbuf_operand(name);
+    expect(TK_RPAREN);
+    emit(OP_STRBUF_RESET);
+    *ret = TYPE_VOID;
+  } else if (!strcmp(name, "strbuf_str")) {
+    strbuf_operand(name);
+    expect(TK_RPAREN);
+    emit(OP_STRBUF_STR);
+    *ret = TYPE_STR;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
 void add_break() {
   if (!current_loop)
     fail("break outside of loop");
+  pop_loop_locals();
+  close_arenas(current_loop->arena_base);
   emit(OP_JMP);
   if (current_loop->break_count >= current_loop->break_cap) {
     current_loop->break_cap =
@@ -175,6 +258,8 @@ void add_break() {
 void add_continue() {
   if (!current_loop)
     fail("continue outside of loop");
+  pop_loop_locals();
+  close_arenas(current_loop->arena_base);
   emit(OP_JMP);
   emit32(current_loop->continue_addr);
 }
@@ -200,6 +285,8 @@ void parse_type(DataType *type, int *struct_id, int *array_depth) {
     *type = TYPE_CHAR;
   else if (accept(TK_STR_TYPE))
     *type = TYPE_STR;
+  else if (accept(TK_STRBUF_TYPE))
+    *type = TYPE_STRBUF;
   else if (accept(TK_VOID))
     *type = TYPE_VOID;
   else if (cur.kind == TK_ID) {
@@ -386,6 +473,12 @@ DataType factor(int *struct_id, int *array_depth) {
     if (accept(TK_LPAREN)) {
       int nid = -1;
       DataType ret = TYPE_VOID;
+      if (strbuf_builtin(name, &ret)) {
+        free(name);
+        *struct_id = -1;
+        *array_depth = 0;
+        return ret;
+      }
       if (!strcmp(name, "clock")) {
         nid = 0;
         ret = TYPE_FLOAT;
@@ -467,8 +560,7 @@ DataType factor(int *struct_id, int *array_depth) {
     if (lid == -1 && gid == -1) {
       int fid = find_func(name);
       if (fid != -1) {
-        emit(OP_CONST_INT);
-        emit32(funcs[fid].addr);
+        emit_func_ref(fid);
         free(name);
         *struct_id = -1;
         *array_depth = 0;
@@ -535,8 +627,8 @@ DataType factor(int *struct_id, int *array_depth) {
             fail("Interface method arg count mismatch");
 
           check_args(args, structs[parent_sid].fields[field_idx].name);
-          emit(OP_CALL_DYN_BOT);
-          emit(args);
+          emit_dyn_call(args,
+                        structs[parent_sid].fields[field_idx].ret_count);
 
           *struct_id = structs[parent_sid].fields[field_idx].ret_sids[0];
           *array_depth = structs[parent_sid].fields[field_idx].ret_ads[0];
@@ -825,39 +917,58 @@ DataType term(int *struct_id, int *array_depth) {
   return t;
 }
 
+// Parts of the str `+` chain add_expr is building, not yet emitted as an
+// OP_STR_CAT_N.
+typedef struct {
+  int n;
+  uint32_t kinds;
+} CatChain;
+
+// Adds the part just pushed. A full op is emitted right away, before the
+// next part is pushed; its result is the first part of the one after.
+static void cat_part(CatChain *c, DataType t) {
+  int kind = t == TYPE_STR ? CAT_STR : t == TYPE_INT ? CAT_INT : CAT_FLOAT;
+  c->kinds |= (uint32_t)kind << (2 * c->n++);
+  if (c->n == CAT_MAX) {
+    emit(OP_STR_CAT_N);
+    emit(CAT_MAX);
+    emit32(c->kinds);
+    c->n = 1;
+    c->kinds = CAT_STR;
+  }
+}
+
+static void cat_flush(CatChain *c) {
+  if (c->n > 1) {
+    emit(OP_STR_CAT_N);
+    emit(c->n);
+    emit32(c->kinds);
+  }
+  c->n = 0;
+  c->kinds = 0;
+}
+
 DataType add_expr(int *struct_id, int *array_depth) {
   DataType t = term(struct_id, array_depth);
+  CatChain chain = {0, 0};
   while (cur.kind == TK_PLUS || cur.kind == TK_MINUS) {
     int op = cur.kind;
     next();
+    if (op != TK_PLUS)
+      cat_flush(&chain);
     int d1, d2;
     DataType t2 = term(&d1, &d2);
 
     // --- Dynamic string concatenation with auto-conversion of numeric side ---
+    // The whole chain becomes one OP_STR_CAT_N, so `"a" + x + "b"` allocates
+    // once and formats x straight into the result.
     if (op == TK_PLUS && (t == TYPE_STR || t2 == TYPE_STR)) {
-      if (t == TYPE_STR && t2 == TYPE_STR) {
-        emit(OP_STR_CAT);
-      } else if (t == TYPE_STR && t2 == TYPE_INT) {
-        emit(OP_INT_TO_STR);
-        emit(OP_STR_CAT);
-      } else if (t == TYPE_STR && t2 == TYPE_FLOAT) {
-        emit(OP_FLOAT_TO_STR);
-        emit(OP_STR_CAT);
-      } else if (t == TYPE_INT && t2 == TYPE_STR) {
-        // LHS int is under the str. Swap, convert LHS to str, swap back, then
-        // cat.
-        emit(OP_SWAP);
-        emit(OP_INT_TO_STR);
-        emit(OP_SWAP);
-        emit(OP_STR_CAT);
-      } else if (t == TYPE_FLOAT && t2 == TYPE_STR) {
-        emit(OP_SWAP);
-        emit(OP_FLOAT_TO_STR);
-        emit(OP_SWAP);
-        emit(OP_STR_CAT);
-      } else {
+      DataType other = t == TYPE_STR ? t2 : t;
+      if (other != TYPE_STR && other != TYPE_INT && other != TYPE_FLOAT)
         fail("Cannot concatenate str with this type");
-      }
+      if (chain.n == 0)
+        cat_part(&chain, t);
+      cat_part(&chain, t2);
       t = TYPE_STR;
     } else if (t == TYPE_FLOAT || t2 == TYPE_FLOAT) {
       // Int-to-float promotion for mixed arithmetic.
@@ -873,6 +984,7 @@ DataType add_expr(int *struct_id, int *array_depth) {
     } else
       emit(op == TK_PLUS ? OP_ADD : OP_SUB);
   }
+  cat_flush(&chain);
   return t;
 }
 
@@ -1073,6 +1185,22 @@ void statement() {
     local_count = saved_locals;
     return;
   }
+  if (accept(TK_ARENA)) {
+    expect(TK_LBRACE);
+    emit(OP_ARENA_BEGIN);
+    arena_depth++;
+    int saved_locals = local_count;
+    while (cur.kind != TK_RBRACE)
+      statement();
+    expect(TK_RBRACE);
+    int diff = local_count - saved_locals;
+    for (int i = 0; i < diff; i++)
+      emit(OP_POP);
+    local_count = saved_locals;
+    arena_depth--;
+    emit(OP_ARENA_END);
+    return;
+  }
   if (accept(TK_BREAK)) {
     add_break();
     expect(TK_SEMI);
@@ -1136,10 +1264,17 @@ void statement() {
   if (accept(TK_PRINT)) {
     expect(TK_LPAREN);
     int d1, d2;
+    size_t fmt_at = code_sz;
     DataType t = expression(&d1, &d2);
     if (cur.kind == TK_COMMA) {
       if (t != TYPE_STR)
         fail("First arg of formatted print must be string");
+      // A literal format is split at compile time instead of being pushed.
+      int fmt_id = -1;
+      if (code_sz == fmt_at + 5 && code[fmt_at] == OP_CONST_STR) {
+        memcpy(&fmt_id, code + fmt_at + 1, 4);
+        code_sz = fmt_at;
+      }
       int arg_count = 0;
       while (accept(TK_COMMA)) {
         expression(&d1, &d2);
@@ -1147,7 +1282,11 @@ void statement() {
       }
       expect(TK_RPAREN);
       expect(TK_SEMI);
-      emit(OP_PRINT_FMT);
+      if (fmt_id >= 0) {
+        emit(OP_PRINT_FMT_SEG);
+        emit32(add_format(strs[fmt_id], arg_count));
+      } else
+        emit(OP_PRINT_FMT);
       emit(arg_count);
       return;
     }
@@ -1177,19 +1316,29 @@ void statement() {
   if (accept(TK_FREE)) {
     expect(TK_LPAREN);
     int d1, d2;
-    expression(&d1, &d2);
+    DataType t = expression(&d1, &d2);
     expect(TK_RPAREN);
     expect(TK_SEMI);
-    emit(OP_FREE);
+    // A str points past its length header and a strbuf owns its chars, so
+    // both need their own opcode.
+    if (t == TYPE_STR && d2 == 0)
+      emit(OP_FREE_STR);
+    else if (t == TYPE_STRBUF && d2 == 0)
+      emit(OP_STRBUF_FREE);
+    else
+      emit(OP_FREE);
     return;
   }
   if (accept(TK_RETURN)) {
     if (cur.kind == TK_SEMI) {
       expect(TK_SEMI);
+      // Same shape as the implicit return at the end of a void function:
+      // one dummy value, so callers that pop ret_count values stay balanced.
       emit(OP_CONST_INT);
       emit32(0);
+      close_arenas(0);
       emit(OP_RET);
-      emit(0);
+      emit(1);
       return;
     }
     int count = 0;
@@ -1200,6 +1349,7 @@ void statement() {
     } while (accept(TK_COMMA));
     expect(TK_SEMI);
     check_ret_count(count);
+    close_arenas(0);
     emit(OP_RET);
     emit(count);
     return;
@@ -1369,7 +1519,8 @@ void statement() {
     return;
   }
   if (cur.kind == TK_INT || cur.kind == TK_FLOAT || cur.kind == TK_CHAR ||
-      cur.kind == TK_STR_TYPE || cur.kind == TK_ID) {
+      cur.kind == TK_STR_TYPE || cur.kind == TK_STRBUF_TYPE ||
+      cur.kind == TK_ID) {
     int sid = -1;
     int ad = 0;
     DataType type = TYPE_VOID;
@@ -1490,8 +1641,7 @@ void statement() {
                "count");
         check_args(args, method_name);
 
-        emit(OP_CALL_DYN_BOT);
-        emit(args);
+        emit_dyn_call(args, structs[osid].fields[field_idx].ret_count);
 
         for (int i = count - 1; i >= 0; i--) {
           int vlid = find_local(names[i]);
@@ -1560,6 +1710,14 @@ void statement() {
     }
     // Function call as statement
     if (accept(TK_LPAREN)) {
+      DataType sb_ret;
+      if (strbuf_builtin(name, &sb_ret)) {
+        expect(TK_SEMI);
+        if (sb_ret != TYPE_VOID)
+          emit(OP_POP);
+        free(name);
+        return;
+      }
       // --- NATIVE/BRIDGE CALLS AS STATEMENTS ---
       int nid = -1;
       if (!strcmp(name, "clock"))
@@ -1578,16 +1736,17 @@ void statement() {
         nid = 21;
 
       if (nid != -1) {
+        int args = 0;
         if (cur.kind != TK_RPAREN) {
           do {
             int d1, d2;
             expression(&d1, &d2);
+            args++;
           } while (accept(TK_COMMA));
         }
         expect(TK_RPAREN);
         expect(TK_SEMI);
-        emit(OP_NATIVE);
-        emit32(nid);
+        emit_native_stmt(nid, args);
         free(name);
         return;
       }
@@ -1656,16 +1815,17 @@ void statement() {
           nid = 12;
 
         if (nid != -1) {
+          int args = 0;
           if (cur.kind != TK_RPAREN) {
             do {
               int d1, d2;
               expression(&d1, &d2);
+              args++;
             } while (accept(TK_COMMA));
           }
           expect(TK_RPAREN);
           expect(TK_SEMI);
-          emit(OP_NATIVE);
-          emit32(nid);
+          emit_native_stmt(nid, args);
           free(name);
           return;
         }
@@ -1922,8 +2082,8 @@ void statement() {
             fail("Interface method arg count mismatch");
 
           check_args(args, structs[parent_sid].fields[field_idx].name);
-          emit(OP_CALL_DYN_BOT);
-          emit(args);
+          emit_dyn_call(args,
+                        structs[parent_sid].fields[field_idx].ret_count);
 
           for (int i = 0; i < structs[parent_sid].fields[field_idx].ret_count;
                i++)
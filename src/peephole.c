@@ -0,0 +1,270 @@
+#include "../include/peephole.h"
+#include "../include/codegen.h"
+#include "../include/common.h"
+#include "../include/symbols.h"
+#include "../include/utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The pass works on the finished program in three steps:
+//   1. Mark every instruction that control can reach other than by falling
+//      through (jump/try targets, call targets, function entries, function
+//      references). A fused sequence may START at such a leader but must not
+//      contain one past its first instruction.
+//   2. Copy instructions into a fresh buffer, replacing matched sequences,
+//      and record old offset -> new offset for every instruction start.
+//   3. Rewrite every code-address operand through that map.
+
+#define NO_ADDR 0xFFFFFFFFu
+
+static uint8_t *out = NULL;
+static size_t out_sz = 0;
+static size_t out_cap = 0;
+
+// New-buffer positions of 32-bit operands that still hold an OLD address.
+static size_t *fixups = NULL;
+static int fixup_count = 0;
+static int fixup_cap = 0;
+
+static void out_byte(uint8_t b) {
+  if (out_sz >= out_cap) {
+    out_cap = out_cap ? out_cap * 2 : 1024;
+    out = realloc(out, out_cap);
+    if (!out)
+      fail("Out of memory (peephole)");
+  }
+  out[out_sz++] = b;
+}
+
+static void out_bytes(const uint8_t *p, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    out_byte(p[i]);
+}
+
+static void add_fixup(size_t pos) {
+  if (fixup_count >= fixup_cap) {
+    fixup_cap = fixup_cap ? fixup_cap * 2 : 256;
+    fixups = realloc(fixups, fixup_cap * sizeof(size_t));
+    if (!fixups)
+      fail("Out of memory (peephole fixups)");
+  }
+  fixups[fixup_count++] = pos;
+}
+
+// Copies a 32-bit code address operand and queues it for remapping.
+static void out_addr(const uint8_t *p) {
+  add_fixup(out_sz);
+  out_bytes(p, 4);
+}
+
+static uint32_t read32(size_t at) {
+  uint32_t v;
+  memcpy(&v, code + at, 4);
+  return v;
+}
+
+static void mark(uint8_t *leader, uint32_t addr) {
+  if (addr < code_sz)
+    leader[addr] = 1;
+}
+
+static int has_code_operand(uint8_t op) {
+  return op == OP_JMP || op == OP_JZ || op == OP_TRY || op == OP_CALL;
+}
+
+// Maps an int compare opcode to the first opcode of a fused family, or -1.
+static int cmp_index(uint8_t op) {
+  switch (op) {
+  case OP_LT:
+    return 0;
+  case OP_LE:
+    return 1;
+  case OP_GT:
+    return 2;
+  case OP_GE:
+    return 3;
+  case OP_EQ:
+    return 4;
+  case OP_NE:
+    return 5;
+  default:
+    return -1;
+  }
+}
+
+size_t peephole_optimize(void) {
+  // --- 1. Instruction starts and leaders ---
+  uint8_t *is_start = calloc(code_sz + 1, 1);
+  uint8_t *leader = calloc(code_sz + 1, 1);
+  uint8_t *is_ref = calloc(code_sz + 1, 1);
+  if (!is_start || !leader || !is_ref)
+    fail("Out of memory (peephole)");
+
+  for (int i = 0; i < func_ref_count; i++)
+    is_ref[func_refs[i]] = 1;
+  for (int i = 0; i < func_count; i++)
+    mark(leader, funcs[i].addr);
+
+  for (size_t ip = 0; ip < code_sz;) {
+    is_start[ip] = 1;
+    uint8_t op = code[ip];
+    if (has_code_operand(op))
+      mark(leader, read32(ip + 1));
+    else if (op == OP_CONST_INT && is_ref[ip + 1])
+      mark(leader, read32(ip + 1));
+    ip += 1 + op_operand_size(op);
+  }
+
+  // Instruction i is fusable into a sequence starting before it only if it
+  // exists and nothing jumps to it.
+#define INNER(at) ((at) < code_sz && is_start[(at)] && !leader[(at)])
+
+  // --- 2. Rewrite ---
+  uint32_t *map = malloc((code_sz + 1) * sizeof(uint32_t));
+  size_t *new_refs = malloc((func_ref_count + 1) * sizeof(size_t));
+  if (!map || !new_refs)
+    fail("Out of memory (peephole)");
+  // Instructions inside a fused sequence keep NO_ADDR.
+  memset(map, 0xFF, (code_sz + 1) * sizeof(uint32_t));
+  int new_ref_count = 0;
+  out_sz = 0;
+  fixup_count = 0;
+  size_t fused = 0;
+
+  size_t ip = 0;
+  while (ip < code_sz) {
+    map[ip] = (uint32_t)out_sz;
+    uint8_t op = code[ip];
+
+    if (op == OP_GET_LOCAL) {
+      size_t i1 = ip + 2;
+      uint8_t a = code[ip + 1];
+
+      // GET_LOCAL a; CONST_INT k; <cmp>; JZ t
+      if (INNER(i1) && code[i1] == OP_CONST_INT && !is_ref[i1 + 1] &&
+          INNER(i1 + 5) && cmp_index(code[i1 + 5]) >= 0 && INNER(i1 + 6) &&
+          code[i1 + 6] == OP_JZ) {
+        out_byte(OP_LOCAL_CONST_LT_JZ + cmp_index(code[i1 + 5]));
+        out_byte(a);
+        out_bytes(code + i1 + 1, 4);
+        out_addr(code + i1 + 7);
+        ip = i1 + 11;
+        fused++;
+        continue;
+      }
+
+      // GET_LOCAL a; GET_LOCAL b; <cmp>; JZ t
+      if (INNER(i1) && code[i1] == OP_GET_LOCAL && INNER(i1 + 2) &&
+          cmp_index(code[i1 + 2]) >= 0 && INNER(i1 + 3) &&
+          code[i1 + 3] == OP_JZ) {
+        out_byte(OP_LOCAL_LOCAL_LT_JZ + cmp_index(code[i1 + 2]));
+        out_byte(a);
+        out_byte(code[i1 + 1]);
+        out_addr(code + i1 + 4);
+        ip = i1 + 8;
+        fused++;
+        continue;
+      }
+
+      // GET_LOCAL a; CONST_INT k; ADD|SUB; SET_LOCAL a
+      if (INNER(i1) && code[i1] == OP_CONST_INT && !is_ref[i1 + 1] &&
+          INNER(i1 + 5) && (code[i1 + 5] == OP_ADD || code[i1 + 5] == OP_SUB) &&
+          INNER(i1 + 6) && code[i1 + 6] == OP_SET_LOCAL &&
+          code[i1 + 7] == a) {
+        int32_t k;
+        memcpy(&k, code + i1 + 1, 4);
+        if (code[i1 + 5] == OP_ADD || k != INT32_MIN) {
+          if (code[i1 + 5] == OP_SUB)
+            k = -k;
+          out_byte(OP_INC_LOCAL);
+          out_byte(a);
+          out_bytes((uint8_t *)&k, 4);
+          ip = i1 + 8;
+          fused++;
+          continue;
+        }
+      }
+
+      // GET_LOCAL a; GET_FIELD f
+      if (INNER(i1) && code[i1] == OP_GET_FIELD) {
+        out_byte(OP_GET_LOCAL_FIELD);
+        out_byte(a);
+        out_byte(code[i1 + 1]);
+        ip = i1 + 2;
+        fused++;
+        continue;
+      }
+
+      // GET_LOCAL a; GET_LOCAL b (unless b is about to fuse with a field
+      // load of its own)
+      if (INNER(i1) && code[i1] == OP_GET_LOCAL &&
+          !(INNER(i1 + 2) && code[i1 + 2] == OP_GET_FIELD)) {
+        out_byte(OP_GET_LOCAL2);
+        out_byte(a);
+        out_byte(code[i1 + 1]);
+        ip = i1 + 2;
+        fused++;
+        continue;
+      }
+    }
+
+    // <cmp>; JZ t
+    if (cmp_index(op) >= 0 && INNER(ip + 1) && code[ip + 1] == OP_JZ) {
+      out_byte(OP_LT_JZ + cmp_index(op));
+      out_addr(code + ip + 2);
+      ip += 6;
+      fused++;
+      continue;
+    }
+
+    // No pattern: copy the instruction as-is.
+    size_t len = 1 + op_operand_size(op);
+    out_byte(op);
+    if (has_code_operand(op)) {
+      out_addr(code + ip + 1);
+      out_bytes(code + ip + 5, len - 5);
+    } else {
+      if (op == OP_CONST_INT && is_ref[ip + 1]) {
+        new_refs[new_ref_count++] = out_sz;
+        add_fixup(out_sz);
+      }
+      out_bytes(code + ip + 1, len - 1);
+    }
+    ip += len;
+  }
+  map[code_sz] = (uint32_t)out_sz;
+#undef INNER
+
+  // --- 3. Remap code addresses ---
+  for (int i = 0; i < fixup_count; i++) {
+    uint32_t old;
+    memcpy(&old, out + fixups[i], 4);
+    if (old == NO_ADDR)
+      continue;
+    if (old > code_sz || !(old == code_sz || is_start[old]))
+      fail("Internal: peephole found a jump into the middle of an "
+           "instruction (target %u)",
+           old);
+    memcpy(out + fixups[i], &map[old], 4);
+  }
+  for (int i = 0; i < func_count; i++)
+    if (funcs[i].addr != NO_ADDR && funcs[i].addr <= code_sz)
+      funcs[i].addr = map[funcs[i].addr];
+  if (new_ref_count) // func_refs is NULL in a program without references
+    memcpy(func_refs, new_refs, new_ref_count * sizeof(size_t));
+  func_ref_count = new_ref_count;
+  codegen_remap_lines(map, code_sz);
+
+  // Swap the optimized program in.
+  codegen_replace(out, out_sz, out_cap);
+  out = NULL;
+  out_sz = out_cap = 0;
+
+  free(is_start);
+  free(leader);
+  free(is_ref);
+  free(map);
+  free(new_refs);
+  return fused;
+}
@@ -21,4 +21,6 @@ void main() {
     int answer = 42;
     print("The answer is %int", answer);
     print("Name: %str, Value: %int", b, answer);
+    print("Braced: %{int}, %{str}!", answer, b);
+    print("Ends in %{int}", answer);
 }
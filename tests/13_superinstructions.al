@@ -0,0 +1,35 @@
+// Loop shapes the peephole pass fuses into superinstructions:
+// compare-and-branch on locals/constants, local increments, field loads.
+struct Acc {
+    int total;
+    int steps;
+}
+
+void main() {
+    Acc a = new(Acc);
+    int limit = 10;
+
+    for (int i = 0; i < limit; i++) { a.total += i; }
+    print(a.total);
+
+    int j = 20;
+    while (j >= 0) { j -= 3; }
+    print(j);
+
+    int k = 0;
+    while (k != 7) { k++; a.steps += 1; }
+    print(a.steps);
+
+    int n = -5;
+    while (n <= -1) { n = n + 2; }
+    print(n);
+
+    int hits = 0;
+    for (int x = 0; x < 30; x++) {
+        if (x % 5 == 0) { continue; }
+        if (x > 25) { break; }
+        hits++;
+    }
+    print(hits);
+    free(a);
+}
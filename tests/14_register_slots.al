@@ -0,0 +1,36 @@
+// Shapes the register backend (abyssc --register) has to get right: locals
+// that alias other locals until one is reassigned, self-assignment, swaps
+// through a temporary, break/continue out of blocks with locals, and calls
+// that reuse the caller's frame slots for their arguments.
+int mix(int a, int b) {
+    int t = a;
+    a = b;
+    b = t;
+    return a * 10 + b;
+}
+
+void main() {
+    int a = 5;
+    int b = a;
+    a = 7;
+    print(b);
+    print(a);
+
+    a = a;
+    print(mix(a, b));
+
+    int s = 0;
+    for (int i = 0; i < 10; i++) {
+        int d = i * 2;
+        if (d == 4) { continue; }
+        if (d > 14) { break; }
+        s += d - 1;
+    }
+    print(s);
+
+    int x = 3;
+    int y = x + 0;
+    x += 100;
+    print(y);
+    print(x);
+}
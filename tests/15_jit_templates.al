@@ -0,0 +1,70 @@
+// One of everything abyss_vm --jit compiles to machine code: signed
+// division and shifts, logical and float compares, int-to-float promotion,
+// globals, fields, array element updates, and a loop the JIT leaves through
+// a call and a throw caught by the interpreter.
+int total = 0;
+
+struct P {
+    int x;
+    float f;
+}
+
+int bump(int v) {
+    total += v;
+    return total;
+}
+
+void main() {
+    int a = -17;
+    int b = 5;
+    print(a / b);
+    print(a % b);
+    print(a >> 2);
+    print(a << 3);
+    print((a < b) && (b > 0));
+    print((a > b) || (b == 5));
+    print(!b);
+
+    float x = -2.5;
+    float y = 0.5;
+    print(x * y - y / x);
+    print(x < y);
+    print(x >= y);
+    print(x == -2.5);
+    print(x != y);
+    print(-x);
+    print(a + 0.25);
+    print(0.5 * b);
+
+    P p = new(P);
+    p.x = 40;
+    p.f = 1.5;
+    p.x += 2;
+    print(p.x);
+    print(p.f * 2.0);
+
+    int[] xs = new(int, 4, "xs");
+    for (int i = 0; i < 4; i++) {
+        xs[i] = i * i;
+        xs[i]++;
+    }
+    xs[3]--;
+    print(xs[0] + xs[1] + xs[2] + xs[3]);
+
+    int n = 0;
+    try {
+        while (n < 100) {
+            n++;
+            if (bump(n) > 50) {
+                throw "stop";
+            }
+        }
+    } catch (err) {
+        print(err);
+    }
+    print(n);
+    print(total);
+
+    free(xs);
+    free(p);
+}
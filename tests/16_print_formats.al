@@ -0,0 +1,23 @@
+// Formatted print with literal formats (split into segments by abyssc) and
+// a computed one (parsed at run time): every placeholder type, braces
+// (including one that ends the string), unknown types, missing and extra
+// arguments, and a trailing '%'.
+void main() {
+    int n = -42;
+    float f = 2.5;
+    str s = "abyss";
+    char c = 'Z';
+    print("int %int, integer %integer, float %float", n, 7, f);
+    print("%{str}|%{string}|%{char}|", s, s, c);
+    print("braced last %{int}", n);
+    print("%int%int%int", 1, 2, 3);
+    print("no placeholders", n);
+    print("unknown %x skips %int", 9, 10);
+    print("too few %int %int %float", 5);
+    print("unclosed %{int here", n);
+    print("trailing %", n);
+    print("%float / %float", -0.0000004, 1234567.0000005);
+    str dyn = "computed %int and %{str}";
+    print(dyn, 11, s);
+    print(s + " %int", 12);
+}
@@ -0,0 +1,64 @@
+// stack() structs: per-frame lifetime across recursion, free and throw.
+struct Cell {
+    int value;
+    int depth;
+}
+
+function sum_down(int n) : (int r) {
+    Cell c = stack(Cell, "sum cell");
+    c.value = n;
+    c.depth = n * 2;
+    if (n == 0) {
+        return 0;
+    }
+    int below = sum_down(n - 1);
+    return below + c.value + c.depth;
+}
+
+void dive(int n) {
+    Cell c = stack(Cell, "dive cell");
+    c.value = n;
+    if (n == 0) {
+        throw "bottom";
+    }
+    dive(n - 1);
+}
+
+function fresh() : (int r) {
+    Cell c = stack(Cell);
+    return c.value + c.depth;
+}
+
+void main() {
+    Cell outer = stack(Cell, "outer");
+    outer.value = 42;
+
+    print(sum_down(10));
+    int i = 0;
+    int total = 0;
+    while (i < 1000) {
+        total = total + sum_down(20);
+        i = i + 1;
+    }
+    print(total);
+
+    try {
+        dive(50);
+    } catch (e) {
+        print(e);
+    }
+
+    Cell after = stack(Cell, "after throw");
+    after.value = 7;
+    print(outer.value);
+    print(after.value);
+
+    // Released cells come back zeroed.
+    print(fresh());
+
+    // free() on a stack() struct is accepted; it goes with the frame.
+    Cell loose = stack(Cell);
+    loose.value = 3;
+    free(loose);
+    print(outer.value + after.value);
+}
@@ -0,0 +1,91 @@
+// arena { } blocks: bulk release at block exit, early exits, nesting, throw.
+struct Node {
+    int value;
+    Node next;
+}
+
+function build(int n) : (Node head) {
+    head = null;
+    for (int i = 0; i < n; i++) {
+        Node x = new(Node, "list node");
+        x.value = i;
+        x.next = head;
+        head = x;
+    }
+    return head;
+}
+
+function total(Node h) : (int s) {
+    s = 0;
+    while (h != null) {
+        s = s + h.value;
+        h = h.next;
+    }
+    return s;
+}
+
+// return from inside a block must close it
+function early(int n) : (int r) {
+    arena {
+        Node a = build(n);
+        if (n > 2) {
+            return total(a);
+        }
+    }
+    return -1;
+}
+
+void fail_inside() {
+    arena {
+        Node a = build(5);
+        throw "inner failure";
+    }
+}
+
+void main() {
+    int sum = 0;
+    for (int round = 0; round < 1000; round++) {
+        arena {
+            Node h = build(100);
+            sum = sum + total(h);
+            if (round == 500) {
+                continue;
+            }
+            arena {
+                Node g = build(10);
+                sum = sum + total(g);
+                if (round == 998) {
+                    break;
+                }
+            }
+        }
+    }
+    print(sum);
+    print(early(10));
+    print(early(1));
+
+    try {
+        fail_inside();
+    } catch (e) {
+        print(e);
+    }
+
+    // Reused region memory comes back zeroed; free() inside is accepted.
+    arena {
+        Node k = new(Node);
+        print(k.value);
+        Node[] many = new(Node, 8);
+        print(many[7] == null);
+        free(k);
+    }
+
+    // Objects made outside the block are untouched by it.
+    Node keep = new(Node, "kept");
+    keep.value = 77;
+    arena {
+        Node tmp = build(3);
+        keep.next = null;
+    }
+    print(keep.value);
+    free(keep);
+}
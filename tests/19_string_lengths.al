@@ -0,0 +1,51 @@
+// Length-prefixed strings: literals, concat chains, int/float->str, free().
+function repeat(str s, int n) : (str r) {
+    r = s + "";
+    for (int i = 1; i < n; i++) {
+        str next = r + s;
+        free(r);
+        r = next;
+    }
+    return r;
+}
+
+void main() {
+    str empty = "";
+    str hello = "hello" + ", " + "world";
+    print(hello);
+    print(empty + hello + empty);
+
+    str line = "n=" + 42 + " f=" + 2.5 + " neg=" + (0 - 7);
+    print(line);
+    print("%str|%str", line, empty);
+    print("[%{str}]", "x" + 1 + 2);
+
+    // A long chain keeps growing from the recorded lengths.
+    str dots = repeat("ab", 40);
+    str tail = dots + "!";
+    print("%str", tail + "" + 1000);
+    free(dots);
+    free(tail);
+
+    str held = "kept";
+    str[] bag = new(str, 3);
+    bag[0] = held + 1;
+    str first = bag[0];
+    print(first);
+    free(first);
+    free(bag);
+
+    // free() on an element: not typed str, still a heap string.
+    str[] arr = new(str, 3);
+    arr[0] = "x" + 1;
+    arr[1] = "y" + 2.5;
+    str second = arr[1];
+    print(second);
+    free(arr[0]);
+    free(arr[1]);
+    free(arr);
+
+    str nothing = null;
+    free(nothing);
+    print("done");
+}
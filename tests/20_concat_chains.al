@@ -0,0 +1,25 @@
+// str + chains: one allocation per chain, numbers formatted as print does.
+void main() {
+    str name = "widget";
+    int qty = 0 - 42;
+    float price = 19.5;
+    str line = "item=" + name + " qty=" + qty + " price=" + price + ";";
+    print(line);
+    free(line);
+
+    // Numbers before the first str still add up first.
+    print(1 + 2 + "x" + 1 + 2);
+    print(2.25 + " and " + (0.0 - 0.0) + " and " + (0.0 - 0.0000001));
+    print("big " + (100000000000.0 * 1000000000.0) + " half " + 0.0000005);
+    print("wide " + (2147483647 * 2147483647) + " zero " + 0);
+
+    // Longer than one op's worth of parts.
+    str s = "p";
+    print(s + 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12 + 13 + 14 + 15 +
+          16 + 17 + 18 + 19 + 20 + 21 + 22 + 23 + 24 + 25 + 26 + 27 + 28 + 29 +
+          30 + 31 + 32 + 33);
+
+    // Nested chains and a chain inside a format.
+    print(("a" + 1) + ("b" + 2.0));
+    print("%str!", "n=" + 3);
+}
@@ -0,0 +1,56 @@
+// strbuf: amortized appends of every printable type, reset, handover, free.
+function csv_row(strbuf b, int id, str name, float score) : (str row) {
+    char comma = ',';
+    strbuf_reset(b);
+    strbuf_append(b, id);
+    strbuf_append(b, comma);
+    strbuf_append(b, name);
+    strbuf_append(b, comma);
+    strbuf_append(b, score);
+    return strbuf_str(b);
+}
+
+void main() {
+    strbuf b = strbuf_new();
+    char space = ' ';
+    strbuf_append(b, "total=");
+    strbuf_append(b, 0 - 1234567);
+    strbuf_append(b, space);
+    strbuf_append(b, 2.5);
+    strbuf_append(b, " big=");
+    strbuf_append(b, 100000000000.0 * 1000000000.0);
+    str s = strbuf_str(b);
+    print(s);
+    free(s);
+
+    // Empty after the handover, and handing over nothing gives "".
+    str none = strbuf_str(b);
+    print("[%str]", none);
+    free(none);
+
+    // Grows well past its first block.
+    for (int i = 0; i < 200; i++) {
+        strbuf_append(b, i % 10);
+    }
+    strbuf_append(b, "!");
+    str digits = strbuf_str(b);
+    print("%str", "len ok: " + digits);
+    free(digits);
+
+    // reset keeps the capacity for the next row.
+    strbuf rows = strbuf_new();
+    for (int i = 0; i < 3; i++) {
+        str row = csv_row(rows, i, "item" + i, i * 0.5);
+        print(row);
+        free(row);
+    }
+    strbuf_append(rows, "tail");
+    strbuf_reset(rows);
+    strbuf_append(rows, "kept");
+    print(strbuf_str(rows));
+
+    free(rows);
+    free(b);
+    strbuf gone = null;
+    free(gone);
+}
@@ -0,0 +1,53 @@
+// return from inside try: the handler goes with the returning frame, so a
+// later throw reaches the caller's catch, not the finished function's.
+function checked(int n) : (int r) {
+    try {
+        if (n < 0) {
+            throw "negative";
+        }
+        return n * 2;
+    } catch (e) {
+        print("checked caught " + e);
+    }
+    return 0;
+}
+
+function nested(int n) : (int r) {
+    try {
+        try {
+            return checked(n) + 1;
+        } catch (e) {
+            print("inner " + e);
+        }
+    } catch (e) {
+        print("outer " + e);
+    }
+    return 0;
+}
+
+void main() {
+    print(checked(21));
+
+    try {
+        throw "boom";
+    } catch (e) {
+        print("main caught " + e);
+    }
+
+    // More returns than the exception stack has frames.
+    int sum = 0;
+    int i = 0;
+    while (i < 1000) {
+        sum = sum + nested(i);
+        i = i + 1;
+    }
+    print(sum);
+    print(checked(0 - 1));
+
+    try {
+        int v = checked(5);
+        throw "after " + v;
+    } catch (e) {
+        print(e);
+    }
+}
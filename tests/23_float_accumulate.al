@@ -0,0 +1,22 @@
+// Float multiply-add chains must round after each operation, as the VM does.
+// A native build that fuses them into FMA instructions drifts in the last
+// printed digit within the first few dozen steps.
+void main() {
+    float s = 0.0;
+    int i = 0;
+    while (i < 100) {
+        s = s + 0.0000001 * i;
+        print(s);
+        i = i + 1;
+    }
+
+    float x = 0.1;
+    float y = 0.0;
+    i = 0;
+    while (i < 50) {
+        y = y * 0.999999 + x * x;
+        x = x + 0.0000003;
+        i = i + 1;
+    }
+    print(y);
+}
@@ -0,0 +1,16 @@
+// More open try blocks than the exception handler stack holds: a clean
+// runtime error instead of writes past the end of the stack.
+function deep(int n) : (int r) {
+    if (n == 0) { return 0; }
+    int v = 0;
+    try {
+        v = deep(n - 1) + 1;
+    } catch (e) {
+        print(e);
+    }
+    return v;
+}
+
+void main() {
+    print(deep(400));
+}
@@ -0,0 +1,45 @@
+// stack() past the 64 MiB frame arena: structs spill to the heap and are
+// still released with their frame.
+struct Big {
+    int a; int b; int c; int d; int e; int f; int g; int h;
+    int i; int j; int k; int l; int m; int n; int o; int p;
+}
+
+function fill(int n) : (int r) {
+    int i = 0;
+    int total = 0;
+    while (i < n) {
+        Big x = stack(Big);
+        x.a = i;
+        x.p = 1;
+        total = total + x.a + x.p;
+        i = i + 1;
+    }
+    return total;
+}
+
+void main() {
+    // 600,000 * 128 bytes: past the arena, all in one frame.
+    Big first = stack(Big, "first");
+    first.a = 11;
+    int i = 0;
+    int total = 0;
+    while (i < 600000) {
+        Big b = stack(Big);
+        b.a = i;
+        total = total + b.a;
+        i = i + 1;
+    }
+    print(total);
+
+    // A spilled struct can be freed early and read until then.
+    Big late = stack(Big, "late");
+    late.a = 5;
+    print(late.a);
+    free(late);
+
+    // Calls spill too, and their return releases the spilled blocks.
+    print(fill(100000));
+    print(fill(100000));
+    print(first.a);
+}
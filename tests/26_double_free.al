@@ -0,0 +1,20 @@
+// Freeing a slab object twice is reported instead of corrupting the free
+// list. A one-field struct also gets the 16-byte minimum class.
+struct Tiny {
+    int v;
+}
+
+void main() {
+    Tiny a = new(Tiny);
+    Tiny b = new(Tiny);
+    a.v = 1;
+    b.v = 2;
+    free(a);
+    // Recycled objects come back zeroed.
+    Tiny c = new(Tiny);
+    print(c.v + b.v);
+    free(b);
+    free(c);
+    free(b);
+    print("unreachable");
+}
@@ -1,10 +1,12 @@
 #!/bin/bash
 # AbyssLang regression test harness
-# Runs every tests/*.al file in both VM and native mode, compares stdout
-# against tests/expected/<name>.txt, reports PASS/FAIL.
+# Runs every tests/*.al file in VM (stack bytecode interpreted, --jit and
+# --tier, and register bytecode) and native mode, compares stdout against
+# tests/expected/<name>.txt, reports PASS/FAIL.
 #
 # Convention: tests whose name starts with "fail_" are EXPECTED to fail at
 # compile time. The expected file holds the fragment of the error message.
+# Every test needs an expected file; a missing one counts as a failure.
 
 set -u
 
@@ -12,6 +14,9 @@ ABYSSC="${ABYSSC:-./abyssc}"
 VM="${VM:-./abyss_vm}"
 TEST_DIR="${TEST_DIR:-tests}"
 EXPECTED_DIR="${EXPECTED_DIR:-$TEST_DIR/expected}"
+# Tests also built as split native programs: interface calls (fn_at across
+# units), try/throw, stack() and string builders.
+SPLIT_TESTS="${SPLIT_TESTS:-07_try_catch 08_interface 12_mutual_recursion 17_stack_arena 21_string_builders 22_return_in_try}"
 
 PASS=0
 FAIL=0
@@ -54,6 +59,13 @@ check_contains() {
     fi
 }
 
+missing() {
+    local name="$1"
+    printf "  ${RED}✗${RESET} %-8s %s (no expected file)\n" "EXPECTED" "$name"
+    FAIL=$((FAIL + 1))
+    FAILED_NAMES+=("EXPECTED:$name")
+}
+
 printf "${CYAN}AbyssLang regression suite${RESET}\n"
 printf "  compiler: %s\n" "$ABYSSC"
 printf "  vm:       %s\n" "$VM"
@@ -68,7 +80,7 @@ for test in "$TEST_DIR"/*.al; do
     # stderr contains the expected file's text.
     if [[ "$name" == fail_* ]]; then
         if [ ! -f "$expected_file" ]; then
-            printf "  ${YELLOW}?${RESET} SKIP     %s (no expected file)\n" "$name"
+            missing "$name"
             continue
         fi
         needle=$(cat "$expected_file")
@@ -88,7 +100,7 @@ for test in "$TEST_DIR"/*.al; do
 
     # Positive tests: compile, run VM, run native, compare stdout
     if [ ! -f "$expected_file" ]; then
-        printf "  ${YELLOW}?${RESET} SKIP     %s (no expected file)\n" "$name"
+        missing "$name"
         continue
     fi
     expected=$(cat "$expected_file")
@@ -108,6 +120,23 @@ for test in "$TEST_DIR"/*.al; do
     actual_vm=$("$VM" "$tmp_aby" 2>&1)
     check "VM" "$expected" "$actual_vm" "$name"
 
+    actual_jit=$("$VM" --jit "$tmp_aby" 2>&1)
+    check "JIT" "$expected" "$actual_jit" "$name"
+
+    actual_tier=$("$VM" --tier-threshold=1 "$tmp_aby" 2>&1)
+    check "TIER" "$expected" "$actual_tier" "$name"
+
+    tmp_reg="/tmp/${name}_reg.aby"
+    rm -f "$tmp_reg"
+    if "$ABYSSC" --register "$test" "$tmp_reg" >/dev/null 2>&1; then
+        actual_reg=$("$VM" "$tmp_reg" 2>&1)
+        check "REGISTER" "$expected" "$actual_reg" "$name"
+    else
+        printf "  ${RED}✗${RESET} %-8s %s (register compile failed)\n" "REGISTER" "$name"
+        FAIL=$((FAIL + 1))
+        FAILED_NAMES+=("REGISTER:$name")
+    fi
+
     if "$ABYSSC" --native "$test" "$tmp_native" >/dev/null 2>&1; then
         actual_native=$("$tmp_native" 2>&1)
         check "NATIVE" "$expected" "$actual_native" "$name"
@@ -116,6 +145,21 @@ for test in "$TEST_DIR"/*.al; do
         FAIL=$((FAIL + 1))
         FAILED_NAMES+=("NATIVE:$name")
     fi
+
+    # A few tests also go through the split native build (shared header,
+    # one C file per function group, parallel gcc), which only large
+    # programs reach by default.
+    case " $SPLIT_TESTS " in *" $name "*)
+        rm -f "$tmp_native"
+        if ABYSS_SHARD_BYTES=1 "$ABYSSC" --native -j4 "$test" "$tmp_native" >/dev/null 2>&1; then
+            actual_split=$("$tmp_native" 2>&1)
+            check "SPLIT" "$expected" "$actual_split" "$name"
+        else
+            printf "  ${RED}✗${RESET} %-8s %s (split native compile failed)\n" "SPLIT" "$name"
+            FAIL=$((FAIL + 1))
+            FAILED_NAMES+=("SPLIT:$name")
+        fi
+    esac
 done
 
 printf "\n"
@@ -1,10 +1,18 @@
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS (JIT code buffers)
 #include "include/common.h"
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -12,6 +20,7 @@
 #define STACK_SIZE (1024 * 1024)
 #define CALL_STACK_SIZE 4096
 #define EXCEPTION_STACK_SIZE 256
+#define ARENA_SIZE (64 * 1024 * 1024) // bytes of stack() structs
 
 // --- ENABLE ABYSS EYE ---
 #define ENABLE_ABYSS_EYE 1
@@ -27,7 +36,12 @@
 #define C_MAGENTA "\033[35m"
 
 // --- MEMORY TRACKING ---
-typedef struct AllocInfo {
+// Every allocation gets a record in an append-only log, which the lifecycle
+// section of abyss_eye() lists newest first. Live allocations are indexed by
+// address in an open-addressing table (log index + 1, 0 = empty slot), so
+// free and tag find their record in O(1). Live stack() allocations are also
+// listed in arena order, so a frame's release pops exactly its own.
+typedef struct {
   void *ptr;
   uint32_t struct_id;
   uint32_t size;
@@ -38,24 +52,35 @@ typedef struct AllocInfo {
   char *comment;
   int is_stack;
   int is_freed; // NEW: Tracks if it's active or historical
-  struct AllocInfo *next;
+  int in_region; // made by new() inside an arena { } block
 } AllocInfo;
 
-static AllocInfo *alloc_head = NULL;
-static int stack_alloc_count = 0;
+static AllocInfo *allocs = NULL;
+static uint32_t alloc_count = 0, alloc_cap = 0;
+static uint32_t *live = NULL;
+static uint32_t live_count = 0, live_cap = 0; // live_cap: power of two
+static uint32_t *stack_allocs = NULL;         // log indices, arena order
+static uint32_t stack_alloc_count = 0, stack_alloc_cap = 0;
 
 // --- VM STATE ---
-static uint8_t *code;
+// The .aby file is mapped read-only and every section is used in place
+// (see BcHeader in common.h).
+static const uint8_t *image;
+static size_t image_size;
+static const uint8_t *code;
 static size_t code_size;
-static char **strs;
+static const uint32_t *str_index;
 static uint32_t str_count;
-
-typedef struct {
-  char *name;
-  uint32_t size;
-} StructMeta;
-static StructMeta *structs = NULL;
+static const BcStruct *structs = NULL;
 static uint32_t struct_count = 0;
+static const BcFunc *funcs = NULL;
+static uint32_t func_count = 0;
+static const BcFmtSeg *fmts = NULL;
+static uint32_t fmt_count = 0;
+static const BcLine *lines = NULL; // optional; --stats reports lines
+static uint32_t line_count = 0;
+#define IMAGE_STR(off) ((char *)image + (off))
+#define STR(i) IMAGE_STR(str_index[i])
 
 static int64_t stack[STACK_SIZE];
 static int64_t globals[1024];
@@ -66,57 +91,378 @@ static size_t ip = 0;
 typedef struct {
   size_t ret_addr;
   size_t old_fp;
+  size_t arena_mark; // arena_top when the call was made
 } Frame;
 static Frame call_stack[CALL_STACK_SIZE];
 static size_t csp = 0;
 
+// Sampling profiler (abyss_vm --prof=FILE, see prof_sample).
+#define PROF_INTERVAL_US 1000
+#define PROF_DEPTH 256        // innermost frames kept per sample
+#define PROF_WORDS (1u << 22) // sample log: depth, then code addresses
+
+static const char *prof_path;
+// csp << 32 | code address about to run. One store, so a sample never
+// pairs an address with the depth of the instruction before it.
+static volatile uint64_t prof_pos;
+#define PROF_POS(at, depth) ((uint64_t)(depth) << 32 | (uint32_t)(at))
+static uint32_t *prof_log;
+static volatile uint32_t prof_len, prof_samples, prof_dropped;
+static int prof_cells; // call_stack holds cell indices (stack engine)
+static void **stub_h;  // cell index -> real handler under --prof/--stats
+
 typedef struct {
   size_t catch_addr;
   size_t old_sp;
   size_t old_fp;
   size_t old_csp;
+  uint32_t old_regions; // region_depth at TRY
 } ExceptionFrame;
 static ExceptionFrame exception_stack[EXCEPTION_STACK_SIZE];
 static size_t esp = 0;
 
-static inline __attribute__((always_inline)) void push(int64_t v) {
-  if (__builtin_expect(sp >= STACK_SIZE, 0)) {
-    fprintf(stderr,
-            "\033[1;31m[FATAL ERROR]\033[0m Stack overflow (limit %d slots).\n",
-            STACK_SIZE);
-    fprintf(
-        stderr,
-        "  This usually means deep recursion or an expression that keeps\n");
-    fprintf(
-        stderr,
-        "  pushing values without popping. Check loops and recursion depth.\n");
-    exit(1);
+// A return from inside try leaves the function's handlers behind; csp has
+// already dropped to the caller's, so they belong to finished frames.
+static inline void drop_handlers(void) {
+  while (esp > 0 && exception_stack[esp - 1].old_csp > csp)
+    esp--;
+}
+
+// stack(T) structs are carved from one bump region. A call records the top
+// in its Frame; returning from it, or a throw unwinding past it, resets the
+// top and so releases everything the callee allocated at once.
+// Once the region is full, structs spill to calloc blocks: arena_top keeps
+// counting past ARENA_SIZE, so frame marks still order them, and a release
+// frees the spilled blocks allocated above its mark.
+static uint8_t arena[ARENA_SIZE] __attribute__((aligned(16)));
+static size_t arena_top = 0;
+#define IN_ARENA(p)                                                            \
+  ((const uint8_t *)(p) >= arena && (const uint8_t *)(p) < arena + ARENA_SIZE)
+typedef struct {
+  void *ptr;
+  size_t at; // arena_top when allocated
+} Spill;
+static Spill *spills = NULL; // allocation order
+static uint32_t spill_count = 0, spill_cap = 0;
+
+// new() structs and arrays up to SLAB_MAX bytes come from size classes that
+// step by 8 bytes. Each class carves SLAB_CHUNK blocks out of one reserved
+// region (slab_class[] maps a chunk back to its class) and threads freed
+// objects into a free list. Fresh chunks are zero from mmap, so only recycled
+// objects are cleared. Larger requests, and everything once the region is
+// used up, go to calloc.
+#define SLAB_MAX 512
+#define SLAB_CLASSES (SLAB_MAX / 8 + 1)
+#define SLAB_CHUNK (64 * 1024)
+#define SLAB_REGION ((size_t)1 << 30)
+static uint8_t *slab_base = NULL; // reserved on first use
+static size_t slab_used = 0;      // bytes of the region handed to chunks
+static uint8_t slab_class[SLAB_REGION / SLAB_CHUNK];
+static void *slab_free_list[SLAB_CLASSES];
+static size_t slab_next[SLAB_CLASSES], slab_end[SLAB_CLASSES];
+static uint64_t slab_allocs = 0, slab_reused = 0;
+#define IN_SLAB(p)                                                             \
+  ((const uint8_t *)(p) >= slab_base &&                                        \
+   (const uint8_t *)(p) < slab_base + slab_used)
+// A freed object holds its free-list link and, in its second word,
+// SLAB_FREED; classes start at 16 bytes so every object has that word. A
+// free() that finds the mark checks the free list before calling it a double
+// free, so a live value that happens to equal the mark is no false alarm.
+#define SLAB_FREED 0xDEADF4EE5AB5F4EEULL
+
+// arena { } blocks. While one is open, new() bumps out of a single reserved
+// region instead of the slabs; closing the block, or a throw unwinding out of
+// it, drops everything allocated since it opened. Blocks nest, so each open
+// block only records the region top it started at. Bytes past region_clean
+// have never been handed out and are still zero from mmap.
+#define REGION_SIZE ((size_t)1 << 30)
+#define REGION_DEPTH 256
+typedef struct {
+  size_t mark;          // region_top when the block opened
+  size_t open_ip;       // ip of its OP_ARENA_BEGIN
+  uint32_t objects;     // new() calls it served
+  uint32_t first_alloc; // alloc_count when it opened (Abyss Eye)
+} Region;
+static uint8_t *region_base = NULL; // reserved on first use
+static size_t region_top = 0, region_clean = 0;
+static Region regions[REGION_DEPTH];
+static uint32_t region_depth = 0;
+static uint64_t regions_closed = 0, region_objects = 0;
+#define IN_REGION(p)                                                           \
+  (region_base && (const uint8_t *)(p) >= region_base &&                       \
+   (const uint8_t *)(p) < region_base + REGION_SIZE)
+
+#ifdef ABYSS_COUNT_DISPATCH
+static uint64_t dispatch_count = 0;
+#endif
+
+static void fatal_stack_overflow(void) {
+  fprintf(stderr,
+          "\033[1;31m[FATAL ERROR]\033[0m Stack overflow (limit %d slots).\n",
+          STACK_SIZE);
+  fprintf(stderr,
+          "  This usually means deep recursion or an expression that keeps\n");
+  fprintf(
+      stderr,
+      "  pushing values without popping. Check loops and recursion depth.\n");
+  exit(1);
+}
+
+static void fatal_call_overflow(void) {
+  fprintf(stderr,
+          "\033[1;31m[FATAL ERROR]\033[0m Call stack overflow (limit %d "
+          "frames).\n",
+          CALL_STACK_SIZE);
+  fprintf(stderr,
+          "  This usually means unbounded recursion. Check your base cases.\n");
+  exit(1);
+}
+
+static void fatal_handler_overflow(void) {
+  fprintf(stderr,
+          "\033[1;31m[FATAL ERROR]\033[0m Exception handler stack overflow "
+          "(limit %d open try blocks).\n",
+          EXCEPTION_STACK_SIZE);
+  fprintf(stderr, "  This usually means a try inside unbounded recursion.\n");
+  exit(1);
+}
+
+static void fatal_region(const char *what) {
+  fprintf(stderr, "\033[1;31m[FATAL ERROR]\033[0m arena block %s.\n", what);
+  exit(1);
+}
+
+static void fatal_double_free(void) {
+  fprintf(stderr, "\033[1;31m[FATAL ERROR]\033[0m Double free of a new() "
+                  "object.\n");
+  fprintf(stderr, "  free() was already called on it; free each new() result "
+                  "once.\n");
+  exit(1);
+}
+
+static void fatal_bad_code(const char *what, size_t at, uint32_t v) {
+  fprintf(stderr,
+          "\033[1;31m[FATAL ERROR]\033[0m Corrupt bytecode: %s %u at offset "
+          "%zu.\n",
+          what, v, at);
+  exit(1);
+}
+
+// --- PROGRAM OUTPUT ---
+// print and its variants append to one large buffer with hand-rolled number
+// formatting instead of going through printf. The buffer is written out when
+// it fills, at exit (an atexit handler, so fatal errors and uncaught
+// exceptions are covered too) and after every newline when stdout is a
+// terminal. Abyss Eye still uses stdio; out_flush() keeps the two in order.
+#define OUT_SIZE (64 * 1024)
+static char out_buf[OUT_SIZE];
+static size_t out_len = 0;
+static int out_tty = 0;
+
+static void out_flush(void) {
+  fflush(stdout);
+  for (size_t done = 0; done < out_len;) {
+    ssize_t n = write(STDOUT_FILENO, out_buf + done, out_len - done);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    done += (size_t)n;
+  }
+  out_len = 0;
+}
+
+static inline void out_reserve(size_t n) {
+  if (out_len + n > OUT_SIZE)
+    out_flush();
+}
+
+static inline void out_char(char c) {
+  out_reserve(1);
+  out_buf[out_len++] = c;
+  if (c == '\n' && out_tty)
+    out_flush();
+}
+
+static void out_mem(const char *s, size_t n) {
+  while (n) {
+    if (out_len == OUT_SIZE)
+      out_flush();
+    size_t k = OUT_SIZE - out_len < n ? OUT_SIZE - out_len : n;
+    memcpy(out_buf + out_len, s, k);
+    out_len += k;
+    s += k;
+    n -= k;
+  }
+}
+
+static inline void out_str(const char *s) { out_mem(s, strlen(s)); }
+
+// Runtime strings carry their length in front (see STR_HDR).
+static inline uint32_t str_len(const char *s) {
+  uint32_t n;
+  memcpy(&n, s - STR_HDR, sizeof(n));
+  return n;
+}
+
+static inline void out_lstr(const char *s) { out_mem(s, str_len(s)); }
+
+// A heap string of n chars with its header and NUL in place; the caller
+// fills in the chars.
+static char *str_alloc(size_t n) {
+  char *s = malloc(STR_HDR + n + 1);
+  uint32_t len = (uint32_t)n;
+  memcpy(s, &len, sizeof(len));
+  s += STR_HDR;
+  s[n] = 0;
+  return s;
+}
+
+// Appends u in decimal, zero-padded to `width` digits. Room is reserved by
+// the caller.
+static inline void out_digits(uint64_t u, int width) {
+  char tmp[20];
+  int n = 0;
+  do
+    tmp[n++] = (char)('0' + u % 10);
+  while ((u /= 10) || n < width);
+  while (n)
+    out_buf[out_len++] = tmp[--n];
+}
+
+// "%ld"
+static inline void out_int(int64_t v) {
+  out_reserve(21);
+  if (v < 0)
+    out_buf[out_len++] = '-';
+  out_digits(v < 0 ? 0 - (uint64_t)v : (uint64_t)v, 1);
+}
+
+// "%.6f" of v as a whole number of millionths, rounded. Returns 0 when the
+// scaled product is within its own rounding error of a half (or too large,
+// or not finite); printf's exact decimal conversion decides those.
+static inline int float_micros(double v, uint64_t *r) {
+  double a = v < 0 ? -v : v;
+  if (!(a < 1e9))
+    return 0;
+  double s = a * 1e6;
+  uint64_t u = (uint64_t)s;
+  double frac = s - (double)u, err = s * 0x1p-52;
+  if (frac > 0.5 + err || frac < 0.5 - err) {
+    *r = u + (frac > 0.5);
+    return 1;
   }
-  stack[sp++] = v;
+  return 0;
 }
-static inline __attribute__((always_inline)) int64_t pop() {
-  return stack[--sp];
+
+// "%.6f"
+static void out_float(double v) {
+  uint64_t r;
+  if (float_micros(v, &r)) {
+    out_reserve(18);
+    if (signbit(v))
+      out_buf[out_len++] = '-';
+    out_digits(r / 1000000, 1);
+    out_buf[out_len++] = '.';
+    out_digits(r % 1000000, 6);
+    return;
+  }
+  char buf[512];
+  snprintf(buf, sizeof(buf), "%.6f", v);
+  out_str(buf);
 }
 
 // --- MEMORY MANAGEMENT ---
+#ifdef ENABLE_ABYSS_EYE
+static uint32_t live_hash(const void *ptr) {
+  return (uint32_t)((((uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ull) >> 32) &
+         (live_cap - 1);
+}
+
+// Slot holding the live record for ptr, or -1.
+static int64_t live_find(const void *ptr) {
+  if (!live_count)
+    return -1;
+  for (uint32_t h = live_hash(ptr);; h = (h + 1) & (live_cap - 1)) {
+    if (!live[h])
+      return -1;
+    if (allocs[live[h] - 1].ptr == ptr)
+      return h;
+  }
+}
+
+static void live_put(uint32_t idx) {
+  uint32_t h = live_hash(allocs[idx].ptr);
+  while (live[h] && allocs[live[h] - 1].ptr != allocs[idx].ptr)
+    h = (h + 1) & (live_cap - 1);
+  live_count += !live[h];
+  live[h] = idx + 1; // an address seen again names the newer allocation
+}
+
+// Empties slot h, moving later entries of its probe run back so lookups
+// never need tombstones.
+static void live_remove(uint32_t h) {
+  live_count--;
+  for (uint32_t j = (h + 1) & (live_cap - 1); live[j];
+       j = (j + 1) & (live_cap - 1)) {
+    uint32_t home = live_hash(allocs[live[j] - 1].ptr);
+    if (((j - home) & (live_cap - 1)) >= ((j - h) & (live_cap - 1))) {
+      live[h] = live[j];
+      h = j;
+    }
+  }
+  live[h] = 0;
+}
+
+static void live_grow(void) {
+  uint32_t *old = live, old_cap = live_cap;
+  live_cap = live_cap ? live_cap * 2 : 1024;
+  live = calloc(live_cap, sizeof(uint32_t));
+  if (!live) {
+    fprintf(stderr, "Out of memory (Abyss Eye)\n");
+    exit(1);
+  }
+  live_count = 0;
+  for (uint32_t i = 0; i < old_cap; i++)
+    if (old[i])
+      live_put(old[i] - 1);
+  free(old);
+}
+
+static void *grow_array(void *p, uint32_t *cap, size_t elem) {
+  *cap = *cap ? *cap * 2 : 1024;
+  p = realloc(p, *cap * elem);
+  if (!p) {
+    fprintf(stderr, "Out of memory (Abyss Eye)\n");
+    exit(1);
+  }
+  return p;
+}
+#endif
+
 void track_alloc(void *ptr, uint32_t sid, uint32_t size, int is_stack,
                  char *comment) {
 #ifdef ENABLE_ABYSS_EYE
-  AllocInfo *node = malloc(sizeof(AllocInfo));
-  node->ptr = ptr;
-  node->struct_id = sid;
-  node->size = size;
-  node->alloc_fp = fp;
-  node->alloc_ip = ip;
-  node->free_ip = 0;
-  node->tag = NULL;
-  node->comment = comment;
-  node->is_stack = is_stack;
-  node->is_freed = 0;
-  node->next = alloc_head;
-  alloc_head = node;
-  if (is_stack)
-    stack_alloc_count++;
+  if (alloc_count == alloc_cap)
+    allocs = grow_array(allocs, &alloc_cap, sizeof(AllocInfo));
+  uint32_t idx = alloc_count++;
+  allocs[idx] = (AllocInfo){.ptr = ptr,
+                            .struct_id = sid,
+                            .size = size,
+                            .alloc_fp = fp,
+                            .alloc_ip = ip,
+                            .comment = comment,
+                            .is_stack = is_stack,
+                            .in_region = region_depth && IN_REGION(ptr)};
+  if (2 * (live_count + 1) > live_cap)
+    live_grow();
+  live_put(idx);
+  if (is_stack) {
+    if (stack_alloc_count == stack_alloc_cap)
+      stack_allocs =
+          grow_array(stack_allocs, &stack_alloc_cap, sizeof(uint32_t));
+    stack_allocs[stack_alloc_count++] = idx;
+  }
 #else
   (void)ptr;
   (void)sid;
@@ -128,43 +474,373 @@ void track_alloc(void *ptr, uint32_t sid, uint32_t size, int is_stack,
 
 void untrack_alloc(void *ptr) {
 #ifdef ENABLE_ABYSS_EYE
-  AllocInfo *curr = alloc_head;
-  while (curr) {
-    if (curr->ptr == ptr && !curr->is_freed) {
-      curr->is_freed = 1;
-      curr->free_ip = ip; // Record exactly where it was freed!
-      return;
-    }
-    curr = curr->next;
-  }
+  int64_t h = live_find(ptr);
+  if (h < 0)
+    return;
+  AllocInfo *a = &allocs[live[h] - 1];
+  a->is_freed = 1;
+  a->free_ip = ip; // Record exactly where it was freed!
+  live_remove((uint32_t)h);
 #else
   (void)ptr;
 #endif
 }
 
-void free_stack_allocs(size_t current_fp) {
-#ifdef ENABLE_ABYSS_EYE
-  if (stack_alloc_count == 0)
-    return;
-  AllocInfo *curr = alloc_head;
-  while (curr) {
-    if (curr->is_stack && !curr->is_freed && curr->alloc_fp >= current_fp) {
-      curr->is_freed = 1;
-      curr->free_ip = ip;
-      free(curr->ptr);
-      stack_alloc_count--;
+// Returns a zeroed stack() struct from the arena, or from the heap once the
+// arena is full.
+static void *arena_alloc(uint32_t size) {
+  size = size ? (size + 7) & ~7u : 8; // distinct addresses for empty structs
+  void *p;
+  if (arena_top + size <= ARENA_SIZE) {
+    p = arena + arena_top;
+    memset(p, 0, size);
+  } else {
+    if (spill_count == spill_cap) {
+      spill_cap = spill_cap ? spill_cap * 2 : 64;
+      spills = realloc(spills, spill_cap * sizeof(Spill));
     }
-    curr = curr->next;
+    p = calloc(1, size);
+    if (!p || !spills) {
+      fprintf(stderr, "\033[1;31m[FATAL ERROR]\033[0m Out of memory for "
+                      "stack() structs.\n");
+      exit(1);
+    }
+    spills[spill_count++] = (Spill){p, arena_top};
+  }
+  arena_top += size;
+  return p;
+}
+
+// Index in spills[] of a stack() struct that spilled to the heap, else -1.
+static int64_t spill_find(const void *p) {
+  for (uint32_t i = spill_count; i-- > 0;)
+    if (spills[i].ptr == p)
+      return i;
+  return -1;
+}
+
+// Where a stack() struct lies in the arena's order, spilled or not. *s is a
+// cursor into spills[] that only moves down: a release visits the structs
+// newest first, the order spills[] holds them in.
+static inline size_t arena_pos(const void *p, uint32_t *s) {
+  if (IN_ARENA(p))
+    return (size_t)((const uint8_t *)p - arena);
+  while (*s > 0 && spills[*s - 1].ptr != p)
+    (*s)--;
+  return *s ? spills[*s - 1].at : 0;
+}
+
+// Gives class c a fresh chunk. Returns 0 when the region is exhausted or
+// could not be reserved.
+static int slab_refill(uint32_t c) {
+  if (slab_used + SLAB_CHUNK > SLAB_REGION)
+    return 0;
+  if (!slab_base) {
+    void *r = mmap(NULL, SLAB_REGION, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (r == MAP_FAILED) {
+      slab_used = SLAB_REGION; // never try again; IN_SLAB stays false
+      return 0;
+    }
+    slab_base = r;
+  }
+  slab_class[slab_used / SLAB_CHUNK] = (uint8_t)c;
+  slab_next[c] = slab_used;
+  slab_end[c] = slab_used + SLAB_CHUNK;
+  slab_used += SLAB_CHUNK;
+  return 1;
+}
+
+// OP_ARENA_BEGIN.
+static void region_begin(void) {
+  if (region_depth == REGION_DEPTH)
+    fatal_region("nesting too deep (limit 256)");
+  if (!region_base) {
+    void *r = mmap(NULL, REGION_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (r == MAP_FAILED)
+      fatal_region("memory could not be reserved");
+    region_base = r;
+  }
+  regions[region_depth++] = (Region){region_top, ip, 0, alloc_count};
+}
+
+// Returns zeroed memory from the innermost open arena block.
+static void *region_alloc(uint32_t size) {
+  size = size ? (size + 7) & ~7u : 8;
+  if (size > REGION_SIZE - region_top)
+    fatal_region("memory exhausted (limit 1024 MiB)");
+  uint8_t *p = region_base + region_top;
+  if (region_top < region_clean)
+    memset(p, 0,
+           size < region_clean - region_top ? size : region_clean - region_top);
+  region_top += size;
+  if (region_top > region_clean)
+    region_clean = region_top;
+  regions[region_depth - 1].objects++;
+  region_objects++;
+  return p;
+}
+
+// Closes every open block above depth (OP_ARENA_END, or a throw caught
+// outside them) and releases their memory in one step. Abyss Eye records
+// their objects as freed at the current ip.
+static void region_release(uint32_t depth) {
+  Region *r = &regions[depth];
+#ifdef ENABLE_ABYSS_EYE
+  for (uint32_t i = r->first_alloc; i < alloc_count; i++) {
+    AllocInfo *a = &allocs[i];
+    if (!a->in_region || a->is_freed)
+      continue;
+    a->is_freed = 1;
+    a->free_ip = ip;
+    int64_t h = live_find(a->ptr);
+    if (h >= 0 && live[h] == i + 1)
+      live_remove((uint32_t)h);
+  }
+#endif
+  regions_closed += region_depth - depth;
+  region_top = r->mark;
+  region_depth = depth;
+}
+
+// Returns a zeroed new() struct or array.
+static void *heap_alloc(uint32_t size) {
+  if (region_depth)
+    return region_alloc(size);
+  uint32_t c = size > 8 ? (size + 7) >> 3 : 2;
+  if (c >= SLAB_CLASSES)
+    return calloc(1, size);
+  void *p = slab_free_list[c];
+  if (p) {
+    slab_free_list[c] = *(void **)p;
+    memset(p, 0, c * 8);
+    slab_reused++;
+  } else {
+    if (slab_next[c] + c * 8 > slab_end[c] && !slab_refill(c))
+      return calloc(1, size);
+    p = slab_base + slab_next[c];
+    slab_next[c] += c * 8;
+  }
+  slab_allocs++;
+  return p;
+}
+
+// new() blocks are 8-byte aligned; a heap string reached through a plain
+// free() (its static type lost, say through an array element) sits STR_HDR
+// into its malloc block, so the low bits tell the two apart.
+_Static_assert(STR_HDR % 8 != 0, "heap strings must be misaligned");
+static int slab_listed(uint32_t c, const void *ptr) {
+  for (void *p = slab_free_list[c]; p; p = *(void **)p)
+    if (p == ptr)
+      return 1;
+  return 0;
+}
+
+static void heap_free(void *ptr) {
+  if (((uintptr_t)ptr & 7) == STR_HDR) {
+    free((char *)ptr - STR_HDR);
+  } else if (slab_base && IN_SLAB(ptr)) {
+    uint32_t c = slab_class[((uint8_t *)ptr - slab_base) / SLAB_CHUNK];
+    uint64_t *w = ptr;
+    if (w[1] == SLAB_FREED && slab_listed(c, ptr))
+      fatal_double_free();
+    *(void **)ptr = slab_free_list[c];
+    w[1] = SLAB_FREED;
+    slab_free_list[c] = ptr;
+  } else {
+    free(ptr);
+  }
+}
+
+// Releases every stack() struct above mark (a frame returning or being
+// unwound). Abyss Eye records them as freed at the current ip.
+static void arena_release(size_t mark) {
+#ifdef ENABLE_ABYSS_EYE
+  uint32_t s = spill_count;
+  while (stack_alloc_count > 0 &&
+         arena_pos(allocs[stack_allocs[stack_alloc_count - 1]].ptr, &s) >=
+             mark) {
+    uint32_t idx = stack_allocs[--stack_alloc_count];
+    AllocInfo *a = &allocs[idx];
+    if (a->is_freed)
+      continue;
+    a->is_freed = 1;
+    a->free_ip = ip;
+    int64_t h = live_find(a->ptr);
+    if (h >= 0 && live[h] == idx + 1)
+      live_remove((uint32_t)h);
   }
-#else
-  (void)current_fp;
 #endif
+  while (spill_count > 0 && spills[spill_count - 1].at >= mark)
+    free(spills[--spill_count].ptr);
+  arena_top = mark;
+}
+
+// free() on any pointer: stack() structs stay in the arena until their frame
+// returns, arena { } objects until their block closes.
+static void free_alloc(void *ptr) {
+  untrack_alloc(ptr);
+  if (!IN_ARENA(ptr) && !IN_REGION(ptr) && !(spill_count && spill_find(ptr) >= 0))
+    heap_free(ptr);
+}
+
+// free() on a str (OP_FREE_STR): the malloc block starts at its header.
+static void free_str(char *s) {
+  untrack_alloc(s);
+  if (s)
+    free(s - STR_HDR);
+}
+
+static inline int dec_len(uint64_t u) {
+  int n = 1;
+  while (u >= 10)
+    u /= 10, n++;
+  return n;
+}
+
+// Writes the low `width` decimal digits of u, ending just before end.
+static inline void dec_put(char *end, uint64_t u, int width) {
+  while (width--) {
+    *--end = (char)('0' + u % 10);
+    u /= 10;
+  }
+}
+
+// Length of v as text, formatted as print formats a CAT_* kind. For numbers
+// *num gets the magnitude part_put() writes (UINT64_MAX: a float left to
+// printf).
+static uint32_t part_len(uint32_t kind, int64_t v, uint64_t *num) {
+  switch (kind) {
+  case CAT_STR:
+    return str_len((char *)v);
+  case CAT_INT:
+    *num = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    return (v < 0) + dec_len(*num);
+  case CAT_FLOAT: {
+    double f;
+    memcpy(&f, &v, 8);
+    if (float_micros(f, num))
+      return (signbit(f) != 0) + dec_len(*num / 1000000) + 7;
+    *num = UINT64_MAX;
+    return (uint32_t)snprintf(NULL, 0, "%.6f", f);
+  }
+  default:
+    return 1;
+  }
+}
+
+// Writes the len bytes part_len() measured, plus a NUL for a printf float.
+static void part_put(char *d, uint32_t kind, int64_t v, uint32_t len,
+                     uint64_t num) {
+  switch (kind) {
+  case CAT_STR:
+    memcpy(d, (char *)v, len);
+    break;
+  case CAT_INT:
+    if (v < 0)
+      *d = '-';
+    dec_put(d + len, num, len - (v < 0));
+    break;
+  case CAT_FLOAT: {
+    double f;
+    memcpy(&f, &v, 8);
+    if (num == UINT64_MAX) {
+      snprintf(d, len + 1, "%.6f", f);
+      break;
+    }
+    int sign = signbit(f) != 0, whole = (int)len - 7 - sign;
+    if (sign)
+      *d = '-';
+    dec_put(d + sign + whole, num / 1000000, whole);
+    d[sign + whole] = '.';
+    dec_put(d + len, num % 1000000, 6);
+    break;
+  }
+  default:
+    *d = (char)v;
+  }
+}
+
+// OP_STR_CAT_N: joins n parts in one allocation. The lengths are summed
+// first; numbers are then formatted straight into the result.
+static char *str_cat_n(const int64_t *part, uint32_t n, uint32_t kinds) {
+  uint64_t num[CAT_MAX];
+  uint32_t len[CAT_MAX];
+  size_t total = 0;
+  for (uint32_t i = 0; i < n; i++)
+    total += len[i] = part_len((kinds >> 2 * i) & 3, part[i], &num[i]);
+
+  char *s = str_alloc(total), *d = s;
+  for (uint32_t i = 0; i < n; d += len[i++])
+    part_put(d, (kinds >> 2 * i) & 3, part[i], len[i], num[i]);
+  track_alloc(s, 0xFFFFFFFE, total + 1, 0, "Dynamic String Concat");
+  return s;
+}
+
+// --- STRING BUILDERS ---
+// A strbuf's chars sit in a block laid out like a heap string (STR_HDR
+// length, chars, NUL) that doubles as it fills, so strbuf_str() hands the
+// block over as a str without copying. Abyss Eye tracks the block.
+typedef struct {
+  char *s; // chars, NULL until the first append
+  uint32_t len;
+  uint32_t cap; // chars that fit, not counting the NUL
+} StrBuf;
+
+// Room for n more chars; returns where they go.
+static char *strbuf_grow(StrBuf *b, uint32_t n) {
+  if ((size_t)b->len + n > b->cap) {
+    size_t cap = b->cap ? b->cap : 56;
+    while (cap < (size_t)b->len + n)
+      cap *= 2;
+    if (b->s)
+      untrack_alloc(b->s);
+    char *blk = realloc(b->s ? b->s - STR_HDR : NULL, STR_HDR + cap + 1);
+    b->s = blk + STR_HDR;
+    b->cap = (uint32_t)cap;
+    track_alloc(b->s, 0xFFFFFFFE, b->cap + 1, 0, "String Builder");
+  }
+  char *d = b->s + b->len;
+  b->len += n;
+  return d;
+}
+
+static void strbuf_append(StrBuf *b, uint32_t kind, int64_t v) {
+  uint64_t num = 0;
+  uint32_t len = part_len(kind, v, &num);
+  part_put(strbuf_grow(b, len), kind, v, len, num);
+}
+
+// Hands the chars over as a heap str; the strbuf starts again empty.
+static char *strbuf_str(StrBuf *b) {
+  char *s = b->s;
+  if (!s) {
+    s = str_alloc(0);
+    track_alloc(s, 0xFFFFFFFE, 1, 0, "String Builder");
+    return s;
+  }
+  memcpy(s - STR_HDR, &b->len, sizeof(b->len));
+  s[b->len] = 0;
+  b->s = NULL;
+  b->len = b->cap = 0;
+  return s;
+}
+
+static void strbuf_free(StrBuf *b) {
+  if (!b)
+    return;
+  if (b->s) {
+    untrack_alloc(b->s);
+    free(b->s - STR_HDR);
+  }
+  free(b);
 }
 
 // --- REVOLUTIONARY ABYSS EYE HUD ---
 void abyss_eye() {
 #ifdef ENABLE_ABYSS_EYE
-  AllocInfo *curr = alloc_head;
+  out_flush();
 
   uint32_t active_stack = 0;
   uint32_t active_heap = 0;
@@ -173,7 +849,8 @@ void abyss_eye() {
   int active_count = 0;
 
   // Pass 1: Calculate Statistics
-  while (curr) {
+  for (uint32_t i = 0; i < alloc_count; i++) {
+    AllocInfo *curr = &allocs[i];
     total_allocs++;
     if (curr->is_freed) {
       total_freed += curr->size;
@@ -184,7 +861,6 @@ void abyss_eye() {
       else
         active_heap += curr->size;
     }
-    curr = curr->next;
   }
 
   printf("\n");
@@ -225,11 +901,57 @@ void abyss_eye() {
                        "                                                       "
                        "                      " C_BOLD C_CYAN "│\n" C_RESET,
          total_allocs);
+  printf(C_BOLD C_CYAN "  │" C_RESET "  Slab Allocations    : " C_BOLD
+                       "%-8u" C_RESET " recycled " C_BOLD "%-8u" C_RESET
+                       "                                                       "
+                       "    " C_BOLD C_CYAN "│\n" C_RESET,
+         (uint32_t)slab_allocs, (uint32_t)slab_reused);
   printf(C_BOLD C_CYAN
          "  "
          "╰────────────────────────────────────────────────────────────────────"
          "──────────────────────────────────────────╯\n\n" C_RESET);
 
+  // ==========================================
+  // SECTION 1b: ARENA BLOCKS (once any was opened)
+  // ==========================================
+  if (region_depth || regions_closed) {
+    char row[128];
+    printf(C_BOLD C_YELLOW
+           "  "
+           "╭──────────────────────────────────────────────────────────────────"
+           "────────────────────────────────────────────╮\n" C_RESET);
+    printf(C_BOLD C_YELLOW
+           "  │" C_RESET C_BOLD
+           "  🧱   A R E N A   B L O C K S                                     "
+           "                                          " C_BOLD C_YELLOW
+           "│\n" C_RESET);
+    printf(C_BOLD C_YELLOW
+           "  "
+           "├──────────────────────────────────────────────────────────────────"
+           "────────────────────────────────────────────┤\n" C_RESET);
+    for (uint32_t i = 0; i < region_depth; i++) {
+      size_t end = i + 1 < region_depth ? regions[i + 1].mark : region_top;
+      snprintf(row, sizeof(row),
+               "  Open #%-3u  opened at IP:%04lX   objects %-8u  bytes %zu",
+               i + 1, regions[i].open_ip, regions[i].objects,
+               end - regions[i].mark);
+      printf(C_BOLD C_YELLOW "  │" C_RESET "%-109s" C_BOLD C_YELLOW
+                             "│\n" C_RESET,
+             row);
+    }
+    snprintf(row, sizeof(row),
+             "  Closed: %-8lu  objects served %-10lu  peak bytes %zu",
+             (unsigned long)regions_closed, (unsigned long)region_objects,
+             region_clean);
+    printf(C_BOLD C_YELLOW "  │" C_RESET C_GRAY "%-109s" C_RESET C_BOLD
+                           C_YELLOW "│\n" C_RESET,
+           row);
+    printf(C_BOLD C_YELLOW
+           "  "
+           "╰──────────────────────────────────────────────────────────────────"
+           "────────────────────────────────────────────╯\n\n" C_RESET);
+  }
+
   // ==========================================
   // SECTION 2: ACTIVE MEMORY (HEXDUMP)
   // ==========================================
@@ -264,16 +986,26 @@ void abyss_eye() {
            "│\n" C_RESET);
   }
 
-  curr = alloc_head;
-  while (curr) {
+  int printed = 0;
+  for (uint32_t i = alloc_count; i-- > 0;) {
+    AllocInfo *curr = &allocs[i];
     if (!curr->is_freed) {
+      // Separator between consecutive active items
+      if (printed++) {
+        printf(C_BOLD C_RED
+               "  "
+               "├───────────────────┼───────┼──────────────┼────────────┼──────"
+               "─┼─────────┼──────────────────────────────────┤\n" C_RESET);
+      }
       const char *icon = curr->is_stack ? "⚡" : "💎";
       const char *type_name = (curr->struct_id == 0xFFFFFFFF) ? "Array"
                               : (curr->struct_id == 0xFFFFFFFE)
                                   ? "DynString"
-                                  : structs[curr->struct_id].name;
+                                  : IMAGE_STR(structs[curr->struct_id].name);
       const char *tag_name = curr->tag ? curr->tag : "-";
-      const char *lifetime = curr->is_stack ? "Stack" : "Heap";
+      const char *lifetime = curr->is_stack    ? "Stack"
+                             : curr->in_region ? "Arena"
+                                               : "Heap";
       const char *comment_str = curr->comment ? curr->comment : "-";
 
       char hex_buf[33];
@@ -303,19 +1035,7 @@ void abyss_eye() {
                           "      │       │         │ " C_GREEN
                           "%-32.32s" C_BOLD C_RED " │\n" C_RESET,
              hex_buf);
-
-      // Print separator if not the last active item
-      AllocInfo *next_active = curr->next;
-      while (next_active && next_active->is_freed)
-        next_active = next_active->next;
-      if (next_active) {
-        printf(C_BOLD C_RED
-               "  "
-               "├───────────────────┼───────┼──────────────┼────────────┼──────"
-               "─┼─────────┼──────────────────────────────────┤\n" C_RESET);
-      }
     }
-    curr = curr->next;
   }
   printf(C_BOLD C_RED
          "  "
@@ -350,8 +1070,7 @@ void abyss_eye() {
          "├───────────────────┼───────┼──────────────┼────────────┼───────┼────"
          "───────────┼────────────────────────────┤\n" C_RESET);
 
-  curr = alloc_head;
-  if (!curr) {
+  if (alloc_count == 0) {
     printf(C_BOLD C_MAGENTA
            "  │" C_RESET C_GRAY
            "  (No allocations tracked.)                                        "
@@ -359,13 +1078,16 @@ void abyss_eye() {
            "│\n" C_RESET);
   }
 
-  while (curr) {
+  for (uint32_t i = alloc_count; i-- > 0;) {
+    AllocInfo *curr = &allocs[i];
     const char *type_name = (curr->struct_id == 0xFFFFFFFF) ? "Array"
                             : (curr->struct_id == 0xFFFFFFFE)
                                 ? "DynString"
-                                : structs[curr->struct_id].name;
+                                : IMAGE_STR(structs[curr->struct_id].name);
     const char *tag_name = curr->tag ? curr->tag : "-";
-    const char *lifetime = curr->is_stack ? "Stack" : "Heap";
+    const char *lifetime = curr->is_stack    ? "Stack"
+                           : curr->in_region ? "Arena"
+                                             : "Heap";
 
     if (curr->is_freed) {
       printf(C_BOLD C_MAGENTA
@@ -390,8 +1112,6 @@ void abyss_eye() {
              (uintptr_t)curr->ptr, curr->size, type_name, tag_name, lifetime,
              curr->alloc_ip);
     }
-
-    curr = curr->next;
   }
   printf(C_BOLD C_MAGENTA
          "  "
@@ -400,67 +1120,2538 @@ void abyss_eye() {
 #endif
 }
 
-int main(int argc, char **argv) {
-  if (argc < 2)
-    return 1;
-  FILE *f = fopen(argv[1], "rb");
-  if (!f)
-    return 1;
+// Names the live allocation at ptr (OP_TAG_ALLOC).
+static void tag_alloc(void *ptr, char *tag) {
+#ifdef ENABLE_ABYSS_EYE
+  int64_t h = live_find(ptr);
+  if (h >= 0)
+    allocs[live[h] - 1].tag = tag;
+#else
+  (void)ptr;
+  (void)tag;
+#endif
+}
 
-  char magic[8];
-  fread(magic, 1, 7, f);
-  magic[7] = 0;
-  if (strcmp(magic, MAGIC) != 0) {
-    fprintf(
-        stderr,
-        "\033[1;31m[FATAL ERROR]\033[0m %s is not an AbyssLang bytecode file "
-        "(bad magic).\n",
-        argv[1]);
-    fclose(f);
-    return 1;
+// Prints an OP_PRINT_FMT line: `%int`, `%{float}`, ... take the next value
+// from args.
+static void print_fmt(const char *fmt, const int64_t *args, int argc) {
+  int current_arg = 0;
+  for (int i = 0; fmt[i]; i++) {
+    if (fmt[i] == '%') {
+      i++;
+      if (fmt[i] == '{')
+        i++;
+      char type_buf[32];
+      int ti = 0;
+      while (fmt[i] && isalpha(fmt[i]) && ti < 31)
+        type_buf[ti++] = fmt[i++];
+      type_buf[ti] = 0;
+      if (fmt[i] != '}') // leave i on the placeholder's last character
+        i--;
+      if (current_arg < argc) {
+        int64_t val = args[current_arg];
+        if (!strcmp(type_buf, "int") || !strcmp(type_buf, "integer"))
+          out_int(val);
+        else if (!strcmp(type_buf, "float")) {
+          double f;
+          memcpy(&f, &val, 8);
+          out_float(f);
+        } else if (!strcmp(type_buf, "str") || !strcmp(type_buf, "string"))
+          out_lstr((char *)val);
+        else if (!strcmp(type_buf, "char"))
+          out_char((char)val);
+        current_arg++;
+      }
+    } else
+      out_char(fmt[i]);
   }
-  uint8_t ver;
-  fread(&ver, 1, 1, f);
-  if (ver != VERSION) {
-    fprintf(stderr,
-            "\033[1;31m[FATAL ERROR]\033[0m Bytecode version mismatch.\n");
-    fprintf(stderr, "  File %s was compiled with bytecode v%d.\n", argv[1],
-            ver);
-    fprintf(stderr,
-            "  This VM expects v%d. Recompile with the matching abyssc.\n",
-            VERSION);
-    fclose(f);
-    return 1;
+  out_char('\n');
+}
+
+// Prints an OP_PRINT_FMT_SEG line: the precompiled segments of a constant
+// format (see BcFmtSeg) spliced with args.
+static void print_segs(const BcFmtSeg *s, const int64_t *args) {
+  for (;; s++) {
+    out_mem(STR(s->lit), s->len);
+    switch (s->kind) {
+    case FMT_END:
+      out_char('\n');
+      return;
+    case FMT_INT:
+      out_int(*args);
+      break;
+    case FMT_FLOAT: {
+      double f;
+      memcpy(&f, args, 8);
+      out_float(f);
+      break;
+    }
+    case FMT_STR:
+      out_lstr((char *)*args);
+      break;
+    case FMT_CHAR:
+      out_char((char)*args);
+      break;
+    }
+    args++;
   }
+}
 
-  fread(&str_count, 4, 1, f);
-  strs = malloc(sizeof(char *) * str_count);
-  for (uint32_t i = 0; i < str_count; i++) {
-    uint32_t len;
-    fread(&len, 4, 1, f);
-    strs[i] = malloc(len + 1);
-    fread(strs[i], 1, len, f);
-    strs[i][len] = 0;
+// Runs native `nid`. Returns 1 and stores the result if it produces one.
+static int call_native(uint32_t nid, int64_t *out) {
+  if (nid == 0) { // clock
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    double t = ts.tv_sec + ts.tv_nsec / 1e9;
+    memcpy(out, &t, 8);
+    return 1;
+  } else if (nid == 1) { // input_int
+    char buf[64];
+    int64_t v = 0;
+    out_flush(); // show any prompt before blocking on stdin
+    if (fgets(buf, sizeof(buf), stdin))
+      v = atoll(buf);
+    *out = v;
+    return 1;
   }
+  return 0;
+}
 
-  fread(&struct_count, 4, 1, f);
-  structs = malloc(sizeof(StructMeta) * struct_count);
-  for (uint32_t i = 0; i < struct_count; i++) {
-    uint32_t len;
-    fread(&len, 4, 1, f);
-    structs[i].name = malloc(len + 1);
-    fread(structs[i].name, 1, len, f);
-    structs[i].name[len] = 0;
-    fread(&structs[i].size, 4, 1, f);
+// --- EXECUTION STATISTICS (abyss_vm --stats[=FILE]) ---
+// Like --prof, --stats routes every instruction through a stub
+// (L_STATS_STEP, R_L_STATS) that calls stats_step() before the real
+// handler, so runs without it dispatch exactly as before. Counts are kept
+// per code address; at exit they are summed per opcode and per function
+// and written as JSON, to stderr unless a FILE is given. Pairs and triples
+// only count opcodes that are also adjacent in the code: the sequences a
+// superinstruction could replace.
+#define N(op) [op] = #op
+static const char *const op_names[OP_COUNT] = {
+    N(OP_HALT), N(OP_CONST_INT), N(OP_CONST_FLOAT), N(OP_CONST_STR), N(OP_ADD),
+    N(OP_SUB), N(OP_MUL), N(OP_DIV), N(OP_ADD_F), N(OP_SUB_F), N(OP_MUL_F),
+    N(OP_DIV_F), N(OP_LT), N(OP_LE), N(OP_GT), N(OP_GE), N(OP_EQ), N(OP_NE),
+    N(OP_LT_F), N(OP_LE_F), N(OP_GT_F), N(OP_GE_F), N(OP_EQ_F), N(OP_NE_F),
+    N(OP_JMP), N(OP_JZ), N(OP_PRINT), N(OP_PRINT_F), N(OP_PRINT_STR),
+    N(OP_PRINT_CHAR), N(OP_GET_GLOBAL), N(OP_SET_GLOBAL), N(OP_GET_LOCAL),
+    N(OP_SET_LOCAL), N(OP_CALL), N(OP_RET), N(OP_POP), N(OP_ALLOC_STRUCT),
+    N(OP_ALLOC_ARRAY), N(OP_FREE), N(OP_GET_FIELD), N(OP_SET_FIELD),
+    N(OP_GET_INDEX), N(OP_SET_INDEX), N(OP_ABYSS_EYE), N(OP_MOD), N(OP_NEG),
+    N(OP_NEG_F), N(OP_PRINT_FMT), N(OP_TRY), N(OP_END_TRY), N(OP_THROW),
+    N(OP_NATIVE), N(OP_DUP), N(OP_ALLOC_STACK), N(OP_INC_INDEX),
+    N(OP_DEC_INDEX), N(OP_CALL_DYN_BOT), N(OP_TAG_ALLOC), N(OP_AND), N(OP_OR),
+    N(OP_NOT), N(OP_BIT_AND), N(OP_BIT_OR), N(OP_BIT_XOR), N(OP_SHL), N(OP_SHR),
+    N(OP_BIT_NOT), N(OP_STR_CAT), N(OP_I2F), N(OP_F2I), N(OP_INT_TO_STR),
+    N(OP_FLOAT_TO_STR), N(OP_SWAP), N(OP_PRINT_FMT_SEG), N(OP_ARENA_BEGIN),
+    N(OP_ARENA_END), N(OP_FREE_STR), N(OP_STR_CAT_N), N(OP_STRBUF_NEW),
+    N(OP_STRBUF_APPEND), N(OP_STRBUF_RESET), N(OP_STRBUF_STR),
+    N(OP_STRBUF_FREE), N(OP_LT_JZ), N(OP_LE_JZ), N(OP_GT_JZ), N(OP_GE_JZ),
+    N(OP_EQ_JZ), N(OP_NE_JZ), N(OP_LOCAL_CONST_LT_JZ), N(OP_LOCAL_CONST_LE_JZ),
+    N(OP_LOCAL_CONST_GT_JZ), N(OP_LOCAL_CONST_GE_JZ), N(OP_LOCAL_CONST_EQ_JZ),
+    N(OP_LOCAL_CONST_NE_JZ), N(OP_LOCAL_LOCAL_LT_JZ), N(OP_LOCAL_LOCAL_LE_JZ),
+    N(OP_LOCAL_LOCAL_GT_JZ), N(OP_LOCAL_LOCAL_GE_JZ), N(OP_LOCAL_LOCAL_EQ_JZ),
+    N(OP_LOCAL_LOCAL_NE_JZ), N(OP_INC_LOCAL), N(OP_GET_LOCAL_FIELD),
+    N(OP_GET_LOCAL2),
+};
+static const char *const rop_names[R_COUNT] = {
+    N(R_HALT), N(R_LOADI), N(R_LOADK), N(R_LOADS), N(R_MOV), N(R_GETG),
+    N(R_SETG), N(R_ADD), N(R_SUB), N(R_MUL), N(R_DIV), N(R_MOD), N(R_AND),
+    N(R_OR), N(R_BIT_AND), N(R_BIT_OR), N(R_BIT_XOR), N(R_SHL), N(R_SHR),
+    N(R_LT), N(R_LE), N(R_GT), N(R_GE), N(R_EQ), N(R_NE), N(R_ADDI), N(R_ADD_F),
+    N(R_SUB_F), N(R_MUL_F), N(R_DIV_F), N(R_LT_F), N(R_LE_F), N(R_GT_F),
+    N(R_GE_F), N(R_EQ_F), N(R_NE_F), N(R_NEG), N(R_NEG_F), N(R_NOT),
+    N(R_BIT_NOT), N(R_I2F), N(R_F2I), N(R_INT_TO_STR), N(R_FLOAT_TO_STR),
+    N(R_STR_CAT), N(R_STR_CAT_N), N(R_STRBUF_NEW), N(R_STRBUF_APPEND),
+    N(R_STRBUF_RESET), N(R_STRBUF_STR), N(R_JMP), N(R_JZ), N(R_JZ_LT),
+    N(R_JZ_LE), N(R_JZ_GT), N(R_JZ_GE), N(R_JZ_EQ), N(R_JZ_NE), N(R_JZ_LTI),
+    N(R_JZ_LEI), N(R_JZ_GTI), N(R_JZ_GEI), N(R_JZ_EQI), N(R_JZ_NEI), N(R_CALL),
+    N(R_CALL_DYN), N(R_RET), N(R_TRY), N(R_END_TRY), N(R_THROW), N(R_PRINT),
+    N(R_PRINT_F), N(R_PRINT_STR), N(R_PRINT_CHAR), N(R_PRINT_FMT),
+    N(R_PRINT_FMT_SEG), N(R_ALLOC_STRUCT), N(R_ALLOC_STACK), N(R_ALLOC_ARRAY),
+    N(R_FREE), N(R_FREE_STR), N(R_STRBUF_FREE), N(R_ARENA_BEGIN),
+    N(R_ARENA_END), N(R_GET_FIELD), N(R_SET_FIELD), N(R_GET_INDEX),
+    N(R_SET_INDEX), N(R_INC_INDEX), N(R_DEC_INDEX), N(R_SWAP), N(R_TAG_ALLOC),
+    N(R_NATIVE), N(R_ABYSS_EYE),
+};
+#undef N
+#define STATS_TRIPLES (1u << 16) // hash slots, far more than ever occur
+#define STATS_TOP 50             // pairs and triples reported
+
+static const char *stats_path; // NULL: stderr
+static int stats_reg;          // addresses are RegWord indices
+static uint32_t stats_size;    // addresses counted
+static uint64_t *stats_hits;   // address -> times run
+static uint64_t *stats_calls;  // address -> times entered by a call
+static uint8_t *stats_top;     // address -> ran as top-level code
+static uint64_t stats_pair[256][256];
+static struct {
+  uint32_t key; // a << 16 | b << 8 | c, plus 1; 0 is an empty slot
+  uint64_t count;
+} stats_triple[STATS_TRIPLES];
+static uint32_t stats_next = UINT32_MAX; // address that falls through
+static uint32_t stats_run;               // adjacent ops run so far
+static uint8_t stats_a, stats_b;         // the last two opcodes
+static size_t stats_depth;
+
+static void stats_start(int reg) {
+  stats_reg = reg;
+  stats_size = (uint32_t)(reg ? code_size / sizeof(RegWord) : code_size) + 1;
+  stats_hits = calloc(stats_size, sizeof(uint64_t));
+  stats_calls = calloc(stats_size, sizeof(uint64_t));
+  stats_top = calloc(stats_size, 1);
+}
+
+static void stats_step(uint32_t addr, uint8_t op, size_t depth) {
+  prof_pos = PROF_POS(addr, depth); // for --prof; see prof_sample()
+  stats_hits[addr]++;
+  if (!depth)
+    stats_top[addr] = 1;
+  else if (depth > stats_depth)
+    stats_calls[addr]++;
+  if (addr == stats_next) {
+    stats_pair[stats_b][op]++;
+    if (stats_run > 1) {
+      uint32_t key = ((uint32_t)stats_a << 16 | stats_b << 8 | op) + 1;
+      uint32_t h = (key * 2654435761u) >> 16;
+      while (stats_triple[h].key && stats_triple[h].key != key)
+        h = (h + 1) & (STATS_TRIPLES - 1);
+      stats_triple[h].key = key;
+      stats_triple[h].count++;
+    }
+    stats_run++;
+  } else {
+    stats_run = 1;
   }
+  stats_a = stats_b;
+  stats_b = op;
+  stats_depth = depth;
+  stats_next = addr + 1 + (stats_reg ? r_ext_words(op) : op_operand_size(op));
+}
 
-  fread(&code_size, 4, 1, f);
-  code = malloc(code_size + 16);
-  fread(code, 1, code_size, f);
-  fclose(f);
+// The function table sorted by entry address, for func_of().
+static uint32_t *func_order;
 
-  static void *dispatch_table[] = {
-      [OP_HALT] = &&L_OP_HALT,
+static int func_addr_cmp(const void *a, const void *b) {
+  uint32_t x = funcs[*(const uint32_t *)a].addr,
+           y = funcs[*(const uint32_t *)b].addr;
+  return (x > y) - (x < y);
+}
+
+// The function whose entry is the last one at or before addr, or -1.
+// Function bodies are contiguous, so that is the function addr lies in,
+// unless addr is top-level code, which callers tell apart by call depth.
+static int32_t func_of(uint32_t addr) {
+  if (!func_order) {
+    func_order = malloc((func_count + 1) * sizeof(uint32_t));
+    for (uint32_t f = 0; f < func_count; f++)
+      func_order[f] = f;
+    qsort(func_order, func_count, sizeof(uint32_t), func_addr_cmp);
+  }
+  uint32_t lo = 0, hi = func_count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (funcs[func_order[mid]].addr <= addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo ? (int32_t)func_order[lo - 1] : -1;
+}
+
+// The line table entry covering addr, or NULL.
+static const BcLine *line_of(uint32_t addr) {
+  uint32_t lo = 0, hi = line_count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (lines[mid].addr <= addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo ? &lines[lo - 1] : NULL;
+}
+
+typedef struct {
+  uint64_t count;
+  uint32_t key;
+} StatsRow;
+
+// Highest count first, then lowest key, so the output is deterministic.
+static int stats_row_cmp(const void *a, const void *b) {
+  const StatsRow *x = a, *y = b;
+  if (x->count != y->count)
+    return (x->count < y->count) - (x->count > y->count);
+  return (x->key > y->key) - (x->key < y->key);
+}
+
+static const char *stats_op_name(uint32_t op) {
+  const char *name = NULL;
+  if (stats_reg ? op < R_COUNT : op < OP_COUNT)
+    name = stats_reg ? rop_names[op] : op_names[op];
+  return name ? name : "?";
+}
+
+static int stats_allocates(uint8_t op) {
+  if (stats_reg)
+    return op == R_ALLOC_STRUCT || op == R_ALLOC_STACK ||
+           op == R_ALLOC_ARRAY || op == R_STR_CAT || op == R_STR_CAT_N ||
+           op == R_INT_TO_STR || op == R_FLOAT_TO_STR || op == R_STRBUF_NEW;
+  return op == OP_ALLOC_STRUCT || op == OP_ALLOC_STACK ||
+         op == OP_ALLOC_ARRAY || op == OP_STR_CAT || op == OP_STR_CAT_N ||
+         op == OP_INT_TO_STR || op == OP_FLOAT_TO_STR || op == OP_STRBUF_NEW;
+}
+
+// Prints rows[0..n), sorted, as a JSON array, one object per line; `what` prints
+// the fields that identify a row.
+static void stats_rows(FILE *f, const char *key, StatsRow *rows, uint32_t n,
+                       void (*what)(FILE *, uint32_t)) {
+  fprintf(f, "  \"%s\": [", key);
+  for (uint32_t i = 0; i < n; i++) {
+    fprintf(f, "%s\n    {", i ? "," : "");
+    what(f, rows[i].key);
+    fprintf(f, ", \"count\": %llu}", (unsigned long long)rows[i].count);
+  }
+  fprintf(f, "%s]", n ? "\n  " : "");
+}
+
+static void stats_op(FILE *f, uint32_t op) {
+  fprintf(f, "\"op\": \"%s\"", stats_op_name(op));
+}
+
+static void stats_pair_ops(FILE *f, uint32_t key) {
+  fprintf(f, "\"ops\": [\"%s\", \"%s\"]", stats_op_name(key >> 8),
+          stats_op_name(key & 0xFF));
+}
+
+static void stats_triple_ops(FILE *f, uint32_t key) {
+  fprintf(f, "\"ops\": [\"%s\", \"%s\", \"%s\"]",
+          stats_op_name(key >> 16), stats_op_name(key >> 8 & 0xFF),
+          stats_op_name(key & 0xFF));
+}
+
+static uint8_t stats_op_at(uint32_t addr) {
+  return stats_reg ? ((const RegWord *)code)[addr].i.op : code[addr];
+}
+
+static void stats_site(FILE *f, uint32_t addr) {
+  int32_t fn = stats_top[addr] ? -1 : func_of(addr);
+  fprintf(f, "\"addr\": %u, \"op\": \"%s\", \"function\": \"%s\"", addr,
+          stats_op_name(stats_op_at(addr)),
+          fn < 0 ? "(top level)" : IMAGE_STR(funcs[fn].name));
+  const BcLine *l = line_of(addr);
+  if (l) {
+    fprintf(f, ", \"file\": \"");
+    for (const char *c = IMAGE_STR(l->file); *c; c++)
+      fprintf(f, *c == '"' || *c == '\\' ? "\\%c" : "%c", *c);
+    fprintf(f, "\", \"line\": %u", l->line);
+  }
+}
+
+// Writes the report. Runs from cleanup and, for exit() paths, from atexit.
+static void stats_write(void) {
+  if (!stats_hits)
+    return;
+  out_flush();
+  FILE *f = stats_path ? fopen(stats_path, "w") : stderr;
+  if (!f) {
+    fprintf(stderr, "[stats] cannot write %s: %s\n", stats_path,
+            strerror(errno));
+    f = stderr;
+  }
+
+  uint64_t total = 0, top_level = 0, by_op[256] = {0};
+  uint64_t *fn_calls = calloc(func_count + 1, sizeof(uint64_t));
+  uint64_t *fn_insns = calloc(func_count + 1, sizeof(uint64_t));
+  uint32_t rows_cap = stats_size > 256 * 256 ? stats_size : 256 * 256;
+  if (rows_cap < STATS_TRIPLES)
+    rows_cap = STATS_TRIPLES;
+  StatsRow *rows = malloc(rows_cap * sizeof(StatsRow));
+  for (uint32_t addr = 0; addr < stats_size; addr++) {
+    if (!stats_hits[addr])
+      continue;
+    total += stats_hits[addr];
+    by_op[stats_op_at(addr)] += stats_hits[addr];
+    int32_t fn = stats_top[addr] ? -1 : func_of(addr);
+    if (fn < 0) {
+      top_level += stats_hits[addr];
+      continue;
+    }
+    fn_insns[fn] += stats_hits[addr];
+    fn_calls[fn] += stats_calls[addr];
+  }
+
+  fprintf(f, "{\n  \"engine\": \"%s\",\n  \"instructions\": %llu,\n",
+          stats_reg ? "register" : "stack", (unsigned long long)total);
+  fprintf(f, "  \"top_level_instructions\": %llu,\n",
+          (unsigned long long)top_level);
+
+  uint32_t n = 0;
+  for (uint32_t op = 0; op < 256; op++)
+    if (by_op[op])
+      rows[n++] = (StatsRow){by_op[op], op};
+  qsort(rows, n, sizeof(StatsRow), stats_row_cmp);
+  stats_rows(f, "opcodes", rows, n, stats_op);
+  fprintf(f, ",\n");
+
+  n = 0;
+  for (uint32_t a = 0; a < 256; a++)
+    for (uint32_t b = 0; b < 256; b++)
+      if (stats_pair[a][b])
+        rows[n++] = (StatsRow){stats_pair[a][b], a << 8 | b};
+  qsort(rows, n, sizeof(StatsRow), stats_row_cmp);
+  stats_rows(f, "pairs", rows, n < STATS_TOP ? n : STATS_TOP, stats_pair_ops);
+  fprintf(f, ",\n");
+
+  n = 0;
+  for (uint32_t h = 0; h < STATS_TRIPLES; h++)
+    if (stats_triple[h].key)
+      rows[n++] = (StatsRow){stats_triple[h].count, stats_triple[h].key - 1};
+  qsort(rows, n, sizeof(StatsRow), stats_row_cmp);
+  stats_rows(f, "triples", rows, n < STATS_TOP ? n : STATS_TOP, stats_triple_ops);
+  fprintf(f, ",\n");
+
+  // Functions, busiest first. Rows are keyed by function index.
+  n = 0;
+  for (uint32_t fn = 0; fn < func_count; fn++)
+    if (fn_insns[fn])
+      rows[n++] = (StatsRow){fn_insns[fn], fn};
+  qsort(rows, n, sizeof(StatsRow), stats_row_cmp);
+  fprintf(f, "  \"functions\": [");
+  for (uint32_t i = 0; i < n; i++) {
+    const BcFunc *fn = &funcs[rows[i].key];
+    fprintf(f,
+            "%s\n    {\"name\": \"%s\", \"addr\": %u, \"calls\": %llu, "
+            "\"instructions\": %llu}",
+            i ? "," : "", IMAGE_STR(fn->name), fn->addr,
+            (unsigned long long)fn_calls[rows[i].key],
+            (unsigned long long)rows[i].count);
+  }
+  fprintf(f, "%s],\n", n ? "\n  " : "");
+
+  n = 0;
+  for (uint32_t addr = 0; addr < stats_size; addr++)
+    if (stats_hits[addr] && stats_allocates(stats_op_at(addr)))
+      rows[n++] = (StatsRow){stats_hits[addr], addr};
+  qsort(rows, n, sizeof(StatsRow), stats_row_cmp);
+  stats_rows(f, "alloc_sites", rows, n, stats_site);
+  fprintf(f, "\n}\n");
+
+  if (f != stderr)
+    fclose(f);
+  free(rows);
+  free(fn_calls);
+  free(fn_insns);
+  free(stats_hits);
+  free(stats_calls);
+  free(stats_top);
+  stats_hits = NULL;
+}
+
+// verify_register() checks register bytecode once at load, like the first
+// pass of verify() (below) over stack bytecode: unknown opcodes, truncated
+// instructions, jump, try and call targets that do not start an instruction,
+// and table indices out of range. There is no depth analysis: a register is
+// a 16-bit frame slot and every call makes room for all of them, so only
+// operand ranges that reach past the frame need checking. Interface call targets are known only at run
+// time; R_CALL_DYN checks them against r_entry.
+static uint8_t *r_entry; // RegWord index -> 1 if a function starts there
+
+static void verify_register(void) {
+  if (code_size % sizeof(RegWord))
+    fatal_bad_code("code size", 0, (uint32_t)code_size);
+  const RegWord *prog = (const RegWord *)code;
+  uint32_t n = (uint32_t)(code_size / sizeof(RegWord));
+  uint8_t *is_insn = calloc(n + 1, 1);
+  for (uint32_t p = 0; p < n; p += 1 + r_ext_words(prog[p].i.op)) {
+    if (prog[p].i.op >= R_COUNT)
+      fatal_bad_code("unknown opcode", p, prog[p].i.op);
+    if (p + 1 + r_ext_words(prog[p].i.op) > n)
+      fatal_bad_code("truncated opcode", p, prog[p].i.op);
+    is_insn[p] = 1;
+  }
+
+  r_entry = calloc(n + 1, 1);
+  for (uint32_t f = 0; f < func_count; f++) {
+    if (funcs[f].addr >= n || !is_insn[funcs[f].addr])
+      fatal_bad_code("function entry", 0, funcs[f].addr);
+    r_entry[funcs[f].addr] = 1;
+  }
+
+  for (uint32_t p = 0; p < n; p += 1 + r_ext_words(prog[p].i.op)) {
+    const RegInsn *in = &prog[p].i;
+    uint32_t target = UINT32_MAX, regs = 0; // registers used from a on
+    switch (in->op) {
+    case R_JMP:
+    case R_JZ:
+    case R_TRY:
+      target = in->tgt;
+      break;
+    case R_CALL:
+      target = in->tgt;
+      regs = in->n;
+      break;
+    case R_CALL_DYN:
+    case R_PRINT_FMT:
+      regs = in->n + 1;
+      break;
+    case R_RET:
+      regs = in->n;
+      break;
+    case R_GETG:
+    case R_SETG:
+      if (in->b >= sizeof(globals) / sizeof(globals[0]))
+        fatal_bad_code("global index", p, in->b);
+      break;
+    case R_LOADS:
+    case R_TAG_ALLOC:
+      if ((uint32_t)in->imm >= str_count)
+        fatal_bad_code("string index", p, (uint32_t)in->imm);
+      break;
+    case R_ALLOC_STRUCT:
+    case R_ALLOC_STACK:
+      if (prog[p + 1].u32[0] >= struct_count)
+        fatal_bad_code("struct id", p, prog[p + 1].u32[0]);
+      // fall through
+    case R_ALLOC_ARRAY: {
+      uint32_t cidx = prog[p + 1].u32[1];
+      if (cidx != 0xFFFFFFFF && cidx >= str_count)
+        fatal_bad_code("string index", p, cidx);
+      break;
+    }
+    case R_PRINT_FMT_SEG: {
+      uint32_t first = (uint32_t)in->imm, used = 0;
+      if (first >= fmt_count)
+        fatal_bad_code("format index", p, first);
+      for (const BcFmtSeg *s = fmts + first; s->kind != FMT_END; s++)
+        used++;
+      if (used > in->n)
+        fatal_bad_code("format argument count", p, in->n);
+      regs = in->n;
+      break;
+    }
+    case R_STRBUF_APPEND:
+      if (in->n > CAT_CHAR)
+        fatal_bad_code("append kind", p, in->n);
+      break;
+    case R_STR_CAT_N:
+      if (in->n == 0 || in->n > CAT_MAX)
+        fatal_bad_code("concat part count", p, in->n);
+      for (int i = 0; i < in->n; i++)
+        if (((uint32_t)in->imm >> 2 * i & 3) > CAT_FLOAT)
+          fatal_bad_code("concat part kind", p, (uint32_t)in->imm);
+      regs = in->n;
+      break;
+    default:
+      if (in->op >= R_JZ_LT && in->op <= R_JZ_NEI)
+        target = prog[p + 1].u32[0];
+      break;
+    }
+    if (target != UINT32_MAX && (target >= n || !is_insn[target]))
+      fatal_bad_code("jump target", p, target);
+    if ((uint32_t)in->a + regs > 65536)
+      fatal_bad_code("register count", p, regs);
+  }
+  free(is_insn);
+}
+
+// --- REGISTER ENGINE ---
+// Runs register bytecode (BC_FLAG_REGISTER, see common.h). Registers are the
+// frame slots stack[fp + n], so the call stack, exception stack and Abyss Eye
+// bookkeeping are shared with the stack engine below; only sp goes unused.
+// Code addresses are RegWord indices. The global ip is synced before anything
+// that records it (allocations, frees, stack-alloc cleanup).
+static void run_register(void) {
+  const RegWord *prog = (const RegWord *)code;
+  const RegWord *pc = prog;
+  int64_t *R = stack + fp;
+  uint32_t target;
+
+  static void *rdispatch[R_COUNT] = {
+      [R_HALT] = &&R_L_HALT,
+      [R_LOADI] = &&R_L_LOADI,
+      [R_LOADK] = &&R_L_LOADK,
+      [R_LOADS] = &&R_L_LOADS,
+      [R_MOV] = &&R_L_MOV,
+      [R_GETG] = &&R_L_GETG,
+      [R_SETG] = &&R_L_SETG,
+      [R_ADD] = &&R_L_ADD,
+      [R_SUB] = &&R_L_SUB,
+      [R_MUL] = &&R_L_MUL,
+      [R_DIV] = &&R_L_DIV,
+      [R_MOD] = &&R_L_MOD,
+      [R_AND] = &&R_L_AND,
+      [R_OR] = &&R_L_OR,
+      [R_BIT_AND] = &&R_L_BIT_AND,
+      [R_BIT_OR] = &&R_L_BIT_OR,
+      [R_BIT_XOR] = &&R_L_BIT_XOR,
+      [R_SHL] = &&R_L_SHL,
+      [R_SHR] = &&R_L_SHR,
+      [R_LT] = &&R_L_LT,
+      [R_LE] = &&R_L_LE,
+      [R_GT] = &&R_L_GT,
+      [R_GE] = &&R_L_GE,
+      [R_EQ] = &&R_L_EQ,
+      [R_NE] = &&R_L_NE,
+      [R_ADDI] = &&R_L_ADDI,
+      [R_ADD_F] = &&R_L_ADD_F,
+      [R_SUB_F] = &&R_L_SUB_F,
+      [R_MUL_F] = &&R_L_MUL_F,
+      [R_DIV_F] = &&R_L_DIV_F,
+      [R_LT_F] = &&R_L_LT_F,
+      [R_LE_F] = &&R_L_LE_F,
+      [R_GT_F] = &&R_L_GT_F,
+      [R_GE_F] = &&R_L_GE_F,
+      [R_EQ_F] = &&R_L_EQ_F,
+      [R_NE_F] = &&R_L_NE_F,
+      [R_NEG] = &&R_L_NEG,
+      [R_NEG_F] = &&R_L_NEG_F,
+      [R_NOT] = &&R_L_NOT,
+      [R_BIT_NOT] = &&R_L_BIT_NOT,
+      [R_I2F] = &&R_L_I2F,
+      [R_F2I] = &&R_L_F2I,
+      [R_INT_TO_STR] = &&R_L_INT_TO_STR,
+      [R_FLOAT_TO_STR] = &&R_L_FLOAT_TO_STR,
+      [R_STR_CAT] = &&R_L_STR_CAT,
+      [R_STR_CAT_N] = &&R_L_STR_CAT_N,
+      [R_STRBUF_NEW] = &&R_L_STRBUF_NEW,
+      [R_STRBUF_APPEND] = &&R_L_STRBUF_APPEND,
+      [R_STRBUF_RESET] = &&R_L_STRBUF_RESET,
+      [R_STRBUF_STR] = &&R_L_STRBUF_STR,
+      [R_JMP] = &&R_L_JMP,
+      [R_JZ] = &&R_L_JZ,
+      [R_JZ_LT] = &&R_L_JZ_LT,
+      [R_JZ_LE] = &&R_L_JZ_LE,
+      [R_JZ_GT] = &&R_L_JZ_GT,
+      [R_JZ_GE] = &&R_L_JZ_GE,
+      [R_JZ_EQ] = &&R_L_JZ_EQ,
+      [R_JZ_NE] = &&R_L_JZ_NE,
+      [R_JZ_LTI] = &&R_L_JZ_LTI,
+      [R_JZ_LEI] = &&R_L_JZ_LEI,
+      [R_JZ_GTI] = &&R_L_JZ_GTI,
+      [R_JZ_GEI] = &&R_L_JZ_GEI,
+      [R_JZ_EQI] = &&R_L_JZ_EQI,
+      [R_JZ_NEI] = &&R_L_JZ_NEI,
+      [R_CALL] = &&R_L_CALL,
+      [R_CALL_DYN] = &&R_L_CALL_DYN,
+      [R_RET] = &&R_L_RET,
+      [R_TRY] = &&R_L_TRY,
+      [R_END_TRY] = &&R_L_END_TRY,
+      [R_THROW] = &&R_L_THROW,
+      [R_PRINT] = &&R_L_PRINT,
+      [R_PRINT_F] = &&R_L_PRINT_F,
+      [R_PRINT_STR] = &&R_L_PRINT_STR,
+      [R_PRINT_CHAR] = &&R_L_PRINT_CHAR,
+      [R_PRINT_FMT] = &&R_L_PRINT_FMT,
+      [R_PRINT_FMT_SEG] = &&R_L_PRINT_FMT_SEG,
+      [R_ALLOC_STRUCT] = &&R_L_ALLOC_STRUCT,
+      [R_ALLOC_STACK] = &&R_L_ALLOC_STACK,
+      [R_ALLOC_ARRAY] = &&R_L_ALLOC_ARRAY,
+      [R_FREE] = &&R_L_FREE,
+      [R_FREE_STR] = &&R_L_FREE_STR,
+      [R_STRBUF_FREE] = &&R_L_STRBUF_FREE,
+      [R_ARENA_BEGIN] = &&R_L_ARENA_BEGIN,
+      [R_ARENA_END] = &&R_L_ARENA_END,
+      [R_GET_FIELD] = &&R_L_GET_FIELD,
+      [R_SET_FIELD] = &&R_L_SET_FIELD,
+      [R_GET_INDEX] = &&R_L_GET_INDEX,
+      [R_SET_INDEX] = &&R_L_SET_INDEX,
+      [R_INC_INDEX] = &&R_L_INC_INDEX,
+      [R_DEC_INDEX] = &&R_L_DEC_INDEX,
+      [R_SWAP] = &&R_L_SWAP,
+      [R_TAG_ALLOC] = &&R_L_TAG_ALLOC,
+      [R_NATIVE] = &&R_L_NATIVE,
+      [R_ABYSS_EYE] = &&R_L_ABYSS_EYE,
+  };
+
+#ifdef ABYSS_COUNT_DISPATCH
+#define RDISPATCH()                                                            \
+  do {                                                                         \
+    dispatch_count++;                                                          \
+    goto *rdispatch[pc->i.op];                                                 \
+  } while (0)
+#else
+#define RDISPATCH() goto *rdispatch[pc->i.op]
+#endif
+#define A (pc->i.a)
+#define B (pc->i.b)
+#define C (pc->i.c)
+#define SYNC_IP() (ip = (size_t)(pc - prog))
+
+  // While profiling (--prof) every opcode dispatches to R_L_PROF, which
+  // publishes the address for prof_sample() and runs the real handler.
+  // --stats uses R_L_STATS, which also counts.
+  static void *rstub_h[R_COUNT];
+  if (stats_hits || prof_log) {
+    memcpy(rstub_h, rdispatch, sizeof(rdispatch));
+    for (int op = 0; op < R_COUNT; op++)
+      rdispatch[op] = stats_hits ? &&R_L_STATS : &&R_L_PROF;
+  }
+
+  RDISPATCH();
+
+R_L_PROF:
+  prof_pos = PROF_POS(pc - prog, csp);
+  goto *rstub_h[pc->i.op];
+R_L_STATS:
+  stats_step((uint32_t)(pc - prog), pc->i.op, csp);
+  goto *rstub_h[pc->i.op];
+
+R_L_HALT:
+  return;
+R_L_LOADI:
+  R[A] = pc->i.imm;
+  pc++;
+  RDISPATCH();
+R_L_LOADK:
+  R[A] = pc[1].k;
+  pc += 2;
+  RDISPATCH();
+R_L_LOADS:
+  R[A] = (int64_t)STR(pc->i.imm);
+  pc++;
+  RDISPATCH();
+R_L_MOV:
+  R[A] = R[B];
+  pc++;
+  RDISPATCH();
+R_L_GETG:
+  R[A] = globals[B];
+  pc++;
+  RDISPATCH();
+R_L_SETG:
+  globals[B] = R[A];
+  pc++;
+  RDISPATCH();
+
+#define RBIN(name, expr)                                                       \
+  name : {                                                                     \
+    int64_t x = R[B], y = R[C];                                                \
+    R[A] = (expr);                                                             \
+    pc++;                                                                      \
+    RDISPATCH();                                                               \
+  }
+#define RBIN_F(name, type, expr)                                               \
+  name : {                                                                     \
+    double x, y;                                                               \
+    memcpy(&x, &R[B], 8);                                                      \
+    memcpy(&y, &R[C], 8);                                                      \
+    type r = (expr);                                                           \
+    if (sizeof(type) == 8)                                                     \
+      memcpy(&R[A], &r, 8);                                                    \
+    else                                                                       \
+      R[A] = r;                                                                \
+    pc++;                                                                      \
+    RDISPATCH();                                                               \
+  }
+
+  RBIN(R_L_ADD, x + y)
+  RBIN(R_L_SUB, x - y)
+  RBIN(R_L_MUL, x * y)
+  RBIN(R_L_DIV, x / y)
+  RBIN(R_L_MOD, x % y)
+  RBIN(R_L_AND, x && y)
+  RBIN(R_L_OR, x || y)
+  RBIN(R_L_BIT_AND, x & y)
+  RBIN(R_L_BIT_OR, x | y)
+  RBIN(R_L_BIT_XOR, x ^ y)
+  RBIN(R_L_SHL, x << y)
+  RBIN(R_L_SHR, x >> y)
+  RBIN(R_L_LT, x < y)
+  RBIN(R_L_LE, x <= y)
+  RBIN(R_L_GT, x > y)
+  RBIN(R_L_GE, x >= y)
+  RBIN(R_L_EQ, x == y)
+  RBIN(R_L_NE, x != y)
+  RBIN_F(R_L_ADD_F, double, x + y)
+  RBIN_F(R_L_SUB_F, double, x - y)
+  RBIN_F(R_L_MUL_F, double, x * y)
+  RBIN_F(R_L_DIV_F, double, x / y)
+  RBIN_F(R_L_LT_F, int, x < y)
+  RBIN_F(R_L_LE_F, int, x <= y)
+  RBIN_F(R_L_GT_F, int, x > y)
+  RBIN_F(R_L_GE_F, int, x >= y)
+  RBIN_F(R_L_EQ_F, int, x == y)
+  RBIN_F(R_L_NE_F, int, x != y)
+#undef RBIN
+#undef RBIN_F
+
+R_L_ADDI:
+  R[A] = R[B] + (int16_t)C;
+  pc++;
+  RDISPATCH();
+R_L_NEG:
+  R[A] = -R[B];
+  pc++;
+  RDISPATCH();
+R_L_NEG_F: {
+  double f;
+  memcpy(&f, &R[B], 8);
+  f = -f;
+  memcpy(&R[A], &f, 8);
+  pc++;
+  RDISPATCH();
+}
+R_L_NOT:
+  R[A] = !R[B];
+  pc++;
+  RDISPATCH();
+R_L_BIT_NOT:
+  R[A] = ~R[B];
+  pc++;
+  RDISPATCH();
+R_L_I2F: {
+  double f = (double)R[B];
+  memcpy(&R[A], &f, 8);
+  pc++;
+  RDISPATCH();
+}
+R_L_F2I: {
+  double f;
+  memcpy(&f, &R[B], 8);
+  R[A] = (int64_t)f;
+  pc++;
+  RDISPATCH();
+}
+R_L_INT_TO_STR: {
+  char buf[32];
+  int n = snprintf(buf, sizeof(buf), "%ld", (long)R[B]);
+  char *s = str_alloc(n);
+  memcpy(s, buf, n);
+  SYNC_IP();
+  track_alloc(s, 0xFFFFFFFE, n + 1, 0, "int->str");
+  R[A] = (int64_t)s;
+  pc++;
+  RDISPATCH();
+}
+R_L_FLOAT_TO_STR: {
+  double f;
+  memcpy(&f, &R[B], 8);
+  char buf[64];
+  int n = snprintf(buf, sizeof(buf), "%.6f", f);
+  char *s = str_alloc(n);
+  memcpy(s, buf, n);
+  SYNC_IP();
+  track_alloc(s, 0xFFFFFFFE, n + 1, 0, "float->str");
+  R[A] = (int64_t)s;
+  pc++;
+  RDISPATCH();
+}
+R_L_STR_CAT: {
+  char *s1 = (char *)R[B];
+  char *s2 = (char *)R[C];
+  uint32_t len1 = str_len(s1);
+  uint32_t len2 = str_len(s2);
+  char *new_str = str_alloc((size_t)len1 + len2);
+  memcpy(new_str, s1, len1);
+  memcpy(new_str + len1, s2, len2);
+  SYNC_IP();
+  track_alloc(new_str, 0xFFFFFFFE, len1 + len2 + 1, 0, "Dynamic String Concat");
+  R[A] = (int64_t)new_str;
+  pc++;
+  RDISPATCH();
+}
+R_L_STR_CAT_N:
+  SYNC_IP();
+  R[A] = (int64_t)str_cat_n(&R[A], pc->i.n, (uint32_t)pc->i.imm);
+  pc++;
+  RDISPATCH();
+R_L_STRBUF_NEW:
+  R[A] = (int64_t)calloc(1, sizeof(StrBuf));
+  pc++;
+  RDISPATCH();
+R_L_STRBUF_APPEND:
+  SYNC_IP();
+  strbuf_append((StrBuf *)R[A], pc->i.n, R[B]);
+  pc++;
+  RDISPATCH();
+R_L_STRBUF_RESET:
+  ((StrBuf *)R[A])->len = 0;
+  pc++;
+  RDISPATCH();
+R_L_STRBUF_STR:
+  SYNC_IP();
+  R[A] = (int64_t)strbuf_str((StrBuf *)R[B]);
+  pc++;
+  RDISPATCH();
+
+R_L_JMP:
+  pc = prog + pc->i.tgt;
+  RDISPATCH();
+R_L_JZ:
+  pc = R[A] ? pc + 1 : prog + pc->i.tgt;
+  RDISPATCH();
+
+#define RJZ(name, cmp)                                                         \
+  name:                                                                        \
+  pc = (R[A] cmp R[B]) ? pc + 2 : prog + pc[1].u32[0];                         \
+  RDISPATCH();
+#define RJZ_I(name, cmp)                                                       \
+  name:                                                                        \
+  pc = (R[A] cmp pc->i.imm) ? pc + 2 : prog + pc[1].u32[0];                    \
+  RDISPATCH();
+
+  RJZ(R_L_JZ_LT, <)
+  RJZ(R_L_JZ_LE, <=)
+  RJZ(R_L_JZ_GT, >)
+  RJZ(R_L_JZ_GE, >=)
+  RJZ(R_L_JZ_EQ, ==)
+  RJZ(R_L_JZ_NE, !=)
+  RJZ_I(R_L_JZ_LTI, <)
+  RJZ_I(R_L_JZ_LEI, <=)
+  RJZ_I(R_L_JZ_GTI, >)
+  RJZ_I(R_L_JZ_GEI, >=)
+  RJZ_I(R_L_JZ_EQI, ==)
+  RJZ_I(R_L_JZ_NEI, !=)
+#undef RJZ
+#undef RJZ_I
+
+R_L_CALL_DYN:
+  // Target below the arguments; shift them down so the frame starts at A.
+  target = (uint32_t)R[A];
+  if (__builtin_expect((uint64_t)R[A] >= code_size / sizeof(RegWord) ||
+                           !r_entry[target],
+                       0))
+    fatal_bad_code("interface call target", (size_t)(pc - prog), target);
+  memmove(&R[A], &R[A + 1], pc->i.n * sizeof(int64_t));
+  goto r_call;
+R_L_CALL:
+  target = pc->i.tgt;
+r_call:
+  if (__builtin_expect(csp >= CALL_STACK_SIZE, 0))
+    fatal_call_overflow();
+  // A frame can address 65536 registers; make sure all of them exist.
+  if (__builtin_expect(fp + A + 65536 > STACK_SIZE, 0))
+    fatal_stack_overflow();
+  call_stack[csp] = (Frame){(size_t)(pc + 1 - prog), fp, arena_top};
+  csp++;
+  fp += A;
+  R = stack + fp;
+  pc = prog + target;
+  RDISPATCH();
+R_L_RET: {
+  memmove(R, &R[A], pc->i.n * sizeof(int64_t));
+  if (csp == 0)
+    return;
+  csp--;
+  drop_handlers();
+  SYNC_IP();
+  arena_release(call_stack[csp].arena_mark);
+  pc = prog + call_stack[csp].ret_addr;
+  fp = call_stack[csp].old_fp;
+  R = stack + fp;
+  RDISPATCH();
+}
+
+R_L_TRY:
+  if (__builtin_expect(esp >= EXCEPTION_STACK_SIZE, 0)) {
+    SYNC_IP();
+    fatal_handler_overflow();
+  }
+  exception_stack[esp++] =
+      (ExceptionFrame){pc->i.tgt, fp + A, fp, csp, region_depth};
+  pc++;
+  RDISPATCH();
+R_L_END_TRY:
+  if (esp > 0)
+    esp--;
+  pc++;
+  RDISPATCH();
+R_L_THROW: {
+  int64_t err_val = R[A];
+  if (esp == 0) {
+    fprintf(stderr, "Uncaught Exception: %s\n", (char *)err_val);
+    exit(1);
+  }
+  esp--;
+  SYNC_IP();
+  if (csp > exception_stack[esp].old_csp)
+    arena_release(call_stack[exception_stack[esp].old_csp].arena_mark);
+  if (region_depth > exception_stack[esp].old_regions)
+    region_release(exception_stack[esp].old_regions);
+  pc = prog + exception_stack[esp].catch_addr;
+  stack[exception_stack[esp].old_sp] = err_val;
+  fp = exception_stack[esp].old_fp;
+  csp = exception_stack[esp].old_csp;
+  R = stack + fp;
+  RDISPATCH();
+}
+
+R_L_PRINT:
+  out_int(R[A]);
+  out_char('\n');
+  pc++;
+  RDISPATCH();
+R_L_PRINT_F: {
+  double v;
+  memcpy(&v, &R[A], 8);
+  out_float(v);
+  out_char('\n');
+  pc++;
+  RDISPATCH();
+}
+R_L_PRINT_STR:
+  out_lstr((char *)R[A]);
+  out_char('\n');
+  pc++;
+  RDISPATCH();
+R_L_PRINT_CHAR:
+  out_char((char)R[A]);
+  pc++;
+  RDISPATCH();
+R_L_PRINT_FMT:
+  print_fmt((char *)R[A], &R[A + 1], pc->i.n);
+  pc++;
+  RDISPATCH();
+R_L_PRINT_FMT_SEG:
+  print_segs(fmts + pc->i.imm, &R[A]);
+  pc++;
+  RDISPATCH();
+
+R_L_ALLOC_STRUCT:
+R_L_ALLOC_STACK: {
+  uint32_t sid = pc[1].u32[0], cidx = pc[1].u32[1];
+  char *comment = (cidx == 0xFFFFFFFF) ? NULL : STR(cidx);
+  uint32_t size = structs[sid].size * 8;
+  int is_stack = pc->i.op == R_ALLOC_STACK;
+  int64_t *ptr = is_stack ? arena_alloc(size) : heap_alloc(size);
+  SYNC_IP();
+  track_alloc(ptr, sid, size, is_stack, comment);
+  R[A] = (int64_t)ptr;
+  pc += 2;
+  RDISPATCH();
+}
+R_L_ALLOC_ARRAY: {
+  uint32_t cidx = pc[1].u32[1];
+  char *comment = (cidx == 0xFFFFFFFF) ? NULL : STR(cidx);
+  uint32_t total_size = R[B] * 8;
+  int64_t *ptr = heap_alloc(total_size);
+  SYNC_IP();
+  track_alloc(ptr, 0xFFFFFFFF, total_size, 0, comment);
+  R[A] = (int64_t)ptr;
+  pc += 2;
+  RDISPATCH();
+}
+R_L_FREE: {
+  int64_t *ptr = (int64_t *)R[A];
+  SYNC_IP();
+  free_alloc(ptr);
+  pc++;
+  RDISPATCH();
+}
+R_L_FREE_STR:
+  SYNC_IP();
+  free_str((char *)R[A]);
+  pc++;
+  RDISPATCH();
+R_L_STRBUF_FREE:
+  SYNC_IP();
+  strbuf_free((StrBuf *)R[A]);
+  pc++;
+  RDISPATCH();
+R_L_ARENA_BEGIN:
+  SYNC_IP();
+  region_begin();
+  pc++;
+  RDISPATCH();
+R_L_ARENA_END:
+  SYNC_IP();
+  if (region_depth > 0)
+    region_release(region_depth - 1);
+  pc++;
+  RDISPATCH();
+R_L_GET_FIELD:
+  R[A] = ((int64_t *)R[B])[C];
+  pc++;
+  RDISPATCH();
+R_L_SET_FIELD:
+  ((int64_t *)R[A])[C] = R[B];
+  pc++;
+  RDISPATCH();
+R_L_GET_INDEX:
+  R[A] = ((int64_t *)R[B])[R[C]];
+  pc++;
+  RDISPATCH();
+R_L_SET_INDEX:
+  ((int64_t *)R[A])[R[B]] = R[C];
+  pc++;
+  RDISPATCH();
+R_L_INC_INDEX:
+  ((int64_t *)R[A])[R[B]]++;
+  pc++;
+  RDISPATCH();
+R_L_DEC_INDEX:
+  ((int64_t *)R[A])[R[B]]--;
+  pc++;
+  RDISPATCH();
+R_L_SWAP: {
+  int64_t tmp = R[A];
+  R[A] = R[B];
+  R[B] = tmp;
+  pc++;
+  RDISPATCH();
+}
+R_L_TAG_ALLOC:
+  tag_alloc((void *)R[A], STR(pc->i.imm));
+  pc++;
+  RDISPATCH();
+R_L_NATIVE:
+  call_native((uint32_t)pc->i.imm, &R[A]);
+  pc++;
+  RDISPATCH();
+R_L_ABYSS_EYE:
+  abyss_eye();
+  pc++;
+  RDISPATCH();
+
+#undef A
+#undef B
+#undef C
+#undef SYNC_IP
+#undef RDISPATCH
+}
+
+// --- LOAD-TIME VERIFIER ---
+// verify() runs once over stack bytecode, before predecode(). Malformed code
+// is rejected outright: unknown opcodes, truncated instructions, jump, try
+// and call targets that do not start an instruction, and string, struct and
+// function table entries out of range. It then follows every path from the
+// program start, each function entry and each catch handler, tracking the
+// stack depth relative to fp. If all paths agree, the deepest point of each
+// function is its frame need: OP_CALL checks the callee's need once and the
+// engine pushes without a per-instruction overflow check. Otherwise the
+// program is still safe to run, but with the guarded push handlers.
+static int32_t *func_at;     // byte offset -> function table index, or -1
+static uint32_t *frame_need; // function table index -> slots above fp
+static int verified;
+
+static int32_t rd32(const uint8_t *p) {
+  int32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+// Offset of the code address among op's operands, or -1 if it has none.
+static int target_operand(uint8_t op) {
+  switch (op) {
+  case OP_JMP:
+  case OP_JZ:
+  case OP_TRY:
+  case OP_CALL:
+  case OP_LT_JZ:
+  case OP_LE_JZ:
+  case OP_GT_JZ:
+  case OP_GE_JZ:
+  case OP_EQ_JZ:
+  case OP_NE_JZ:
+    return 0;
+  default:
+    if (op >= OP_LOCAL_CONST_LT_JZ && op <= OP_LOCAL_CONST_NE_JZ)
+      return 5;
+    if (op >= OP_LOCAL_LOCAL_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ)
+      return 2;
+    return -1;
+  }
+}
+
+// Depth after the instruction at p, or -1 if control does not fall through.
+// Returns -2 when the depth cannot be tracked. *td receives the depth at the
+// branch target of branching opcodes.
+static int64_t v_effect(size_t p, int64_t d, int64_t *td) {
+  uint8_t op = code[p];
+  const uint8_t *o = code + p + 1;
+  int64_t pops = 0, pushes = 0;
+  switch (op) {
+  case OP_CONST_INT:
+  case OP_CONST_FLOAT:
+  case OP_CONST_STR:
+  case OP_GET_GLOBAL:
+  case OP_GET_LOCAL:
+  case OP_ALLOC_STRUCT:
+  case OP_ALLOC_STACK:
+  case OP_DUP:
+  case OP_GET_LOCAL_FIELD:
+    pushes = 1;
+    break;
+  case OP_GET_LOCAL2:
+    pushes = 2;
+    break;
+  case OP_NEG:
+  case OP_NEG_F:
+  case OP_NOT:
+  case OP_BIT_NOT:
+  case OP_I2F:
+  case OP_F2I:
+  case OP_INT_TO_STR:
+  case OP_FLOAT_TO_STR:
+  case OP_ALLOC_ARRAY:
+  case OP_GET_FIELD:
+  case OP_TAG_ALLOC:
+    pops = pushes = 1;
+    break;
+  case OP_SWAP:
+    pops = pushes = 2;
+    break;
+  case OP_JZ:
+  case OP_PRINT:
+  case OP_PRINT_F:
+  case OP_PRINT_STR:
+  case OP_PRINT_CHAR:
+  case OP_SET_GLOBAL:
+  case OP_SET_LOCAL:
+  case OP_POP:
+  case OP_FREE:
+  case OP_FREE_STR:
+  case OP_THROW:
+    pops = 1;
+    break;
+  case OP_SET_FIELD:
+  case OP_INC_INDEX:
+  case OP_DEC_INDEX:
+    pops = 2;
+    break;
+  case OP_SET_INDEX:
+    pops = 3;
+    break;
+  case OP_PRINT_FMT:
+    pops = o[0] + 1;
+    break;
+  case OP_PRINT_FMT_SEG:
+    pops = o[4];
+    break;
+  case OP_STR_CAT_N:
+    pops = o[0];
+    pushes = 1;
+    break;
+  case OP_STRBUF_NEW:
+    pushes = 1;
+    break;
+  case OP_STRBUF_APPEND:
+    pops = 2;
+    break;
+  case OP_STRBUF_RESET:
+  case OP_STRBUF_FREE:
+    pops = 1;
+    break;
+  case OP_STRBUF_STR:
+    pops = pushes = 1;
+    break;
+  case OP_CALL: {
+    int32_t f = func_at[(uint32_t)rd32(o)];
+    if (f < 0 || funcs[f].argc != o[4])
+      return -2;
+    pops = o[4];
+    pushes = funcs[f].rets;
+    break;
+  }
+  case OP_CALL_DYN_BOT:
+    pops = o[0] + 1;
+    pushes = o[1];
+    break;
+  case OP_NATIVE:
+    pushes = (uint32_t)rd32(o) <= 1; // clock, input_int
+    break;
+  case OP_RET:
+    pops = o[0];
+    break;
+  case OP_TRY:
+    *td = d + 1; // the catch handler starts with the error pushed
+    break;
+  case OP_JMP:
+    *td = d;
+    break;
+  case OP_INC_LOCAL:
+  case OP_END_TRY:
+  case OP_ARENA_BEGIN:
+  case OP_ARENA_END:
+  case OP_ABYSS_EYE:
+  case OP_HALT:
+    break;
+  default:
+    if (op >= OP_LT_JZ && op <= OP_NE_JZ)
+      pops = 2;
+    else if (op >= OP_LOCAL_CONST_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ)
+      pops = 0;
+    else
+      pops = 2, pushes = 1; // binary operators
+    break;
+  }
+  if (d < pops)
+    return -2;
+  if (op == OP_JZ || (op >= OP_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ))
+    *td = d - pops;
+  if (op == OP_JMP || op == OP_RET || op == OP_THROW || op == OP_HALT)
+    return -1;
+  return d - pops + pushes;
+}
+
+// Records depth d (in function f) in front of the instruction at p. Returns
+// 0 if another path got there with a different depth or from another
+// function.
+static int v_reach(int64_t *depth, int32_t *owner, size_t *work, size_t *wn,
+                   size_t p, int64_t d, int32_t f) {
+  if (d > STACK_SIZE)
+    return 0;
+  if (depth[p] < 0) {
+    depth[p] = d;
+    owner[p] = f;
+    work[(*wn)++] = p;
+    return 1;
+  }
+  return depth[p] == d && owner[p] == f;
+}
+
+static void verify(void) {
+  uint8_t *is_insn = calloc(code_size + 1, 1);
+  for (size_t p = 0; p < code_size; p += 1 + op_operand_size(code[p])) {
+    if (code[p] >= OP_COUNT)
+      fatal_bad_code("unknown opcode", p, code[p]);
+    if (p + 1 + op_operand_size(code[p]) > code_size)
+      fatal_bad_code("truncated opcode", p, code[p]);
+    is_insn[p] = 1;
+  }
+
+  func_at = malloc((code_size + 1) * sizeof(int32_t));
+  for (size_t p = 0; p <= code_size; p++)
+    func_at[p] = -1;
+  for (uint32_t f = 0; f < func_count; f++) {
+    if (funcs[f].addr >= code_size || !is_insn[funcs[f].addr])
+      fatal_bad_code("function entry", 0, funcs[f].addr);
+    func_at[funcs[f].addr] = (int32_t)f;
+  }
+
+  for (size_t p = 0; p < code_size; p += 1 + op_operand_size(code[p])) {
+    uint8_t op = code[p];
+    const uint8_t *o = code + p + 1;
+    int to = target_operand(op);
+    if (to >= 0 && ((uint32_t)rd32(o + to) >= code_size ||
+                    !is_insn[(uint32_t)rd32(o + to)]))
+      fatal_bad_code("jump target", p, (uint32_t)rd32(o + to));
+    switch (op) {
+    case OP_CONST_STR:
+    case OP_TAG_ALLOC:
+      if ((uint32_t)rd32(o) >= str_count)
+        fatal_bad_code("string index", p, (uint32_t)rd32(o));
+      break;
+    case OP_ALLOC_STRUCT:
+    case OP_ALLOC_STACK:
+      if ((uint32_t)rd32(o) >= struct_count)
+        fatal_bad_code("struct id", p, (uint32_t)rd32(o));
+      // fall through
+    case OP_ALLOC_ARRAY: {
+      uint32_t cidx = (uint32_t)rd32(o + 4);
+      if (cidx != 0xFFFFFFFF && cidx >= str_count)
+        fatal_bad_code("string index", p, cidx);
+      break;
+    }
+    case OP_PRINT_FMT_SEG: {
+      // Every format ends in FMT_END (checked at load); count the arguments
+      // it takes.
+      uint32_t first = (uint32_t)rd32(o), used = 0;
+      if (first >= fmt_count)
+        fatal_bad_code("format index", p, first);
+      for (const BcFmtSeg *s = fmts + first; s->kind != FMT_END; s++)
+        used++;
+      if (used > o[4])
+        fatal_bad_code("format argument count", p, o[4]);
+      break;
+    }
+    case OP_STRBUF_APPEND:
+      if (o[0] > CAT_CHAR)
+        fatal_bad_code("append kind", p, o[0]);
+      break;
+    case OP_STR_CAT_N: {
+      uint32_t kinds = (uint32_t)rd32(o + 1);
+      if (o[0] == 0 || o[0] > CAT_MAX)
+        fatal_bad_code("concat part count", p, o[0]);
+      for (int i = 0; i < o[0]; i++)
+        if (((kinds >> 2 * i) & 3) > CAT_FLOAT)
+          fatal_bad_code("concat part kind", p, kinds);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  free(is_insn);
+
+  // Depth analysis. The program start runs in frame 0 (owner -1) above the
+  // sentinel slot.
+  int64_t *depth = malloc((code_size + 1) * sizeof(int64_t));
+  int32_t *owner = calloc(code_size + 1, sizeof(int32_t));
+  size_t *work = malloc((code_size + 1) * sizeof(size_t));
+  int64_t *need = calloc(func_count + 1, sizeof(int64_t)); // [0]: frame 0
+  size_t wn = 0;
+  for (size_t p = 0; p <= code_size; p++)
+    depth[p] = -1;
+  int ok = code_size == 0 || v_reach(depth, owner, work, &wn, 0, 1, -1);
+  for (uint32_t f = 0; ok && f < func_count; f++)
+    ok = v_reach(depth, owner, work, &wn, funcs[f].addr, funcs[f].argc,
+                 (int32_t)f);
+  while (ok && wn > 0) {
+    size_t p = work[--wn];
+    int64_t d = depth[p], td = -1;
+    int32_t f = owner[p];
+    int64_t next = v_effect(p, d, &td);
+    if (next == -2) {
+      ok = 0;
+      break;
+    }
+    int64_t *n = &need[f + 1];
+    if (d > *n)
+      *n = d;
+    if (next > *n)
+      *n = next;
+    if (td >= 0)
+      ok = v_reach(depth, owner, work, &wn,
+                   (uint32_t)rd32(code + p + 1 + target_operand(code[p])), td,
+                   f);
+    if (ok && next >= 0) {
+      size_t q = p + 1 + op_operand_size(code[p]);
+      ok = q < code_size && v_reach(depth, owner, work, &wn, q, next, f);
+    }
+  }
+  ok = ok && need[0] <= STACK_SIZE;
+
+  if (ok) {
+    frame_need = malloc((func_count + 1) * sizeof(uint32_t));
+    for (uint32_t f = 0; f < func_count; f++)
+      frame_need[f] = (uint32_t)need[f + 1];
+    verified = 1;
+  }
+  free(depth);
+  free(owner);
+  free(work);
+  free(need);
+}
+
+// --- PRE-DECODING ---
+// The stack engine never reads `code` while running. predecode() walks it
+// once at load time and builds one Cell per instruction: the handler's label
+// address plus its operands widened to native types, with every code address
+// (jumps, calls, try, the fused compare-and-branch ops) resolved to a Cell
+// pointer. Dispatch is then pure direct threading, `goto *pc->h`.
+typedef struct Cell {
+  void *h; // handler label in main()
+  union {
+    int64_t k;         // constant
+    struct Cell *t;    // resolved code address
+    char *s;           // string pool entry (CONST_STR, TAG_ALLOC, comments)
+    const BcFmtSeg *f; // first format segment (PRINT_FMT_SEG)
+  } a;
+  uint32_t b; // slot, argc, count, struct/native id or field offset
+  int32_t c;  // second slot, field offset or int constant
+} Cell;
+
+static Cell *cells;        // one per instruction, then a trailing OP_HALT
+static uint32_t cell_count; // instructions, excluding the trailing OP_HALT
+static uint32_t *cell_at;  // byte offset -> cell index, code_size + 1 entries
+static uint32_t *cell_off; // cell index -> byte offset, cell_count + 2 entries
+
+// Cell for a code address operand. Addresses that do not start an
+// instruction land on the trailing OP_HALT.
+static Cell *cell_target(const uint8_t *p) {
+  uint32_t addr = (uint32_t)rd32(p);
+  return &cells[addr <= code_size ? cell_at[addr] : cell_count];
+}
+
+static void predecode(void *const *table) {
+  cell_at = malloc((code_size + 1) * sizeof(uint32_t));
+  uint32_t n = 0;
+  for (size_t i = 0; i <= code_size; i++)
+    cell_at[i] = UINT32_MAX;
+  for (size_t p = 0; p < code_size; p += 1 + op_operand_size(code[p]))
+    cell_at[p] = n++;
+  for (size_t i = 0; i <= code_size; i++)
+    if (cell_at[i] == UINT32_MAX)
+      cell_at[i] = n;
+  cell_count = n;
+
+  cells = malloc((n + 1) * sizeof(Cell));
+  cell_off = malloc((n + 2) * sizeof(uint32_t));
+  Cell *c = cells;
+  for (size_t p = 0; p < code_size; c++) {
+    uint8_t op = code[p];
+    const uint8_t *o = code + p + 1;
+    *c = (Cell){.h = table[op]};
+    cell_off[c - cells] = (uint32_t)p;
+    switch (op) {
+    case OP_CONST_INT:
+      c->a.k = rd32(o);
+      break;
+    case OP_CONST_FLOAT:
+      memcpy(&c->a.k, o, 8);
+      break;
+    case OP_CONST_STR:
+    case OP_TAG_ALLOC:
+      c->a.s = STR((uint32_t)rd32(o));
+      break;
+    case OP_JMP:
+    case OP_JZ:
+    case OP_TRY:
+    case OP_LT_JZ:
+    case OP_LE_JZ:
+    case OP_GT_JZ:
+    case OP_GE_JZ:
+    case OP_EQ_JZ:
+    case OP_NE_JZ:
+      c->a.t = cell_target(o);
+      break;
+    case OP_CALL:
+      c->a.t = cell_target(o);
+      c->b = o[4];
+      c->c = verified ? (int32_t)frame_need[func_at[(uint32_t)rd32(o)]] : 0;
+      break;
+    case OP_ALLOC_STRUCT:
+    case OP_ALLOC_ARRAY:
+    case OP_ALLOC_STACK: {
+      uint32_t cidx = (uint32_t)rd32(o + 4);
+      c->a.s = cidx == 0xFFFFFFFF ? NULL : STR(cidx);
+      c->b = (uint32_t)rd32(o);
+      break;
+    }
+    case OP_NATIVE:
+      c->b = (uint32_t)rd32(o);
+      break;
+    case OP_PRINT_FMT_SEG:
+      c->a.f = fmts + (uint32_t)rd32(o);
+      c->b = o[4];
+      break;
+    case OP_STR_CAT_N:
+      c->b = o[0];
+      c->c = rd32(o + 1);
+      break;
+    case OP_STRBUF_APPEND:
+      c->b = o[0];
+      break;
+    case OP_INC_LOCAL:
+      c->b = o[0];
+      c->c = rd32(o + 1);
+      break;
+    case OP_GET_LOCAL_FIELD:
+    case OP_GET_LOCAL2:
+    case OP_CALL_DYN_BOT:
+      c->b = o[0];
+      c->c = o[1];
+      break;
+    case OP_LOCAL_CONST_LT_JZ:
+    case OP_LOCAL_CONST_LE_JZ:
+    case OP_LOCAL_CONST_GT_JZ:
+    case OP_LOCAL_CONST_GE_JZ:
+    case OP_LOCAL_CONST_EQ_JZ:
+    case OP_LOCAL_CONST_NE_JZ:
+      c->b = o[0];
+      c->c = rd32(o + 1);
+      c->a.t = cell_target(o + 5);
+      break;
+    case OP_LOCAL_LOCAL_LT_JZ:
+    case OP_LOCAL_LOCAL_LE_JZ:
+    case OP_LOCAL_LOCAL_GT_JZ:
+    case OP_LOCAL_LOCAL_GE_JZ:
+    case OP_LOCAL_LOCAL_EQ_JZ:
+    case OP_LOCAL_LOCAL_NE_JZ:
+      c->b = o[0];
+      c->c = o[1];
+      c->a.t = cell_target(o + 2);
+      break;
+    default: // one-byte operand: slot, global, field offset, argc or count
+      if (op_operand_size(op) == 1)
+        c->b = o[0];
+      break;
+    }
+    p += 1 + op_operand_size(op);
+  }
+  *c = (Cell){.h = table[OP_HALT]};
+  cell_off[n] = cell_off[n + 1] = (uint32_t)code_size;
+}
+
+// --- TEMPLATE JIT (abyss_vm --jit, x86-64) ---
+// The machine-code counterpart of src/native.c: one template per opcode,
+// applied to the pre-decoded cells a function at a time (a function runs
+// from one CALL target to the next). Compiled code keeps the interpreter's
+// state model, with the same stale stack[lsp - 1]:
+//   rbx  &stack[lsp]   r12  &stack[lfp]   r13  globals   r14  tos
+//   r15  JitCtx *
+// It never calls out. Opcodes that call, return, throw, allocate, print or
+// reach Abyss Eye stay with the interpreter: compiled code returns that
+// cell's index, the interpreter runs it, and execution re-enters compiled
+// code at the next leader cell, whose handler is L_JIT_ENTER. Try/catch,
+// stack-alloc cleanup and Abyss Eye bookkeeping are thus untouched.
+typedef struct {
+  int64_t *sp;      // &stack[lsp]
+  int64_t *fp;      // &stack[lfp]
+  int64_t *globals; // globals
+  int64_t tos;
+  int64_t *limit; // &stack[STACK_SIZE]
+} JitCtx;
+
+#define JIT_OVERFLOW UINT32_MAX // returned instead of a cell index
+
+typedef uint32_t (*JitEnterFn)(JitCtx *ctx, const void *code);
+static JitEnterFn jit_enter;
+static const void **jit_entry; // cell index -> compiled code (leaders only)
+static void *jit_enter_label;  // L_JIT_ENTER
+static uint8_t *jit_leader;    // cell index -> compiled code can start here
+
+// A function as the JIT sees it: the program start or a CALL target, running
+// up to the next one.
+typedef struct {
+  uint32_t first, end; // cells [first, end)
+  uint64_t calls, backedges;
+  uint64_t promoted_at; // calls + back-edges when promoted (--tier)
+  uint8_t promoted_by_loop;
+  uint8_t compiled;
+} JitFunc;
+static JitFunc *jit_funcs;
+static uint32_t jit_func_count;
+
+#if defined(__x86_64__)
+
+static uint8_t *jb;
+static size_t jb_sz, jb_cap;
+
+typedef struct {
+  size_t pos;      // rel32 to patch
+  uint32_t target; // cell index
+} JitFixup;
+static JitFixup *jfix;
+static int jfix_count, jfix_cap;
+static uint32_t *jit_off; // cell index -> offset in the current function
+
+static void jb_bytes(const uint8_t *p, size_t n) {
+  if (jb_sz + n > jb_cap) {
+    jb_cap = jb_cap ? jb_cap * 2 : 4096;
+    jb = realloc(jb, jb_cap);
+  }
+  memcpy(jb + jb_sz, p, n);
+  jb_sz += n;
+}
+#define E(...)                                                                 \
+  jb_bytes((const uint8_t[]){__VA_ARGS__}, sizeof((uint8_t[]){__VA_ARGS__}))
+
+static void jb_32(int32_t v) { jb_bytes((const uint8_t *)&v, 4); }
+static void jb_64(int64_t v) { jb_bytes((const uint8_t *)&v, 8); }
+
+// rel32 to an already emitted offset.
+static void jb_rel_to(size_t at) { jb_32((int32_t)(at - (jb_sz + 4))); }
+
+// rel32 to a cell, patched once the function is laid out.
+static void jb_rel_cell(uint32_t t) {
+  if (jfix_count >= jfix_cap) {
+    jfix_cap = jfix_cap ? jfix_cap * 2 : 256;
+    jfix = realloc(jfix, jfix_cap * sizeof(JitFixup));
+  }
+  jfix[jfix_count++] = (JitFixup){jb_sz, t};
+  jb_32(0);
+}
+
+// Offsets of the shared tails at the start of every function's code.
+#define JIT_EXIT 0
+static size_t jit_overflow_at;
+
+static void jit_exit_to(uint32_t cell) {
+  E(0xB8); // mov eax, cell
+  jb_32((int32_t)cell);
+  E(0xE9); // jmp exit
+  jb_rel_to(JIT_EXIT);
+}
+
+#define J_SPILL() E(0x4C, 0x89, 0x73, 0xF8) // mov [rbx-8], r14
+#define J_FILL() E(0x4C, 0x8B, 0x73, 0xF8)  // mov r14, [rbx-8]
+#define J_LOAD_A() E(0x48, 0x8B, 0x43, 0xF0) // mov rax, [rbx-16]
+#define J_DROP(n) E(0x48, 0x83, 0xEB, 8 * (n)) // sub rbx, 8n
+#define J_SET_TOS_AL() E(0x4C, 0x0F, 0xB6, 0xF0) // movzx r14, al
+
+// Push prologue: overflow check, then write the old top back.
+static void jit_push_pre(void) {
+  E(0x49, 0x3B, 0x5F, 0x20); // cmp rbx, [r15+32]
+  E(0x0F, 0x83);             // jae overflow
+  jb_rel_to(jit_overflow_at);
+  J_SPILL();
+}
+#define J_PUSH_POST() E(0x48, 0x83, 0xC3, 0x08) // add rbx, 8
+
+// r12-relative operand (frame slot n): modrm.reg | [r12 + disp32].
+static void jit_local(uint8_t reg, uint32_t slot) {
+  E(0x84 | (reg << 3), 0x24);
+  jb_32((int32_t)(slot * 8));
+}
+
+// Inverted jcc (jump when the comparison is false) per compare opcode.
+static uint8_t jit_jncc(int cmp) {
+  static const uint8_t jncc[] = {0x8D, 0x8F, 0x8E, 0x8C, 0x85, 0x84};
+  return jncc[cmp];
+}
+// setcc for LT LE GT GE EQ NE.
+static uint8_t jit_setcc(int cmp) {
+  static const uint8_t setcc[] = {0x9C, 0x9E, 0x9F, 0x9D, 0x94, 0x95};
+  return setcc[cmp];
+}
+
+static int jit_supported(uint8_t op) {
+  switch (op) {
+  case OP_CONST_INT:
+  case OP_CONST_FLOAT:
+  case OP_CONST_STR:
+  case OP_ADD:
+  case OP_SUB:
+  case OP_MUL:
+  case OP_DIV:
+  case OP_MOD:
+  case OP_ADD_F:
+  case OP_SUB_F:
+  case OP_MUL_F:
+  case OP_DIV_F:
+  case OP_LT:
+  case OP_LE:
+  case OP_GT:
+  case OP_GE:
+  case OP_EQ:
+  case OP_NE:
+  case OP_LT_F:
+  case OP_LE_F:
+  case OP_GT_F:
+  case OP_GE_F:
+  case OP_EQ_F:
+  case OP_NE_F:
+  case OP_AND:
+  case OP_OR:
+  case OP_NOT:
+  case OP_BIT_AND:
+  case OP_BIT_OR:
+  case OP_BIT_XOR:
+  case OP_SHL:
+  case OP_SHR:
+  case OP_BIT_NOT:
+  case OP_NEG:
+  case OP_NEG_F:
+  case OP_I2F:
+  case OP_F2I:
+  case OP_JMP:
+  case OP_JZ:
+  case OP_GET_GLOBAL:
+  case OP_SET_GLOBAL:
+  case OP_GET_LOCAL:
+  case OP_SET_LOCAL:
+  case OP_POP:
+  case OP_DUP:
+  case OP_SWAP:
+  case OP_GET_FIELD:
+  case OP_SET_FIELD:
+  case OP_GET_INDEX:
+  case OP_SET_INDEX:
+  case OP_INC_INDEX:
+  case OP_DEC_INDEX:
+  case OP_INC_LOCAL:
+  case OP_GET_LOCAL_FIELD:
+  case OP_GET_LOCAL2:
+    return 1;
+  default:
+    return (op >= OP_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ);
+  }
+}
+
+// Emits the template for cell i. Returns 0 if the opcode is not compiled.
+static int jit_cell(uint32_t i) {
+  const Cell *c = &cells[i];
+  uint8_t op = code[cell_off[i]];
+  switch (op) {
+  case OP_CONST_INT:
+  case OP_CONST_FLOAT:
+  case OP_CONST_STR:
+    jit_push_pre();
+    if (c->a.k == (int32_t)c->a.k) {
+      E(0x49, 0xC7, 0xC6); // mov r14, imm32
+      jb_32((int32_t)c->a.k);
+    } else {
+      E(0x49, 0xBE); // mov r14, imm64
+      jb_64(c->a.k);
+    }
+    J_PUSH_POST();
+    break;
+
+  case OP_ADD:
+    E(0x4C, 0x03, 0x73, 0xF0); // add r14, [rbx-16]
+    J_DROP(1);
+    break;
+  case OP_SUB:
+    J_LOAD_A();
+    E(0x4C, 0x29, 0xF0); // sub rax, r14
+    E(0x49, 0x89, 0xC6); // mov r14, rax
+    J_DROP(1);
+    break;
+  case OP_MUL:
+    E(0x4C, 0x0F, 0xAF, 0x73, 0xF0); // imul r14, [rbx-16]
+    J_DROP(1);
+    break;
+  case OP_DIV:
+  case OP_MOD:
+    J_LOAD_A();
+    E(0x48, 0x99);       // cqo
+    E(0x49, 0xF7, 0xFE); // idiv r14
+    if (op == OP_DIV)
+      E(0x49, 0x89, 0xC6); // mov r14, rax
+    else
+      E(0x49, 0x89, 0xD6); // mov r14, rdx
+    J_DROP(1);
+    break;
+  case OP_BIT_AND:
+    E(0x4C, 0x23, 0x73, 0xF0); // and r14, [rbx-16]
+    J_DROP(1);
+    break;
+  case OP_BIT_OR:
+    E(0x4C, 0x0B, 0x73, 0xF0); // or r14, [rbx-16]
+    J_DROP(1);
+    break;
+  case OP_BIT_XOR:
+    E(0x4C, 0x33, 0x73, 0xF0); // xor r14, [rbx-16]
+    J_DROP(1);
+    break;
+  case OP_SHL:
+  case OP_SHR:
+    E(0x4C, 0x89, 0xF1);       // mov rcx, r14
+    E(0x4C, 0x8B, 0x73, 0xF0); // mov r14, [rbx-16]
+    if (op == OP_SHL)
+      E(0x49, 0xD3, 0xE6); // shl r14, cl
+    else
+      E(0x49, 0xD3, 0xFE); // sar r14, cl
+    J_DROP(1);
+    break;
+  case OP_AND:
+  case OP_OR:
+    J_LOAD_A();
+    E(0x48, 0x85, 0xC0);                   // test rax, rax
+    E(0x0F, 0x95, 0xC0);                   // setne al
+    E(0x4D, 0x85, 0xF6);                   // test r14, r14
+    E(0x0F, 0x95, 0xC1);                   // setne cl
+    E(op == OP_AND ? 0x20 : 0x08, 0xC8);   // and|or al, cl
+    J_SET_TOS_AL();
+    J_DROP(1);
+    break;
+  case OP_LT:
+  case OP_LE:
+  case OP_GT:
+  case OP_GE:
+  case OP_EQ:
+  case OP_NE:
+    J_LOAD_A();
+    E(0x4C, 0x39, 0xF0); // cmp rax, r14
+    E(0x0F, jit_setcc(op - OP_LT), 0xC0);
+    J_SET_TOS_AL();
+    J_DROP(1);
+    break;
+
+  case OP_ADD_F:
+  case OP_SUB_F:
+  case OP_MUL_F:
+  case OP_DIV_F:
+  case OP_LT_F:
+  case OP_LE_F:
+  case OP_GT_F:
+  case OP_GE_F:
+  case OP_EQ_F:
+  case OP_NE_F:
+    E(0xF3, 0x0F, 0x7E, 0x43, 0xF0);       // movq xmm0, [rbx-16]
+    E(0x66, 0x49, 0x0F, 0x6E, 0xCE);       // movq xmm1, r14
+    if (op <= OP_DIV_F) {
+      static const uint8_t sd[] = {0x58, 0x5C, 0x59, 0x5E};
+      E(0xF2, 0x0F, sd[op - OP_ADD_F], 0xC1); // addsd..divsd xmm0, xmm1
+      E(0x66, 0x49, 0x0F, 0x7E, 0xC6);        // movq r14, xmm0
+    } else {
+      // ucomisd leaves "unordered" looking like below-and-equal, so a < b is
+      // tested as b > a to make every NaN comparison false, as in C.
+      switch (op) {
+      case OP_LT_F:
+      case OP_LE_F:
+        E(0x66, 0x0F, 0x2E, 0xC8); // ucomisd xmm1, xmm0
+        E(0x0F, op == OP_LT_F ? 0x97 : 0x93, 0xC0); // seta|setae al
+        break;
+      case OP_GT_F:
+      case OP_GE_F:
+        E(0x66, 0x0F, 0x2E, 0xC1); // ucomisd xmm0, xmm1
+        E(0x0F, op == OP_GT_F ? 0x97 : 0x93, 0xC0);
+        break;
+      case OP_EQ_F:
+        E(0x66, 0x0F, 0x2E, 0xC1);
+        E(0x0F, 0x94, 0xC0); // sete al
+        E(0x0F, 0x9B, 0xC1); // setnp cl
+        E(0x20, 0xC8);       // and al, cl
+        break;
+      default: // OP_NE_F
+        E(0x66, 0x0F, 0x2E, 0xC1);
+        E(0x0F, 0x95, 0xC0); // setne al
+        E(0x0F, 0x9A, 0xC1); // setp cl
+        E(0x08, 0xC8);       // or al, cl
+        break;
+      }
+      J_SET_TOS_AL();
+    }
+    J_DROP(1);
+    break;
+
+  case OP_NEG:
+    E(0x49, 0xF7, 0xDE); // neg r14
+    break;
+  case OP_NEG_F:
+    E(0x49, 0x0F, 0xBA, 0xFE, 0x3F); // btc r14, 63
+    break;
+  case OP_NOT:
+    E(0x4D, 0x85, 0xF6); // test r14, r14
+    E(0x0F, 0x94, 0xC0); // sete al
+    J_SET_TOS_AL();
+    break;
+  case OP_BIT_NOT:
+    E(0x49, 0xF7, 0xD6); // not r14
+    break;
+  case OP_I2F:
+    E(0xF2, 0x49, 0x0F, 0x2A, 0xC6); // cvtsi2sd xmm0, r14
+    E(0x66, 0x49, 0x0F, 0x7E, 0xC6); // movq r14, xmm0
+    break;
+  case OP_F2I:
+    E(0x66, 0x49, 0x0F, 0x6E, 0xC6); // movq xmm0, r14
+    E(0xF2, 0x4C, 0x0F, 0x2C, 0xF0); // cvttsd2si r14, xmm0
+    break;
+
+  case OP_JMP:
+    E(0xE9);
+    jb_rel_cell((uint32_t)(c->a.t - cells));
+    break;
+  case OP_JZ:
+    E(0x4C, 0x89, 0xF0); // mov rax, r14
+    J_DROP(1);
+    J_FILL();
+    E(0x48, 0x85, 0xC0); // test rax, rax
+    E(0x0F, 0x84);       // jz
+    jb_rel_cell((uint32_t)(c->a.t - cells));
+    break;
+
+  case OP_GET_GLOBAL:
+    jit_push_pre();
+    E(0x4D, 0x8B, 0xB5); // mov r14, [r13+disp32]
+    jb_32((int32_t)(c->b * 8));
+    J_PUSH_POST();
+    break;
+  case OP_SET_GLOBAL:
+    E(0x4D, 0x89, 0xB5); // mov [r13+disp32], r14
+    jb_32((int32_t)(c->b * 8));
+    J_DROP(1);
+    J_FILL();
+    break;
+  case OP_GET_LOCAL:
+    jit_push_pre();
+    E(0x4D, 0x8B); // mov r14, [r12+slot]
+    jit_local(6, c->b);
+    J_PUSH_POST();
+    break;
+  case OP_SET_LOCAL:
+    E(0x4D, 0x89); // mov [r12+slot], r14
+    jit_local(6, c->b);
+    J_DROP(1);
+    J_FILL();
+    break;
+  case OP_GET_LOCAL2:
+    jit_push_pre();
+    E(0x4D, 0x8B);
+    jit_local(6, c->b);
+    J_PUSH_POST();
+    jit_push_pre();
+    E(0x4D, 0x8B);
+    jit_local(6, (uint32_t)c->c);
+    J_PUSH_POST();
+    break;
+  case OP_GET_LOCAL_FIELD:
+    jit_push_pre();
+    E(0x49, 0x8B); // mov rax, [r12+slot]
+    jit_local(0, c->b);
+    E(0x4C, 0x8B, 0xB0); // mov r14, [rax+disp32]
+    jb_32(c->c * 8);
+    J_PUSH_POST();
+    break;
+  case OP_POP:
+    J_DROP(1);
+    J_FILL();
+    break;
+  case OP_DUP:
+    jit_push_pre();
+    J_PUSH_POST();
+    break;
+  case OP_SWAP:
+    J_LOAD_A();
+    E(0x4C, 0x89, 0x73, 0xF0); // mov [rbx-16], r14
+    E(0x49, 0x89, 0xC6);       // mov r14, rax
+    break;
+
+  case OP_GET_FIELD:
+    E(0x4D, 0x8B, 0xB6); // mov r14, [r14+disp32]
+    jb_32((int32_t)(c->b * 8));
+    break;
+  case OP_SET_FIELD:
+    J_LOAD_A();
+    E(0x4C, 0x89, 0xB0); // mov [rax+disp32], r14
+    jb_32((int32_t)(c->b * 8));
+    J_DROP(2);
+    J_FILL();
+    break;
+  case OP_GET_INDEX:
+    J_LOAD_A();
+    E(0x4E, 0x8B, 0x34, 0xF0); // mov r14, [rax+r14*8]
+    J_DROP(1);
+    break;
+  case OP_SET_INDEX:
+    E(0x48, 0x8B, 0x43, 0xE8); // mov rax, [rbx-24]
+    E(0x48, 0x8B, 0x4B, 0xF0); // mov rcx, [rbx-16]
+    E(0x4C, 0x89, 0x34, 0xC8); // mov [rax+rcx*8], r14
+    J_DROP(3);
+    J_FILL();
+    break;
+  case OP_INC_INDEX:
+  case OP_DEC_INDEX:
+    J_LOAD_A();
+    // inc|dec qword [rax+r14*8]
+    E(0x4A, 0xFF, op == OP_INC_INDEX ? 0x04 : 0x0C, 0xF0);
+    J_DROP(2);
+    J_FILL();
+    break;
+
+  case OP_INC_LOCAL:
+    J_SPILL(); // the local may be the top slot
+    E(0x49, 0x81); // add qword [r12+slot], imm32
+    jit_local(0, c->b);
+    jb_32(c->c);
+    J_FILL();
+    break;
+
+  default:
+    if (op >= OP_LT_JZ && op <= OP_NE_JZ) {
+      J_LOAD_A();
+      E(0x4C, 0x89, 0xF1); // mov rcx, r14
+      J_DROP(2);
+      J_FILL();
+      E(0x48, 0x39, 0xC8); // cmp rax, rcx
+      E(0x0F, jit_jncc(op - OP_LT_JZ));
+    } else if (op >= OP_LOCAL_CONST_LT_JZ && op <= OP_LOCAL_CONST_NE_JZ) {
+      J_SPILL();
+      E(0x49, 0x81); // cmp qword [r12+slot], imm32
+      jit_local(7, c->b);
+      jb_32(c->c);
+      E(0x0F, jit_jncc(op - OP_LOCAL_CONST_LT_JZ));
+    } else if (op >= OP_LOCAL_LOCAL_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ) {
+      J_SPILL();
+      E(0x49, 0x8B); // mov rax, [r12+slot]
+      jit_local(0, c->b);
+      E(0x49, 0x3B); // cmp rax, [r12+slot]
+      jit_local(0, (uint32_t)c->c);
+      E(0x0F, jit_jncc(op - OP_LOCAL_LOCAL_LT_JZ));
+    } else {
+      return 0;
+    }
+    jb_rel_cell((uint32_t)(c->a.t - cells));
+    break;
+  }
+  return 1;
+}
+
+// Compiles fn's cells into their own executable mapping and points every
+// leader among them at it.
+static void jit_function(JitFunc *fn) {
+  uint32_t first = fn->first, end = fn->end;
+  jb_sz = 0;
+  jfix_count = 0;
+
+  // exit: mov [r15], rbx; mov [r15+24], r14; pop r15..rbx; ret
+  E(0x49, 0x89, 0x1F, 0x4D, 0x89, 0x77, 0x18);
+  E(0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3);
+  jit_overflow_at = jb_sz;
+  jit_exit_to(JIT_OVERFLOW);
+
+  for (uint32_t i = first; i < end; i++) {
+    jit_off[i] = (uint32_t)jb_sz;
+    if (!jit_cell(i))
+      jit_exit_to(i);
+  }
+  jit_exit_to(end); // falling off the end
+
+  // Jumps out of the function leave through a stub each.
+  for (int f = 0; f < jfix_count; f++) {
+    uint32_t t = jfix[f].target;
+    size_t at = jb_sz;
+    if (t >= first && t < end)
+      at = jit_off[t];
+    else
+      jit_exit_to(t);
+    int32_t rel = (int32_t)(at - (jfix[f].pos + 4));
+    memcpy(jb + jfix[f].pos, &rel, 4);
+  }
+
+  uint8_t *mem = mmap(NULL, jb_sz, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED)
+    return; // stays interpreted
+  memcpy(mem, jb, jb_sz);
+  mprotect(mem, jb_sz, PROT_READ | PROT_EXEC);
+  fn->compiled = 1;
+
+  for (uint32_t i = first; i < end; i++) {
+    if (jit_leader[i] && jit_supported(code[cell_off[i]])) {
+      jit_entry[i] = mem + jit_off[i];
+      cells[i].h = jit_enter_label;
+    }
+  }
+}
+
+// Builds the entry trampoline and splits the cells into functions. Leaders
+// are the cells compiled code can be entered at: function entries, jump and
+// catch targets, and every cell the interpreter reaches after running an
+// opcode the JIT left to it. Needs `code`. enter_label is a label in
+// main(); noipa stops GCC from cloning this function with the label
+// propagated in as a constant, which would reference it from outside main.
+__attribute__((noipa)) static int jit_init(void *enter_label) {
+  static const uint8_t enter[] = {
+      0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57, // push rbx..r15
+      0x49, 0x89, 0xFF,                                     // mov r15, rdi
+      0x49, 0x8B, 0x1F,                                     // mov rbx, [r15]
+      0x4D, 0x8B, 0x67, 0x08, // mov r12, [r15+8]
+      0x4D, 0x8B, 0x6F, 0x10, // mov r13, [r15+16]
+      0x4D, 0x8B, 0x77, 0x18, // mov r14, [r15+24]
+      0xFF, 0xE6,             // jmp rsi
+  };
+  uint8_t *mem = mmap(NULL, sizeof(enter), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED)
+    return 0;
+  memcpy(mem, enter, sizeof(enter));
+  mprotect(mem, sizeof(enter), PROT_READ | PROT_EXEC);
+  jit_enter = (JitEnterFn)(void *)mem;
+  jit_enter_label = enter_label;
+
+  uint32_t n = cell_count;
+  uint8_t *entry = calloc(n + 1, 1);
+  jit_leader = calloc(n + 1, 1);
+  jit_entry = calloc(n + 1, sizeof(void *));
+  jit_off = malloc((n + 1) * sizeof(uint32_t));
+  jit_leader[0] = entry[0] = 1;
+  for (uint32_t i = 0; i < n; i++) {
+    uint8_t op = code[cell_off[i]];
+    if (op == OP_JMP || op == OP_JZ || op == OP_TRY || op == OP_CALL ||
+        (op >= OP_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ))
+      jit_leader[cells[i].a.t - cells] = 1;
+    if (op == OP_CALL)
+      entry[cells[i].a.t - cells] = 1;
+    if (!jit_supported(op))
+      jit_leader[i + 1] = 1;
+  }
+
+  jit_funcs = malloc((n + 1) * sizeof(JitFunc));
+  jit_func_count = 0;
+  for (uint32_t first = 0; first < n;) {
+    uint32_t end = first + 1;
+    while (end < n && !entry[end])
+      end++;
+    jit_funcs[jit_func_count++] = (JitFunc){.first = first, .end = end};
+    first = end;
+  }
+  free(entry);
+  return 1;
+}
+
+// Drops the compiler's scratch state; compiled code stays mapped.
+static void jit_release(void) {
+  free(jit_leader);
+  free(jit_off);
+  free(jb);
+  free(jfix);
+  jit_leader = NULL;
+  jit_off = NULL;
+  jb = NULL;
+  jfix = NULL;
+}
+#undef E
+#undef J_SPILL
+#undef J_FILL
+#undef J_LOAD_A
+#undef J_DROP
+#undef J_SET_TOS_AL
+#undef J_PUSH_POST
+#else
+static void jit_function(JitFunc *fn) { (void)fn; }
+static int jit_init(void *enter_label) {
+  (void)enter_label;
+  return 0;
+}
+static void jit_release(void) {}
+#endif
+
+// abyss_vm --jit: every function is compiled before the program starts.
+static int jit_compile(void *enter_label) {
+  if (!jit_init(enter_label))
+    return 0;
+  for (uint32_t f = 0; f < jit_func_count; f++)
+    jit_function(&jit_funcs[f]);
+  jit_release();
+  return 1;
+}
+
+// --- TIERED EXECUTION (abyss_vm --tier) ---
+// Every function starts interpreted (tier 0). Its entry cell and each of its
+// backward branches get a counting handler; the original handler is kept in
+// tier_h. Once calls + back-edges reach tier_threshold the function is
+// compiled by the JIT (tier 1) and its counting handlers are removed, so a
+// promoted function costs nothing extra. Functions are the JIT's: the
+// program start and every CALL target, i.e. the FuncInfo addresses the
+// compiler resolved.
+static uint64_t tier_threshold = 1000;
+static void **tier_h;     // cell index -> original handler (counted cells)
+static uint32_t *tier_fn; // cell index -> function index (counted cells)
+
+static int tier_init(void *entry_label, void *backedge_label,
+                     void *enter_label) {
+  if (!jit_init(enter_label))
+    return 0;
+  tier_h = calloc(cell_count + 1, sizeof(void *));
+  tier_fn = malloc((cell_count + 1) * sizeof(uint32_t));
+  for (uint32_t f = 0; f < jit_func_count; f++) {
+    JitFunc *fn = &jit_funcs[f];
+    for (uint32_t i = fn->first; i < fn->end; i++) {
+      uint8_t op = code[cell_off[i]];
+      if ((op == OP_JMP || op == OP_JZ ||
+           (op >= OP_LT_JZ && op <= OP_LOCAL_LOCAL_NE_JZ)) &&
+          cells[i].a.t <= &cells[i]) {
+        tier_h[i] = cells[i].h;
+        tier_fn[i] = f;
+        cells[i].h = backedge_label;
+      }
+    }
+    if (!tier_h[fn->first])
+      tier_h[fn->first] = cells[fn->first].h;
+    tier_fn[fn->first] = f;
+    cells[fn->first].h = entry_label;
+  }
+  return 1;
+}
+
+// Counts a call (backedge = 0) or a back-edge at a counted cell and returns
+// the handler to run it with.
+static void *tier_hit(uint32_t cell, int backedge) {
+  JitFunc *fn = &jit_funcs[tier_fn[cell]];
+  if (backedge)
+    fn->backedges++;
+  else
+    fn->calls++;
+  if (fn->calls + fn->backedges < tier_threshold)
+    return tier_h[cell];
+
+  for (uint32_t i = fn->first; i < fn->end; i++) {
+    if (tier_h[i]) {
+      cells[i].h = tier_h[i];
+      tier_h[i] = NULL;
+    }
+  }
+  fn->promoted_at = fn->calls + fn->backedges;
+  fn->promoted_by_loop = (uint8_t)backedge;
+  jit_function(fn);
+  return cells[cell].h;
+}
+
+static int tier_cmp(const void *a, const void *b) {
+  const JitFunc *x = a, *y = b;
+  uint64_t hx = x->calls + x->backedges, hy = y->calls + y->backedges;
+  return (hx < hy) - (hx > hy);
+}
+
+// --tier-stats: counters and promotion decisions, hottest function first.
+// A promoted function stops counting, so its counts end at the threshold.
+static void tier_report(void) {
+  uint32_t promoted = 0;
+  for (uint32_t f = 0; f < jit_func_count; f++)
+    promoted += jit_funcs[f].compiled;
+  fprintf(stderr, "[tier] threshold %lu, %u functions, %u promoted\n",
+          (unsigned long)tier_threshold, jit_func_count, promoted);
+  qsort(jit_funcs, jit_func_count, sizeof(JitFunc), tier_cmp);
+  fprintf(stderr, "[tier]   %-20s %-8s %6s %12s %12s  %s\n", "function",
+          "entry", "cells", "calls", "back-edges", "tier");
+  for (uint32_t f = 0; f < jit_func_count; f++) {
+    JitFunc *fn = &jit_funcs[f];
+    if (fn->calls + fn->backedges == 0)
+      break;
+    // Every entry but the program start is a function's.
+    uint32_t addr = cell_off[fn->first];
+    int32_t named = func_of(addr);
+    fprintf(stderr, "[tier]   %-20s %08X %6u %12lu %12lu  ",
+            named >= 0 && funcs[named].addr == addr
+                ? IMAGE_STR(funcs[named].name)
+                : "(top level)",
+            addr, fn->end - fn->first, (unsigned long)fn->calls,
+            (unsigned long)fn->backedges);
+    if (fn->compiled)
+      fprintf(stderr, "1 (jit after %lu %s)\n", (unsigned long)fn->promoted_at,
+              fn->promoted_by_loop ? "loop" : "call");
+    else if (fn->promoted_at)
+      fprintf(stderr, "0 (jit failed)\n");
+    else
+      fprintf(stderr, "0\n");
+  }
+}
+
+// --- SAMPLING PROFILER (abyss_vm --prof=FILE) ---
+// A SIGPROF timer fires every PROF_INTERVAL_US of CPU time (the kernel
+// rounds that up to its tick) and records the instruction being run plus
+// the return address of every frame on call_stack. At exit the samples are
+// named through the function table and written as collapsed stacks
+// ("main;parse;next 42" per line), the input flamegraph.pl and speedscope
+// take.
+//
+// A signal handler cannot see the interpreter's locals, so while profiling
+// every instruction is routed through a stub (L_PROF_STEP, R_L_PROF) that
+// publishes its position and the call depth, then runs the real handler.
+// Without --prof no stub is installed and dispatch is unchanged. The JIT
+// is off while profiling: compiled code would not publish its position.
+
+// Positions are outermost first; the last is the one that was running.
+// Depth 0 is top-level code (global initializers), outside any function.
+static void prof_sample(int sig) {
+  (void)sig;
+  uint64_t pos = prof_pos;
+  uint32_t depth = (uint32_t)(pos >> 32), at = (uint32_t)pos;
+  uint32_t n = depth < PROF_DEPTH ? depth : PROF_DEPTH;
+  if (prof_len + n + 1 > PROF_WORDS) {
+    prof_dropped++;
+    return;
+  }
+  uint32_t *s = prof_log + prof_len;
+  *s++ = n;
+  // call_stack[0] returns to top-level code; frame i > 0 returns into the
+  // function at depth i, and ret_addr - 1 is its call.
+  for (uint32_t i = depth - n + 1; i < depth; i++) {
+    uint32_t call = (uint32_t)call_stack[i].ret_addr - 1;
+    *s++ = prof_cells ? cell_off[call] : call;
+  }
+  if (n)
+    *s = at;
+  prof_len += n + 1;
+  prof_samples++;
+}
+
+static int prof_start(void) {
+  prof_log = malloc(PROF_WORDS * sizeof(uint32_t));
+  struct sigaction sa = {.sa_handler = prof_sample, .sa_flags = SA_RESTART};
+  sigemptyset(&sa.sa_mask);
+  struct itimerval t = {{0, PROF_INTERVAL_US}, {0, PROF_INTERVAL_US}};
+  if (!prof_log || sigaction(SIGPROF, &sa, NULL) != 0 ||
+      setitimer(ITIMER_PROF, &t, NULL) != 0) {
+    fprintf(stderr, "[prof] cannot start the sampling timer.\n");
+    return 0;
+  }
+  return 1;
+}
+
+static const char *prof_name(uint32_t addr) {
+  int32_t f = func_of(addr);
+  return f < 0 ? "?" : IMAGE_STR(funcs[f].name);
+}
+
+static int prof_line_cmp(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Stops the timer and writes the collapsed stacks, one line per distinct
+// stack. Runs from cleanup and, for exit() paths, from atexit.
+static void prof_write(void) {
+  if (!prof_log)
+    return;
+  struct itimerval off = {{0, 0}, {0, 0}};
+  setitimer(ITIMER_PROF, &off, NULL);
+  signal(SIGPROF, SIG_IGN);
+  out_flush();
+
+  char **lines = malloc((prof_samples + 1) * sizeof(char *));
+  uint32_t count = 0;
+  for (uint32_t at = 0; at < prof_len; at += prof_log[at] + 1) {
+    uint32_t n = prof_log[at];
+    size_t len = n ? 0 : sizeof("(top level)");
+    for (uint32_t i = 1; i <= n; i++)
+      len += strlen(prof_name(prof_log[at + i])) + 1;
+    char *line = malloc(len), *d = line;
+    if (!n)
+      memcpy(line, "(top level)", sizeof("(top level)"));
+    for (uint32_t i = 1; i <= n; i++) {
+      const char *name = prof_name(prof_log[at + i]);
+      size_t l = strlen(name);
+      memcpy(d, name, l);
+      d += l;
+      *d++ = i < n ? ';' : 0;
+    }
+    lines[count++] = line;
+  }
+  qsort(lines, count, sizeof(char *), prof_line_cmp);
+
+  FILE *f = fopen(prof_path, "w");
+  if (!f) {
+    fprintf(stderr, "[prof] cannot write %s: %s\n", prof_path,
+            strerror(errno));
+  } else {
+    for (uint32_t i = 0, j; i < count; i = j) {
+      for (j = i + 1; j < count && strcmp(lines[i], lines[j]) == 0; j++)
+        ;
+      fprintf(f, "%s %u\n", lines[i], j - i);
+    }
+    fclose(f);
+    fprintf(stderr, "[prof] %u samples written to %s\n", prof_samples,
+            prof_path);
+  }
+  if (prof_dropped)
+    fprintf(stderr, "[prof] sample log full; %u later samples dropped\n",
+            prof_dropped);
+  for (uint32_t i = 0; i < count; i++)
+    free(lines[i]);
+  free(lines);
+  free(prof_log);
+  prof_log = NULL;
+}
+
+// Maps a .aby file and points code, str_index and structs into it. Every
+// table-of-contents entry is bounds-checked here, and the file must end in
+// zero padding, so string reads always stop inside the mapping and no
+// section is ever read past its end.
+static int map_bytecode(const char *path, uint8_t *flags) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 8) {
+    close(fd);
+    return 0;
+  }
+  image_size = (size_t)st.st_size;
+  void *m = mmap(NULL, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED)
+    return 0;
+  image = m;
+  const BcHeader *h = m;
+
+  if (memcmp(image, MAGIC, 7) != 0) {
+    fprintf(
+        stderr,
+        "\033[1;31m[FATAL ERROR]\033[0m %s is not an AbyssLang bytecode file "
+        "(bad magic).\n",
+        path);
+    return 0;
+  }
+  uint8_t ver = image[7];
+  if (ver != VERSION) {
+    fprintf(stderr,
+            "\033[1;31m[FATAL ERROR]\033[0m Bytecode version mismatch.\n");
+    fprintf(stderr, "  File %s was compiled with bytecode v%d.\n", path,
+            ver);
+    fprintf(stderr,
+            "  This VM expects v%d. Recompile with the matching abyssc.\n",
+            VERSION);
+    return 0;
+  }
+
+  uint64_t n = image_size;
+  int ok = n >= sizeof(BcHeader) && h->file_size == n && image[n - 1] == 0 &&
+           h->str_index % BC_ALIGN == 0 && h->struct_table % BC_ALIGN == 0 &&
+           h->code % BC_ALIGN == 0 &&
+           h->str_index + (uint64_t)h->str_count * 4 <= n &&
+           h->struct_table + (uint64_t)h->struct_count * sizeof(BcStruct) <=
+               n &&
+           h->func_table + (uint64_t)h->func_count * sizeof(BcFunc) <= n &&
+           h->fmt_table + (uint64_t)h->fmt_count * sizeof(BcFmtSeg) <= n &&
+           h->line_table + (uint64_t)h->line_count * sizeof(BcLine) <= n &&
+           h->code + (uint64_t)h->code_size + BC_PAD <= n;
+  if (ok) {
+    str_index = (const uint32_t *)(image + h->str_index);
+    structs = (const BcStruct *)(image + h->struct_table);
+    for (uint32_t i = 0; ok && i < h->str_count; i++)
+      ok = str_index[i] >= STR_HDR && str_index[i] < n &&
+           str_index[i] + (uint64_t)str_len(STR(i)) < n &&
+           STR(i)[str_len(STR(i))] == 0;
+    for (uint32_t i = 0; ok && i < h->struct_count; i++)
+      ok = structs[i].name < n;
+    const BcFunc *fn = (const BcFunc *)(image + h->func_table);
+    for (uint32_t i = 0; ok && i < h->func_count; i++)
+      ok = fn[i].name < n;
+    const BcLine *ln = (const BcLine *)(image + h->line_table);
+    for (uint32_t i = 0; ok && i < h->line_count; i++)
+      ok = ln[i].file < n;
+    fmts = (const BcFmtSeg *)(image + h->fmt_table);
+    for (uint32_t i = 0; ok && i < h->fmt_count; i++)
+      ok = fmts[i].kind < FMT_KINDS && fmts[i].lit < h->str_count &&
+           str_index[fmts[i].lit] + (uint64_t)fmts[i].len < n;
+    ok = ok && (h->fmt_count == 0 || fmts[h->fmt_count - 1].kind == FMT_END);
+  }
+  if (!ok) {
+    fprintf(stderr,
+            "\033[1;31m[FATAL ERROR]\033[0m %s is truncated or corrupt "
+            "(bad section table).\n",
+            path);
+    return 0;
+  }
+  *flags = h->flags;
+  str_count = h->str_count;
+  struct_count = h->struct_count;
+  funcs = (const BcFunc *)(image + h->func_table);
+  func_count = h->func_count;
+  fmt_count = h->fmt_count;
+  lines = (const BcLine *)(image + h->line_table);
+  line_count = h->line_count;
+  code = image + h->code;
+  code_size = h->code_size;
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  int jit = 0, tier = 0, tier_stats = 0, stats = 0;
+  const char *path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--jit") == 0)
+      jit = 1;
+    else if (strcmp(argv[i], "--tier") == 0)
+      tier = 1;
+    else if (strncmp(argv[i], "--tier-threshold=", 17) == 0)
+      tier = 1, tier_threshold = strtoull(argv[i] + 17, NULL, 10);
+    else if (strcmp(argv[i], "--tier-stats") == 0)
+      tier = tier_stats = 1;
+    else if (strncmp(argv[i], "--prof=", 7) == 0)
+      prof_path = argv[i] + 7;
+    else if (strcmp(argv[i], "--stats") == 0)
+      stats = 1;
+    else if (strncmp(argv[i], "--stats=", 8) == 0)
+      stats = 1, stats_path = argv[i] + 8;
+    else
+      path = argv[i];
+  }
+  if (!path)
+    return 1;
+  uint8_t flags;
+  if (!map_bytecode(path, &flags))
+    return 1;
+  out_tty = isatty(STDOUT_FILENO);
+  atexit(out_flush);
+  if ((prof_path || stats) && (jit || tier)) {
+    fprintf(stderr, "[%s] profiling interprets; --jit and --tier have no "
+                    "effect.\n",
+            stats ? "stats" : "prof");
+    jit = tier = tier_stats = 0;
+  }
+
+  if (flags & BC_FLAG_REGISTER) {
+    if (jit || tier)
+      fprintf(stderr, "[jit] register bytecode is interpreted; --jit and "
+                      "--tier have no effect.\n");
+    tier_stats = 0;
+    if (stats) {
+      stats_start(1);
+      atexit(stats_write);
+    }
+    if (prof_path && prof_start())
+      atexit(prof_write);
+    verify_register();
+    run_register();
+    goto cleanup;
+  }
+
+  static void *dispatch_table[] = {
+      [OP_HALT] = &&L_OP_HALT,
       [OP_CONST_INT] = &&L_OP_CONST_INT,
       [OP_CONST_FLOAT] = &&L_OP_CONST_FLOAT,
       [OP_CONST_STR] = &&L_OP_CONST_STR,
@@ -500,6 +3691,9 @@ int main(int argc, char **argv) {
       [OP_ALLOC_STRUCT] = &&L_OP_ALLOC_STRUCT,
       [OP_ALLOC_ARRAY] = &&L_OP_ALLOC_ARRAY,
       [OP_FREE] = &&L_OP_FREE,
+      [OP_FREE_STR] = &&L_OP_FREE_STR,
+      [OP_ARENA_BEGIN] = &&L_OP_ARENA_BEGIN,
+      [OP_ARENA_END] = &&L_OP_ARENA_END,
       [OP_GET_FIELD] = &&L_OP_GET_FIELD,
       [OP_SET_FIELD] = &&L_OP_SET_FIELD,
       [OP_GET_INDEX] = &&L_OP_GET_INDEX,
@@ -509,6 +3703,7 @@ int main(int argc, char **argv) {
       [OP_NEG] = &&L_OP_NEG,
       [OP_NEG_F] = &&L_OP_NEG_F,
       [OP_PRINT_FMT] = &&L_OP_PRINT_FMT,
+      [OP_PRINT_FMT_SEG] = &&L_OP_PRINT_FMT_SEG,
       [OP_TRY] = &&L_OP_TRY,
       [OP_END_TRY] = &&L_OP_END_TRY,
       [OP_THROW] = &&L_OP_THROW,
@@ -529,394 +3724,447 @@ int main(int argc, char **argv) {
       [OP_SHR] = &&L_OP_SHR,
       [OP_BIT_NOT] = &&L_OP_BIT_NOT,
       [OP_STR_CAT] = &&L_OP_STR_CAT,
+      [OP_STR_CAT_N] = &&L_OP_STR_CAT_N,
+      [OP_STRBUF_NEW] = &&L_OP_STRBUF_NEW,
+      [OP_STRBUF_APPEND] = &&L_OP_STRBUF_APPEND,
+      [OP_STRBUF_RESET] = &&L_OP_STRBUF_RESET,
+      [OP_STRBUF_STR] = &&L_OP_STRBUF_STR,
+      [OP_STRBUF_FREE] = &&L_OP_STRBUF_FREE,
       [OP_I2F] = &&L_OP_I2F,
       [OP_F2I] = &&L_OP_F2I,
       [OP_INT_TO_STR] = &&L_OP_INT_TO_STR,
       [OP_FLOAT_TO_STR] = &&L_OP_FLOAT_TO_STR,
       [OP_SWAP] = &&L_OP_SWAP,
+      [OP_LT_JZ] = &&L_OP_LT_JZ,
+      [OP_LE_JZ] = &&L_OP_LE_JZ,
+      [OP_GT_JZ] = &&L_OP_GT_JZ,
+      [OP_GE_JZ] = &&L_OP_GE_JZ,
+      [OP_EQ_JZ] = &&L_OP_EQ_JZ,
+      [OP_NE_JZ] = &&L_OP_NE_JZ,
+      [OP_LOCAL_CONST_LT_JZ] = &&L_OP_LOCAL_CONST_LT_JZ,
+      [OP_LOCAL_CONST_LE_JZ] = &&L_OP_LOCAL_CONST_LE_JZ,
+      [OP_LOCAL_CONST_GT_JZ] = &&L_OP_LOCAL_CONST_GT_JZ,
+      [OP_LOCAL_CONST_GE_JZ] = &&L_OP_LOCAL_CONST_GE_JZ,
+      [OP_LOCAL_CONST_EQ_JZ] = &&L_OP_LOCAL_CONST_EQ_JZ,
+      [OP_LOCAL_CONST_NE_JZ] = &&L_OP_LOCAL_CONST_NE_JZ,
+      [OP_LOCAL_LOCAL_LT_JZ] = &&L_OP_LOCAL_LOCAL_LT_JZ,
+      [OP_LOCAL_LOCAL_LE_JZ] = &&L_OP_LOCAL_LOCAL_LE_JZ,
+      [OP_LOCAL_LOCAL_GT_JZ] = &&L_OP_LOCAL_LOCAL_GT_JZ,
+      [OP_LOCAL_LOCAL_GE_JZ] = &&L_OP_LOCAL_LOCAL_GE_JZ,
+      [OP_LOCAL_LOCAL_EQ_JZ] = &&L_OP_LOCAL_LOCAL_EQ_JZ,
+      [OP_LOCAL_LOCAL_NE_JZ] = &&L_OP_LOCAL_LOCAL_NE_JZ,
+      [OP_INC_LOCAL] = &&L_OP_INC_LOCAL,
+      [OP_GET_LOCAL_FIELD] = &&L_OP_GET_LOCAL_FIELD,
+      [OP_GET_LOCAL2] = &&L_OP_GET_LOCAL2,
   };
 
-#define DISPATCH() goto *dispatch_table[code[ip++]]
+  // --- Interpreter registers ---
+  // The hot state lives in locals so the compiler can keep it in machine
+  // registers: pc is the current Cell, lsp and lfp shadow sp and fp, and
+  // `tos` caches the top of the value stack. The memory copy of the top slot,
+  // stack[lsp - 1], is stale; every slot below it is current. Slot 0 is a
+  // sentinel so the stack is never empty and a push can always write the old
+  // top back. SAVE_REGS() refreshes the globals before code that reads them:
+  // allocation tracking, natives, abyss_eye() and the error paths. The global
+  // ip keeps its bytecode-offset meaning (Abyss Eye shows it) and names the
+  // instruction after pc.
+  verify();
+  if (!verified) {
+    dispatch_table[OP_CONST_INT] = &&G_OP_CONST_INT;
+    dispatch_table[OP_CONST_FLOAT] = &&G_OP_CONST_FLOAT;
+    dispatch_table[OP_CONST_STR] = &&G_OP_CONST_STR;
+    dispatch_table[OP_GET_GLOBAL] = &&G_OP_GET_GLOBAL;
+    dispatch_table[OP_GET_LOCAL] = &&G_OP_GET_LOCAL;
+    dispatch_table[OP_ALLOC_STRUCT] = &&G_OP_ALLOC_STRUCT;
+    dispatch_table[OP_ALLOC_STACK] = &&G_OP_ALLOC_STACK;
+    dispatch_table[OP_NATIVE] = &&G_OP_NATIVE;
+    dispatch_table[OP_DUP] = &&G_OP_DUP;
+    dispatch_table[OP_STRBUF_NEW] = &&G_OP_STRBUF_NEW;
+    dispatch_table[OP_GET_LOCAL_FIELD] = &&G_OP_GET_LOCAL_FIELD;
+    dispatch_table[OP_GET_LOCAL2] = &&G_OP_GET_LOCAL2;
+  }
+  predecode(dispatch_table);
+  if (tier) {
+    if (!tier_init(&&L_TIER_ENTRY, &&L_TIER_BACKEDGE, &&L_JIT_ENTER)) {
+      fprintf(stderr, "[jit] unavailable on this platform; interpreting.\n");
+      tier = tier_stats = 0;
+    }
+  } else if (jit && !jit_compile(&&L_JIT_ENTER)) {
+    fprintf(stderr, "[jit] unavailable on this platform; interpreting.\n");
+  }
+  if (stats) {
+    stats_start(0);
+    atexit(stats_write);
+  }
+  if (prof_path && prof_start()) {
+    prof_cells = 1;
+    atexit(prof_write);
+  }
+  if (stats_hits || prof_log) {
+    stub_h = malloc((cell_count + 1) * sizeof(void *));
+    for (uint32_t i = 0; i <= cell_count; i++) {
+      stub_h[i] = cells[i].h;
+      cells[i].h = stats_hits ? &&L_STATS_STEP : &&L_PROF_STEP;
+    }
+  }
+  const Cell *pc = cells;
+  size_t lsp = 1, lfp = 0;
+  int64_t tos = 0;
+
+#define SAVE_REGS() (ip = cell_off[pc - cells + 1], sp = lsp, fp = lfp)
+#define SPILL_TOS() (stack[lsp - 1] = tos)
+#define FILL_TOS() (tos = stack[lsp - 1])
+  // v is evaluated after the old top is written back, so it may read any
+  // slot, including the one that was the top. There is no overflow check:
+  // OP_CALL reserved the frame's verified need, and unverified programs
+  // reach the pushing handlers through their G_ guards.
+#define PUSH(v)                                                                \
+  do {                                                                         \
+    SPILL_TOS();                                                               \
+    tos = (v);                                                                 \
+    lsp++;                                                                     \
+  } while (0)
+#define POP()                                                                  \
+  ({                                                                           \
+    int64_t v_ = tos;                                                          \
+    lsp--;                                                                     \
+    FILL_TOS();                                                                \
+    v_;                                                                        \
+  })
 
-  DISPATCH();
+#ifdef ABYSS_COUNT_DISPATCH
+  // Built by `make abyss_vm_count`: counts every dispatched instruction and
+  // reports the total on exit. Used by the bench_*.sh scripts.
+#define JUMP(target)                                                           \
+  do {                                                                         \
+    dispatch_count++;                                                          \
+    pc = (target);                                                             \
+    goto *pc->h;                                                               \
+  } while (0)
+#else
+#define JUMP(target)                                                           \
+  do {                                                                         \
+    pc = (target);                                                             \
+    goto *pc->h;                                                               \
+  } while (0)
+#endif
+#define DISPATCH() JUMP(pc + 1)
+
+  JUMP(cells);
 
 L_OP_HALT:
+  SAVE_REGS();
   goto cleanup;
 
-L_OP_CONST_INT: {
-  int32_t v;
-  memcpy(&v, code + ip, 4);
-  ip += 4;
-  push(v);
-  DISPATCH();
-}
-L_OP_CONST_FLOAT: {
-  int64_t v;
-  memcpy(&v, code + ip, 8);
-  ip += 8;
-  push(v);
-  DISPATCH();
-}
-L_OP_CONST_STR: {
-  uint32_t idx;
-  memcpy(&idx, code + ip, 4);
-  ip += 4;
-  push((int64_t)strs[idx]);
-  DISPATCH();
-}
-L_OP_ADD: {
-  stack[sp - 2] += stack[sp - 1];
-  sp--;
-  DISPATCH();
-}
-L_OP_SUB: {
-  stack[sp - 2] -= stack[sp - 1];
-  sp--;
-  DISPATCH();
-}
-L_OP_MUL: {
-  stack[sp - 2] *= stack[sp - 1];
-  sp--;
-  DISPATCH();
-}
-L_OP_DIV: {
-  stack[sp - 2] /= stack[sp - 1];
-  sp--;
-  DISPATCH();
-}
-L_OP_MOD: {
-  stack[sp - 2] %= stack[sp - 1];
-  sp--;
-  DISPATCH();
-}
-L_OP_NEG: {
-  stack[sp - 1] = -stack[sp - 1];
-  DISPATCH();
+  // Leader cell with compiled code (--jit): run it until it reaches an
+  // opcode it left to the interpreter, then dispatch that cell.
+L_JIT_ENTER: {
+  JitCtx ctx = {&stack[lsp], &stack[lfp], globals, tos, &stack[STACK_SIZE]};
+  uint32_t next = jit_enter(&ctx, jit_entry[pc - cells]);
+  if (__builtin_expect(next == JIT_OVERFLOW, 0))
+    fatal_stack_overflow();
+  lsp = (size_t)(ctx.sp - stack);
+  tos = ctx.tos;
+  JUMP(&cells[next]);
 }
 
-L_OP_ADD_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  a += b;
-  memcpy(&stack[sp - 1], &a, 8);
-  DISPATCH();
-}
-L_OP_SUB_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  a -= b;
-  memcpy(&stack[sp - 1], &a, 8);
-  DISPATCH();
-}
-L_OP_MUL_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  a *= b;
-  memcpy(&stack[sp - 1], &a, 8);
+  // Counted cells of a function still in tier 0 (--tier). tier_hit() may
+  // promote the function and returns the handler to continue with.
+L_TIER_ENTRY:
+  goto *tier_hit((uint32_t)(pc - cells), 0);
+L_TIER_BACKEDGE:
+  goto *tier_hit((uint32_t)(pc - cells), 1);
+
+  // Every cell while profiling (--prof): publish the address for
+  // prof_sample(), then run the cell's own handler. --stats counts too.
+L_PROF_STEP:
+  prof_pos = PROF_POS(cell_off[pc - cells], csp);
+  goto *stub_h[pc - cells];
+L_STATS_STEP:
+  stats_step(cell_off[pc - cells], code[cell_off[pc - cells]], csp);
+  goto *stub_h[pc - cells];
+
+  // Programs verify() could not follow check for room before every push.
+#define GUARD(op, n)                                                           \
+  G_##op : if (__builtin_expect(lsp + (n) > STACK_SIZE, 0)) {                  \
+    SAVE_REGS();                                                               \
+    fatal_stack_overflow();                                                    \
+  }                                                                            \
+  goto L_##op;
+  GUARD(OP_CONST_INT, 1)
+  GUARD(OP_CONST_FLOAT, 1)
+  GUARD(OP_CONST_STR, 1)
+  GUARD(OP_GET_GLOBAL, 1)
+  GUARD(OP_GET_LOCAL, 1)
+  GUARD(OP_ALLOC_STRUCT, 1)
+  GUARD(OP_ALLOC_STACK, 1)
+  GUARD(OP_NATIVE, 1)
+  GUARD(OP_DUP, 1)
+  GUARD(OP_STRBUF_NEW, 1)
+  GUARD(OP_GET_LOCAL_FIELD, 1)
+  GUARD(OP_GET_LOCAL2, 2)
+#undef GUARD
+
+L_OP_CONST_INT:
+L_OP_CONST_FLOAT:
+L_OP_CONST_STR:
+  PUSH(pc->a.k);
   DISPATCH();
-}
-L_OP_DIV_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  a /= b;
-  memcpy(&stack[sp - 1], &a, 8);
+
+  // Binary ops: a is the slot under the top, b the top; the result replaces
+  // both and stays in tos.
+#define BINOP(name, expr)                                                      \
+  name : {                                                                     \
+    int64_t a = stack[lsp - 2], b = tos;                                       \
+    tos = (expr);                                                              \
+    lsp--;                                                                     \
+    DISPATCH();                                                                \
+  }
+#define BINOP_F(name, type, expr)                                              \
+  name : {                                                                     \
+    double a, b;                                                               \
+    memcpy(&a, &stack[lsp - 2], 8);                                            \
+    memcpy(&b, &tos, 8);                                                       \
+    type r = (expr);                                                           \
+    if (sizeof(type) == 8)                                                     \
+      memcpy(&tos, &r, 8);                                                     \
+    else                                                                       \
+      tos = r;                                                                 \
+    lsp--;                                                                     \
+    DISPATCH();                                                                \
+  }
+
+  BINOP(L_OP_ADD, a + b)
+  BINOP(L_OP_SUB, a - b)
+  BINOP(L_OP_MUL, a * b)
+  BINOP(L_OP_DIV, a / b)
+  BINOP(L_OP_MOD, a % b)
+  BINOP(L_OP_LT, a < b)
+  BINOP(L_OP_LE, a <= b)
+  BINOP(L_OP_GT, a > b)
+  BINOP(L_OP_GE, a >= b)
+  BINOP(L_OP_EQ, a == b)
+  BINOP(L_OP_NE, a != b)
+  BINOP(L_OP_AND, a && b)
+  BINOP(L_OP_OR, a || b)
+  BINOP(L_OP_BIT_AND, a & b)
+  BINOP(L_OP_BIT_OR, a | b)
+  BINOP(L_OP_BIT_XOR, a ^ b)
+  BINOP(L_OP_SHL, a << b)
+  BINOP(L_OP_SHR, a >> b)
+  BINOP_F(L_OP_ADD_F, double, a + b)
+  BINOP_F(L_OP_SUB_F, double, a - b)
+  BINOP_F(L_OP_MUL_F, double, a * b)
+  BINOP_F(L_OP_DIV_F, double, a / b)
+  BINOP_F(L_OP_LT_F, int, a < b)
+  BINOP_F(L_OP_LE_F, int, a <= b)
+  BINOP_F(L_OP_GT_F, int, a > b)
+  BINOP_F(L_OP_GE_F, int, a >= b)
+  BINOP_F(L_OP_EQ_F, int, a == b)
+  BINOP_F(L_OP_NE_F, int, a != b)
+#undef BINOP
+#undef BINOP_F
+
+L_OP_NEG: {
+  tos = -tos;
   DISPATCH();
 }
 L_OP_NEG_F: {
   double a;
-  memcpy(&a, &stack[sp - 1], 8);
+  memcpy(&a, &tos, 8);
   a = -a;
-  memcpy(&stack[sp - 1], &a, 8);
+  memcpy(&tos, &a, 8);
   DISPATCH();
 }
-
-L_OP_LT: {
-  stack[sp - 2] = (stack[sp - 2] < stack[sp - 1]);
-  sp--;
-  DISPATCH();
-}
-L_OP_LE: {
-  stack[sp - 2] = (stack[sp - 2] <= stack[sp - 1]);
-  sp--;
-  DISPATCH();
-}
-L_OP_GT: {
-  stack[sp - 2] = (stack[sp - 2] > stack[sp - 1]);
-  sp--;
-  DISPATCH();
-}
-L_OP_GE: {
-  stack[sp - 2] = (stack[sp - 2] >= stack[sp - 1]);
-  sp--;
-  DISPATCH();
-}
-L_OP_EQ: {
-  stack[sp - 2] = (stack[sp - 2] == stack[sp - 1]);
-  sp--;
-  DISPATCH();
-}
-L_OP_NE: {
-  stack[sp - 2] = (stack[sp - 2] != stack[sp - 1]);
-  sp--;
-  DISPATCH();
-}
-
-L_OP_LT_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  stack[sp - 1] = (a < b);
-  DISPATCH();
-}
-L_OP_LE_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  stack[sp - 1] = (a <= b);
-  DISPATCH();
-}
-L_OP_GT_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  stack[sp - 1] = (a > b);
-  DISPATCH();
-}
-L_OP_GE_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  stack[sp - 1] = (a >= b);
-  DISPATCH();
-}
-L_OP_EQ_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  stack[sp - 1] = (a == b);
+L_OP_NOT: {
+  tos = !tos;
   DISPATCH();
 }
-L_OP_NE_F: {
-  double a, b;
-  memcpy(&b, &stack[--sp], 8);
-  memcpy(&a, &stack[sp - 1], 8);
-  stack[sp - 1] = (a != b);
+L_OP_BIT_NOT: {
+  tos = ~tos;
   DISPATCH();
 }
 
-L_OP_JMP: {
-  uint32_t t;
-  memcpy(&t, code + ip, 4);
-  ip = t;
+L_OP_JMP:
+  JUMP(pc->a.t);
+L_OP_JZ:
+  if (!POP())
+    JUMP(pc->a.t);
   DISPATCH();
-}
-L_OP_JZ: {
-  uint32_t t;
-  memcpy(&t, code + ip, 4);
-  ip += 4;
-  if (!pop())
-    ip = t;
-  DISPATCH();
-}
 
 L_OP_PRINT: {
-  printf("%ld\n", pop());
+  out_int(POP());
+  out_char('\n');
   DISPATCH();
 }
 L_OP_PRINT_F: {
   double v;
-  int64_t iv = pop();
+  int64_t iv = POP();
   memcpy(&v, &iv, 8);
-  printf("%.6f\n", v);
+  out_float(v);
+  out_char('\n');
   DISPATCH();
 }
 L_OP_PRINT_CHAR: {
-  printf("%c", (char)pop());
+  out_char((char)POP());
   DISPATCH();
 }
 L_OP_PRINT_STR: {
-  printf("%s\n", (char *)pop());
+  out_lstr((char *)POP());
+  out_char('\n');
   DISPATCH();
 }
 L_OP_PRINT_FMT: {
-  uint8_t argc = code[ip++];
-  int64_t fmt_ptr = stack[sp - 1 - argc];
-  char *fmt = (char *)fmt_ptr;
-  int current_arg = 0;
-  for (int i = 0; fmt[i]; i++) {
-    if (fmt[i] == '%') {
-      i++;
-      if (fmt[i] == '{')
-        i++;
-      char type_buf[32];
-      int ti = 0;
-      while (fmt[i] && isalpha(fmt[i]) && ti < 31)
-        type_buf[ti++] = fmt[i++];
-      type_buf[ti] = 0;
-      if (fmt[i] == '}')
-        i++;
-      else
-        i--;
-      if (current_arg < argc) {
-        int64_t val = stack[sp - argc + current_arg];
-        if (!strcmp(type_buf, "int") || !strcmp(type_buf, "integer"))
-          printf("%ld", val);
-        else if (!strcmp(type_buf, "float")) {
-          double f;
-          memcpy(&f, &val, 8);
-          printf("%.6f", f);
-        } else if (!strcmp(type_buf, "str") || !strcmp(type_buf, "string"))
-          printf("%s", (char *)val);
-        else if (!strcmp(type_buf, "char"))
-          printf("%c", (char)val);
-        current_arg++;
-      }
-    } else
-      putchar(fmt[i]);
-  }
-  printf("\n");
-  sp -= (argc + 1);
+  uint32_t argc = pc->b;
+  SPILL_TOS();
+  print_fmt((char *)stack[lsp - 1 - argc], &stack[lsp - argc], argc);
+  lsp -= (argc + 1);
+  FILL_TOS();
+  DISPATCH();
+}
+L_OP_PRINT_FMT_SEG: {
+  SPILL_TOS();
+  print_segs(pc->a.f, &stack[lsp - pc->b]);
+  lsp -= pc->b;
+  FILL_TOS();
   DISPATCH();
 }
 
 L_OP_GET_GLOBAL: {
-  push(globals[code[ip++]]);
+  PUSH(globals[pc->b]);
   DISPATCH();
 }
 L_OP_SET_GLOBAL: {
-  globals[code[ip++]] = pop();
+  globals[pc->b] = POP();
   DISPATCH();
 }
 L_OP_GET_LOCAL: {
-  push(stack[fp + code[ip++]]);
+  PUSH(stack[lfp + pc->b]);
   DISPATCH();
 }
 L_OP_SET_LOCAL: {
-  stack[fp + code[ip++]] = pop();
+  // Store first: if the local is the new top, the fill picks it up.
+  stack[lfp + pc->b] = tos;
+  lsp--;
+  FILL_TOS();
   DISPATCH();
 }
 
 L_OP_CALL: {
-  uint32_t addr;
-  memcpy(&addr, code + ip, 4);
-  ip += 4;
-  uint8_t argc = code[ip++];
+  // Frame-level guards: pc->c is the callee's frame need (0 if unverified).
   if (__builtin_expect(csp >= CALL_STACK_SIZE, 0)) {
-    fprintf(stderr,
-            "\033[1;31m[FATAL ERROR]\033[0m Call stack overflow (limit %d "
-            "frames).\n",
-            CALL_STACK_SIZE);
-    fprintf(
-        stderr,
-        "  This usually means unbounded recursion. Check your base cases.\n");
-    exit(1);
+    SAVE_REGS();
+    fatal_call_overflow();
+  }
+  if (__builtin_expect(lsp - pc->b + (uint32_t)pc->c > STACK_SIZE, 0)) {
+    SAVE_REGS();
+    fatal_stack_overflow();
   }
-  call_stack[csp].ret_addr = ip;
-  call_stack[csp].old_fp = fp;
+  SPILL_TOS(); // the callee reads its arguments from memory
+  call_stack[csp] = (Frame){(size_t)(pc + 1 - cells), lfp, arena_top};
   csp++;
-  fp = sp - argc;
-  ip = addr;
-  DISPATCH();
+  lfp = lsp - pc->b;
+  JUMP(pc->a.t);
 }
 L_OP_RET: {
-  uint8_t count = code[ip++];
-  int64_t rets[8];
-  for (int i = 0; i < count; i++)
-    rets[i] = pop();
-  free_stack_allocs(fp);
+  uint32_t count = pc->b;
+  SPILL_TOS();
+  SAVE_REGS();
   if (csp == 0)
     goto cleanup;
   csp--;
-  ip = call_stack[csp].ret_addr;
-  size_t old_fp = call_stack[csp].old_fp;
-  sp = fp;
-  fp = old_fp;
-  for (int i = count - 1; i >= 0; i--)
-    push(rets[i]);
-  DISPATCH();
+  drop_handlers();
+  arena_release(call_stack[csp].arena_mark);
+  memmove(&stack[lfp], &stack[lsp - count], count * sizeof(int64_t));
+  lsp = lfp + count;
+  lfp = call_stack[csp].old_fp;
+  FILL_TOS();
+  JUMP(&cells[call_stack[csp].ret_addr]);
 }
 L_OP_POP: {
-  sp--;
+  lsp--;
+  FILL_TOS();
   DISPATCH();
 }
 
 L_OP_ALLOC_STRUCT: {
-  uint32_t sid, cidx;
-  memcpy(&sid, code + ip, 4);
-  ip += 4;
-  memcpy(&cidx, code + ip, 4);
-  ip += 4;
-  char *comment = (cidx == 0xFFFFFFFF) ? NULL : strs[cidx];
-
-  uint32_t size = structs[sid].size * 8;
-  int64_t *ptr = malloc(size);
-  memset(ptr, 0, size);
-  track_alloc(ptr, sid, size, 0, comment);
-  push((int64_t)ptr);
+  uint32_t size = structs[pc->b].size * 8;
+  int64_t *ptr = heap_alloc(size);
+  SAVE_REGS();
+  track_alloc(ptr, pc->b, size, 0, pc->a.s);
+  PUSH((int64_t)ptr);
   DISPATCH();
 }
 L_OP_ALLOC_ARRAY: {
-  uint32_t elem_size, cidx;
-  memcpy(&elem_size, code + ip, 4);
-  ip += 4;
-  memcpy(&cidx, code + ip, 4);
-  ip += 4;
-  char *comment = (cidx == 0xFFFFFFFF) ? NULL : strs[cidx];
-
-  int64_t count = pop();
+  int64_t count = tos;
   uint32_t total_size = count * 8;
-  int64_t *ptr = malloc(total_size);
-  memset(ptr, 0, total_size);
-  track_alloc(ptr, 0xFFFFFFFF, total_size, 0, comment);
-  push((int64_t)ptr);
+  int64_t *ptr = heap_alloc(total_size);
+  SAVE_REGS();
+  track_alloc(ptr, 0xFFFFFFFF, total_size, 0, pc->a.s);
+  tos = (int64_t)ptr;
   DISPATCH();
 }
 L_OP_FREE: {
-  int64_t *ptr = (int64_t *)pop();
-  untrack_alloc(ptr);
-  free(ptr);
+  int64_t *ptr = (int64_t *)POP();
+  SAVE_REGS();
+  free_alloc(ptr);
+  DISPATCH();
+}
+L_OP_FREE_STR: {
+  char *str = (char *)POP();
+  SAVE_REGS();
+  free_str(str);
+  DISPATCH();
+}
+L_OP_ARENA_BEGIN: {
+  SAVE_REGS();
+  region_begin();
+  DISPATCH();
+}
+L_OP_ARENA_END: {
+  SAVE_REGS();
+  if (region_depth > 0)
+    region_release(region_depth - 1);
   DISPATCH();
 }
 L_OP_GET_FIELD: {
-  uint8_t offset = code[ip++];
-  int64_t *ptr = (int64_t *)pop();
-  push(ptr[offset]);
+  tos = ((int64_t *)tos)[pc->b];
   DISPATCH();
 }
 L_OP_SET_FIELD: {
-  uint8_t offset = code[ip++];
-  int64_t val = pop();
-  int64_t *ptr = (int64_t *)pop();
-  ptr[offset] = val;
+  ((int64_t *)stack[lsp - 2])[pc->b] = tos;
+  lsp -= 2;
+  FILL_TOS();
   DISPATCH();
 }
 L_OP_GET_INDEX: {
-  int64_t idx = pop();
-  int64_t *ptr = (int64_t *)pop();
-  push(ptr[idx]);
+  int64_t *ptr = (int64_t *)stack[lsp - 2];
+  tos = ptr[tos];
+  lsp--;
   DISPATCH();
 }
 L_OP_SET_INDEX: {
-  int64_t val = pop();
-  int64_t idx = pop();
-  int64_t *ptr = (int64_t *)pop();
-  ptr[idx] = val;
+  int64_t *ptr = (int64_t *)stack[lsp - 3];
+  ptr[stack[lsp - 2]] = tos;
+  lsp -= 3;
+  FILL_TOS();
   DISPATCH();
 }
 L_OP_ABYSS_EYE: {
+  SAVE_REGS();
   abyss_eye();
   DISPATCH();
 }
 
 L_OP_TRY: {
-  uint32_t catch_addr;
-  memcpy(&catch_addr, code + ip, 4);
-  ip += 4;
-  exception_stack[esp++] = (ExceptionFrame){catch_addr, sp, fp, csp};
+  if (__builtin_expect(esp >= EXCEPTION_STACK_SIZE, 0)) {
+    SAVE_REGS();
+    fatal_handler_overflow();
+  }
+  // A throw restores lsp and expects every slot below it in memory.
+  SPILL_TOS();
+  exception_stack[esp++] =
+      (ExceptionFrame){(size_t)(pc->a.t - cells), lsp, lfp, csp, region_depth};
   DISPATCH();
 }
 L_OP_END_TRY: {
@@ -925,212 +4173,282 @@ L_OP_END_TRY: {
   DISPATCH();
 }
 L_OP_THROW: {
-  int64_t err_val = pop();
+  int64_t err_val = tos;
+  SAVE_REGS();
   if (esp == 0) {
     fprintf(stderr, "Uncaught Exception: %s\n", (char *)err_val);
     exit(1);
   }
   esp--;
-  ip = exception_stack[esp].catch_addr;
-  sp = exception_stack[esp].old_sp;
-  fp = exception_stack[esp].old_fp;
+  if (csp > exception_stack[esp].old_csp)
+    arena_release(call_stack[exception_stack[esp].old_csp].arena_mark);
+  if (region_depth > exception_stack[esp].old_regions)
+    region_release(exception_stack[esp].old_regions);
+  lsp = exception_stack[esp].old_sp;
+  lfp = exception_stack[esp].old_fp;
   csp = exception_stack[esp].old_csp;
-  push(err_val);
-  DISPATCH();
+  // The old top is already in memory (OP_TRY spilled it); push without
+  // writing tos back.
+  tos = err_val;
+  lsp++;
+  JUMP(&cells[exception_stack[esp].catch_addr]);
 }
 
 L_OP_NATIVE: {
-  uint32_t nid;
-  memcpy(&nid, code + ip, 4);
-  ip += 4;
-  if (nid == 0) { // clock
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    double t = ts.tv_sec + ts.tv_nsec / 1e9;
-    int64_t v;
-    memcpy(&v, &t, 8);
-    push(v);
-  } else if (nid == 1) { // input_int
-    char buf[64];
-    int64_t v = 0;
-    if (fgets(buf, sizeof(buf), stdin))
-      v = atoll(buf);
-    push(v);
-  }
+  int64_t v;
+  SAVE_REGS();
+  if (call_native(pc->b, &v))
+    PUSH(v);
   DISPATCH();
 }
 L_OP_DUP: {
-  push(stack[sp - 1]);
+  PUSH(tos);
   DISPATCH();
 }
 L_OP_ALLOC_STACK: {
-  uint32_t sid, cidx;
-  memcpy(&sid, code + ip, 4);
-  ip += 4;
-  memcpy(&cidx, code + ip, 4);
-  ip += 4;
-  char *comment = (cidx == 0xFFFFFFFF) ? NULL : strs[cidx];
-
-  uint32_t size = structs[sid].size * 8;
-  int64_t *ptr = malloc(size);
-  memset(ptr, 0, size);
-  track_alloc(ptr, sid, size, 1, comment);
-  push((int64_t)ptr);
+  uint32_t size = structs[pc->b].size * 8;
+  SAVE_REGS();
+  int64_t *ptr = arena_alloc(size);
+  track_alloc(ptr, pc->b, size, 1, pc->a.s);
+  PUSH((int64_t)ptr);
   DISPATCH();
 }
 L_OP_INC_INDEX: {
-  int64_t idx = pop();
-  int64_t *ptr = (int64_t *)pop();
-  ptr[idx]++;
+  ((int64_t *)stack[lsp - 2])[tos]++;
+  lsp -= 2;
+  FILL_TOS();
   DISPATCH();
 }
 L_OP_DEC_INDEX: {
-  int64_t idx = pop();
-  int64_t *ptr = (int64_t *)pop();
-  ptr[idx]--;
+  ((int64_t *)stack[lsp - 2])[tos]--;
+  lsp -= 2;
+  FILL_TOS();
   DISPATCH();
 }
 L_OP_CALL_DYN_BOT: {
-  uint8_t argc = code[ip++];
-  uint32_t addr = (uint32_t)stack[sp - argc - 1];
+  uint32_t argc = pc->b;
+  SPILL_TOS();
+  uint32_t addr = (uint32_t)stack[lsp - argc - 1];
 
-  for (int i = 0; i < argc; i++) {
-    stack[sp - argc - 1 + i] = stack[sp - argc + i];
+  for (uint32_t i = 0; i < argc; i++) {
+    stack[lsp - argc - 1 + i] = stack[lsp - argc + i];
   }
-  sp--;
+  lsp--;
+  FILL_TOS();
 
-  call_stack[csp].ret_addr = ip;
-  call_stack[csp].old_fp = fp;
-  csp++;
-  fp = sp - argc;
-  ip = addr;
-  DISPATCH();
-}
-L_OP_TAG_ALLOC: {
-  uint32_t str_idx;
-  memcpy(&str_idx, code + ip, 4);
-  ip += 4;
-
-  int64_t ptr_val = stack[sp - 1];
-
-  AllocInfo *curr = alloc_head;
-  while (curr) {
-    if ((int64_t)curr->ptr == ptr_val && !curr->is_freed) {
-      curr->tag = strs[str_idx];
-      break;
+  // The callee address is a bytecode offset computed at run time, so a
+  // verified program checks here that it is a function taking argc values
+  // and returning the count verify() assumed, and that its frame fits.
+  if (__builtin_expect(csp >= CALL_STACK_SIZE, 0)) {
+    SAVE_REGS();
+    fatal_call_overflow();
+  }
+  if (verified) {
+    int32_t f = addr < code_size ? func_at[addr] : -1;
+    if (f < 0 || funcs[f].argc != argc || funcs[f].rets != (uint32_t)pc->c) {
+      SAVE_REGS();
+      fatal_bad_code("interface call target", cell_off[pc - cells], addr);
+    }
+    if (__builtin_expect(lsp - argc + frame_need[f] > STACK_SIZE, 0)) {
+      SAVE_REGS();
+      fatal_stack_overflow();
     }
-    curr = curr->next;
   }
-  DISPATCH();
-}
-L_OP_AND: {
-  stack[sp - 2] = stack[sp - 2] && stack[sp - 1];
-  sp--;
-  DISPATCH();
-}
-L_OP_OR: {
-  stack[sp - 2] = stack[sp - 2] || stack[sp - 1];
-  sp--;
-  DISPATCH();
+  call_stack[csp] = (Frame){(size_t)(pc + 1 - cells), lfp, arena_top};
+  csp++;
+  lfp = lsp - argc;
+  JUMP(&cells[addr <= code_size ? cell_at[addr] : cell_count]);
 }
-L_OP_NOT: {
-  stack[sp - 1] = !stack[sp - 1];
+L_OP_TAG_ALLOC:
+  tag_alloc((void *)tos, pc->a.s);
   DISPATCH();
-}
-L_OP_BIT_AND: {
-  stack[sp - 2] &= stack[sp - 1];
-  sp--;
+L_OP_STR_CAT: {
+  char *s2 = (char *)tos;
+  char *s1 = (char *)stack[lsp - 2];
+  uint32_t len1 = str_len(s1);
+  uint32_t len2 = str_len(s2);
+  char *new_str = str_alloc((size_t)len1 + len2);
+  memcpy(new_str, s1, len1);
+  memcpy(new_str + len1, s2, len2);
+
+  // 0xFFFFFFFE is our special ID for Dynamic Strings in Abyss Eye
+  SAVE_REGS();
+  track_alloc(new_str, 0xFFFFFFFE, len1 + len2 + 1, 0, "Dynamic String Concat");
+  tos = (int64_t)new_str;
+  lsp--;
   DISPATCH();
 }
-L_OP_BIT_OR: {
-  stack[sp - 2] |= stack[sp - 1];
-  sp--;
+L_OP_STR_CAT_N: {
+  // The parts are the top pc->b slots; the result replaces them.
+  SPILL_TOS();
+  SAVE_REGS();
+  tos = (int64_t)str_cat_n(&stack[lsp - pc->b], pc->b, (uint32_t)pc->c);
+  lsp -= pc->b - 1;
   DISPATCH();
 }
-L_OP_BIT_XOR: {
-  stack[sp - 2] ^= stack[sp - 1];
-  sp--;
+L_OP_STRBUF_NEW:
+  PUSH((int64_t)calloc(1, sizeof(StrBuf)));
   DISPATCH();
-}
-L_OP_SHL: {
-  stack[sp - 2] <<= stack[sp - 1];
-  sp--;
+L_OP_STRBUF_APPEND: {
+  int64_t v = POP();
+  StrBuf *b = (StrBuf *)POP();
+  SAVE_REGS();
+  strbuf_append(b, pc->b, v);
   DISPATCH();
 }
-L_OP_SHR: {
-  stack[sp - 2] >>= stack[sp - 1];
-  sp--;
+L_OP_STRBUF_RESET:
+  ((StrBuf *)POP())->len = 0;
   DISPATCH();
-}
-L_OP_BIT_NOT: {
-  stack[sp - 1] = ~stack[sp - 1];
+L_OP_STRBUF_STR:
+  SAVE_REGS();
+  tos = (int64_t)strbuf_str((StrBuf *)tos);
   DISPATCH();
-}
-L_OP_STR_CAT: {
-  char *s2 = (char *)pop();
-  char *s1 = (char *)pop();
-  size_t len1 = strlen(s1);
-  size_t len2 = strlen(s2);
-  char *new_str = malloc(len1 + len2 + 1);
-  strcpy(new_str, s1);
-  strcat(new_str, s2);
-
-  // 0xFFFFFFFE is our special ID for Dynamic Strings in Abyss Eye
-  track_alloc(new_str, 0xFFFFFFFE, len1 + len2 + 1, 0, "Dynamic String Concat");
-  push((int64_t)new_str);
+L_OP_STRBUF_FREE: {
+  StrBuf *b = (StrBuf *)POP();
+  SAVE_REGS();
+  strbuf_free(b);
   DISPATCH();
 }
 
 L_OP_I2F: {
   // Convert int at top of stack to float (value-preserving).
-  double f = (double)stack[sp - 1];
-  memcpy(&stack[sp - 1], &f, 8);
+  double f = (double)tos;
+  memcpy(&tos, &f, 8);
   DISPATCH();
 }
 L_OP_F2I: {
   // Convert float at top of stack to int (truncation).
   double f;
-  memcpy(&f, &stack[sp - 1], 8);
-  stack[sp - 1] = (int64_t)f;
+  memcpy(&f, &tos, 8);
+  tos = (int64_t)f;
   DISPATCH();
 }
 L_OP_INT_TO_STR: {
-  int64_t v = pop();
   char buf[32];
-  int n = snprintf(buf, sizeof(buf), "%ld", (long)v);
-  char *s = malloc(n + 1);
-  memcpy(s, buf, n + 1);
+  int n = snprintf(buf, sizeof(buf), "%ld", (long)tos);
+  char *s = str_alloc(n);
+  memcpy(s, buf, n);
+  SAVE_REGS();
   track_alloc(s, 0xFFFFFFFE, n + 1, 0, "int->str");
-  push((int64_t)s);
+  tos = (int64_t)s;
   DISPATCH();
 }
 L_OP_FLOAT_TO_STR: {
   double f;
-  int64_t iv = pop();
-  memcpy(&f, &iv, 8);
+  memcpy(&f, &tos, 8);
   char buf[64];
   int n = snprintf(buf, sizeof(buf), "%.6f", f);
-  char *s = malloc(n + 1);
-  memcpy(s, buf, n + 1);
+  char *s = str_alloc(n);
+  memcpy(s, buf, n);
+  SAVE_REGS();
   track_alloc(s, 0xFFFFFFFE, n + 1, 0, "float->str");
-  push((int64_t)s);
+  tos = (int64_t)s;
   DISPATCH();
 }
 L_OP_SWAP: {
   // Swap top two stack slots.
-  int64_t tmp = stack[sp - 1];
-  stack[sp - 1] = stack[sp - 2];
-  stack[sp - 2] = tmp;
+  int64_t tmp = stack[lsp - 2];
+  stack[lsp - 2] = tos;
+  tos = tmp;
+  DISPATCH();
+}
+
+  // --- Superinstructions ---
+  // Each one behaves exactly like the sequence it replaces (see common.h) but
+  // skips the intermediate pushes, pops and dispatches. The ones that read a
+  // local spill tos first, since the local may be the top slot.
+#define CMP_JZ(name, cmp)                                                      \
+  name : {                                                                     \
+    int64_t a = stack[lsp - 2], b = tos;                                       \
+    lsp -= 2;                                                                  \
+    FILL_TOS();                                                                \
+    if (!(a cmp b))                                                            \
+      JUMP(pc->a.t);                                                           \
+    DISPATCH();                                                                \
+  }
+#define LOCAL_CONST_CMP_JZ(name, cmp)                                          \
+  name : {                                                                     \
+    SPILL_TOS();                                                               \
+    if (!(stack[lfp + pc->b] cmp pc->c))                                       \
+      JUMP(pc->a.t);                                                           \
+    DISPATCH();                                                                \
+  }
+#define LOCAL_LOCAL_CMP_JZ(name, cmp)                                          \
+  name : {                                                                     \
+    SPILL_TOS();                                                               \
+    if (!(stack[lfp + pc->b] cmp stack[lfp + pc->c]))                          \
+      JUMP(pc->a.t);                                                           \
+    DISPATCH();                                                                \
+  }
+
+  CMP_JZ(L_OP_LT_JZ, <)
+  CMP_JZ(L_OP_LE_JZ, <=)
+  CMP_JZ(L_OP_GT_JZ, >)
+  CMP_JZ(L_OP_GE_JZ, >=)
+  CMP_JZ(L_OP_EQ_JZ, ==)
+  CMP_JZ(L_OP_NE_JZ, !=)
+  LOCAL_CONST_CMP_JZ(L_OP_LOCAL_CONST_LT_JZ, <)
+  LOCAL_CONST_CMP_JZ(L_OP_LOCAL_CONST_LE_JZ, <=)
+  LOCAL_CONST_CMP_JZ(L_OP_LOCAL_CONST_GT_JZ, >)
+  LOCAL_CONST_CMP_JZ(L_OP_LOCAL_CONST_GE_JZ, >=)
+  LOCAL_CONST_CMP_JZ(L_OP_LOCAL_CONST_EQ_JZ, ==)
+  LOCAL_CONST_CMP_JZ(L_OP_LOCAL_CONST_NE_JZ, !=)
+  LOCAL_LOCAL_CMP_JZ(L_OP_LOCAL_LOCAL_LT_JZ, <)
+  LOCAL_LOCAL_CMP_JZ(L_OP_LOCAL_LOCAL_LE_JZ, <=)
+  LOCAL_LOCAL_CMP_JZ(L_OP_LOCAL_LOCAL_GT_JZ, >)
+  LOCAL_LOCAL_CMP_JZ(L_OP_LOCAL_LOCAL_GE_JZ, >=)
+  LOCAL_LOCAL_CMP_JZ(L_OP_LOCAL_LOCAL_EQ_JZ, ==)
+  LOCAL_LOCAL_CMP_JZ(L_OP_LOCAL_LOCAL_NE_JZ, !=)
+#undef CMP_JZ
+#undef LOCAL_CONST_CMP_JZ
+#undef LOCAL_LOCAL_CMP_JZ
+
+L_OP_INC_LOCAL: {
+  size_t slot = lfp + pc->b;
+  if (slot == lsp - 1)
+    tos += pc->c;
+  else
+    stack[slot] += pc->c;
   DISPATCH();
 }
+L_OP_GET_LOCAL_FIELD:
+  PUSH(((int64_t *)stack[lfp + pc->b])[pc->c]);
+  DISPATCH();
+L_OP_GET_LOCAL2:
+  PUSH(stack[lfp + pc->b]);
+  PUSH(stack[lfp + pc->c]);
+  DISPATCH();
+#undef PUSH
+#undef POP
+#undef SPILL_TOS
+#undef FILL_TOS
+#undef SAVE_REGS
+#undef DISPATCH
+#undef JUMP
 
 cleanup:
-  free(code);
-  for (uint32_t i = 0; i < str_count; i++)
-    free(strs[i]);
-  free(strs);
-  for (uint32_t i = 0; i < struct_count; i++)
-    free(structs[i].name);
-  free(structs);
+#ifdef ABYSS_COUNT_DISPATCH
+  fprintf(stderr, "[dispatch] %lu instructions dispatched\n", dispatch_count);
+#endif
+  prof_write();
+  stats_write();
+  if (tier_stats)
+    tier_report();
+  jit_release();
+  free(jit_funcs);
+  free(tier_h);
+  free(tier_fn);
+  free(stub_h);
+  free(func_order);
+  free(cells);
+  free(cell_at);
+  free(cell_off);
+  free(jit_entry);
+  free(func_at);
+  free(frame_need);
+  free(allocs);
+  free(live);
+  free(stack_allocs);
+  munmap((void *)image, image_size);
   return 0;
 }